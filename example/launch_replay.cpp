@@ -0,0 +1,60 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Replays a launch log written by a posix::launch_recorder against itself as the stub:
+//
+//    launch_replay <log> [speed]
+
+#include <boost/process/v2/ext/exe.hpp>
+#include <boost/process/v2/pid.hpp>
+#include <boost/process/v2/posix/launch_record.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace bpv = boost::process::v2;
+
+namespace
+{
+
+void print(const char * name, const bpv::posix::histogram_snapshot & hist)
+{
+  std::cout << name << ": n=" << hist.count
+            << " p50=" << hist.percentile(50.) / 1000u << "us"
+            << " p90=" << hist.percentile(90.) / 1000u << "us"
+            << " p99=" << hist.percentile(99.) / 1000u << "us"
+            << " max=" << hist.max / 1000u << "us" << std::endl;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1 && std::strcmp(argv[1], "--stub") == 0)
+    return bpv::posix::replay_stub_main(argc - 1, argv + 1);
+
+  if (argc < 2)
+  {
+    std::cerr << "usage: " << argv[0] << " <log> [speed]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const auto records = bpv::posix::read_launch_records(argv[1]);
+
+  bpv::posix::replay_options options;
+  if (argc > 2)
+    options.speed = std::atof(argv[2]);
+  options.stub_args = {"--stub"};
+
+  const auto report = bpv::posix::replay_launches(records, bpv::ext::exe(bpv::current_pid()), options);
+  std::cout << "replayed " << report.launches << " launches in " << report.elapsed / 1000000u << "ms, "
+            << report.failures << " failed, " << report.skipped << " skipped, "
+            << report.unmatched << " without a recorded exit" << std::endl;
+  print("launch latency", report.launch_latency);
+  print("reaper lag    ", report.reaper_lag);
+  print("fork          ", report.phases[bpv::posix::launch_phase::fork]);
+  return EXIT_SUCCESS;
+}
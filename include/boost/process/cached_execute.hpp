@@ -0,0 +1 @@
+#include <boost/process/v2/cached_execute.hpp>
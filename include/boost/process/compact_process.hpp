@@ -0,0 +1 @@
+#include <boost/process/v2/compact_process.hpp>
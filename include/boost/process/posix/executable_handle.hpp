@@ -0,0 +1 @@
+#include <boost/process/v2/posix/executable_handle.hpp>
@@ -0,0 +1 @@
+#include <boost/process/v2/posix/launch_trace.hpp>
@@ -0,0 +1 @@
+#include <boost/process/v2/posix/response_file.hpp>
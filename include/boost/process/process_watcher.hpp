@@ -0,0 +1 @@
+#include <boost/process/v2/process_watcher.hpp>
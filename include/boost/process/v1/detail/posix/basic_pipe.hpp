@@ -17,6 +17,7 @@
 #include <array>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 #include <memory>
 
 namespace boost { namespace process { BOOST_PROCESS_V1_INLINE namespace v1 { namespace detail { namespace posix {
@@ -101,6 +102,44 @@ public:
         }
         return static_cast<int_type>(read_len);
     }
+    ///Write two buffers with a single system call (writev), e.g. the pending buffer and the user data.
+    int_type write(const char_type * data1, int_type count1, const char_type * data2, int_type count2)
+    {
+        ::iovec iov[2];
+        iov[0].iov_base = const_cast<char_type*>(data1);
+        iov[0].iov_len  = count1 * sizeof(char_type);
+        iov[1].iov_base = const_cast<char_type*>(data2);
+        iov[1].iov_len  = count2 * sizeof(char_type);
+
+        ssize_t write_len;
+        while ((write_len = ::writev(_sink, iov, 2)) == -1)
+        {
+            //Try again if interrupted
+            auto err = errno;
+            if (err != EINTR)
+                ::boost::process::v1::detail::throw_last_error();
+        }
+        return static_cast<int_type>(write_len);
+    }
+    ///Read into two buffers with a single system call (readv), e.g. the user buffer and the internal buffer.
+    int_type read(char_type * data1, int_type count1, char_type * data2, int_type count2)
+    {
+        ::iovec iov[2];
+        iov[0].iov_base = data1;
+        iov[0].iov_len  = count1 * sizeof(char_type);
+        iov[1].iov_base = data2;
+        iov[1].iov_len  = count2 * sizeof(char_type);
+
+        ssize_t read_len;
+        while ((read_len = ::readv(_source, iov, 2)) == -1)
+        {
+            //Try again if interrupted
+            auto err = errno;
+            if (err != EINTR)
+                ::boost::process::v1::detail::throw_last_error();
+        }
+        return static_cast<int_type>(read_len);
+    }
 
     bool is_open() const
     {
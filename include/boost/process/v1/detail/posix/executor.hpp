@@ -28,6 +28,11 @@
 
 #include <boost/core/ignore_unused.hpp>
 
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+#include <boost/process/v2/posix/fork_safety.hpp>
+#include <typeinfo>
+#endif
+
 namespace boost { namespace process { BOOST_PROCESS_V1_INLINE namespace v1 { namespace detail { namespace posix {
 
 template<typename Executor>
@@ -91,6 +96,9 @@ struct on_exec_setup_t
     template<typename T>
     void operator()(T & t) const
     {
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+        ::boost::process::v2::posix::detail::fork_safety_scope scope{typeid(T).name()};
+#endif
         t.on_exec_setup(exec);
     }
 };
@@ -414,6 +422,9 @@ child executor<Sequence>::invoke(boost::mpl::false_, boost::mpl::false_)
         if (cmd_style)
             prepare_cmd_style();
 
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+        ::boost::process::v2::posix::detail::fork_safety_guard safety;
+#endif
         this->pid = ::fork();
         if (pid == -1)
         {
@@ -426,6 +437,9 @@ child executor<Sequence>::invoke(boost::mpl::false_, boost::mpl::false_)
         }
         else if (pid == 0)
         {
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+            safety.enter_child();
+#endif
             ::close(p.p[0]);
 
             boost::fusion::for_each(seq, call_on_exec_setup(*this));
@@ -445,6 +459,12 @@ child executor<Sequence>::invoke(boost::mpl::false_, boost::mpl::false_)
         p.p[1] = -1;
         _pipe_sink = -1;
         _read_error(p.p[0]);
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+        ::boost::process::v2::error_code safety_ec;
+        safety.finish(safety_ec);
+        if (safety_ec && !_ec)
+            set_error(std::error_code(safety_ec.value(), std::system_category()), "unsafe call in on_exec_setup");
+#endif
 
     }
     if (_ec)
@@ -0,0 +1,88 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_PROCESS_DETAIL_POSIX_FORK_REGIONS_HPP
+#define BOOST_PROCESS_DETAIL_POSIX_FORK_REGIONS_HPP
+
+#include <boost/process/v1/detail/posix/handler.hpp>
+#include <boost/process/v2/posix/fork_regions.hpp>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace boost { namespace process { BOOST_PROCESS_V1_INLINE namespace v1 { namespace detail { namespace posix {
+
+//excludes the regions of the registry while the executor forks, see v2::posix::exclude_fork_regions.
+struct exclude_fork_regions_ : handler_base_ext
+{
+    explicit exclude_fork_regions_(::boost::process::v2::posix::fork_region_registry & registry)
+        : registry_(registry) {}
+
+    //in case a later handler threw before on_error or on_success got invoked.
+    ~exclude_fork_regions_()
+    {
+        restore_();
+    }
+
+    template <class PosixExecutor>
+    void on_setup(PosixExecutor & e) const
+    {
+        //the executable isn't set yet in cmd style, it comes from the command line then.
+        if (touches_(e.exe) || touches_(e.cmd_line) || touches_(e.env) || registry_.overlaps(&e, sizeof(e)))
+        {
+            e.set_error(std::error_code(EFAULT, std::system_category()), "fork region passed to the child");
+            return;
+        }
+        ::boost::process::v2::error_code ec;
+        registry_.exclude(ec);
+        if (ec)
+            e.set_error(std::error_code(ec.value(), std::system_category()), "madvise() failed");
+        else
+            applied_ = true;
+    }
+
+    template <class PosixExecutor>
+    void on_error(PosixExecutor &, const std::error_code &) const
+    {
+        restore_();
+    }
+
+    template <class PosixExecutor>
+    void on_success(PosixExecutor &) const
+    {
+        restore_();
+    }
+
+private:
+    ::boost::process::v2::posix::fork_region_registry & registry_;
+    mutable bool applied_ = false;
+
+    void restore_() const
+    {
+        if (applied_)
+            registry_.restore();
+        applied_ = false;
+    }
+
+    bool touches_(const char * str) const
+    {
+        return str != nullptr && registry_.overlaps(str, std::strlen(str) + 1u);
+    }
+
+    bool touches_(const char * const * strs) const
+    {
+        if (strs == nullptr)
+            return false;
+        std::size_t n = 0u;
+        for (; strs[n] != nullptr; n++)
+            if (touches_(strs[n]))
+                return true;
+        return registry_.overlaps(strs, (n + 1u) * sizeof(*strs));
+    }
+};
+
+}}}}}
+
+#endif
@@ -97,6 +97,19 @@ public:
         }
         return static_cast<int_type>(read_len);
     }
+    ///Write two buffers, the second one only if the first one got written completely.
+    int_type write(const char_type * data1, int_type count1, const char_type * data2, int_type count2)
+    {
+        auto write_len = write(data1, count1);
+        if (write_len < static_cast<int_type>(count1 * sizeof(char_type)))
+            return write_len;
+        return write_len + write(data2, count2);
+    }
+    ///Read into the first buffer only, since a second ReadFile might block on an empty pipe.
+    int_type read(char_type * data1, int_type count1, char_type * /*data2*/, int_type /*count2*/)
+    {
+        return read(data1, count1);
+    }
 
     bool is_open() const
     {
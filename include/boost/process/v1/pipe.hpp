@@ -13,6 +13,8 @@
 
 #include <boost/config.hpp>
 #include <boost/process/v1/detail/config.hpp>
+#include <algorithm>
+#include <limits>
 #include <streambuf>
 #include <istream>
 #include <ostream>
@@ -108,6 +110,8 @@ struct basic_pipebuf : std::basic_streambuf<CharT, Traits>
     typedef  typename Traits::off_type off_type   ;
 
     constexpr static int default_buffer_size = BOOST_PROCESS_PIPE_SIZE;
+    ///The smallest buffer size accepted, since the get area keeps 128 characters for putback.
+    constexpr static int min_buffer_size = 256;
 
     ///Default constructor, will also construct the pipe.
     basic_pipebuf() : _write(default_buffer_size), _read(default_buffer_size)
@@ -115,6 +119,13 @@ struct basic_pipebuf : std::basic_streambuf<CharT, Traits>
         this->setg(_read.data(),  _read.data()+ 128,  _read.data() + 128);
         this->setp(_write.data(), _write.data() + _write.size());
     }
+    ///Construct the pipe and use buffers of `buffer_size` characters.
+    explicit basic_pipebuf(std::size_t buffer_size)
+            : _write(_clamp_buffer_size(buffer_size)), _read(_clamp_buffer_size(buffer_size))
+    {
+        this->setg(_read.data(),  _read.data()+ 128,  _read.data() + 128);
+        this->setp(_write.data(), _write.data() + _write.size());
+    }
     ///Copy Constructor.
     basic_pipebuf(const basic_pipebuf & ) = default;
     ///Move Constructor
@@ -149,6 +160,24 @@ struct basic_pipebuf : std::basic_streambuf<CharT, Traits>
         this->setg(_read.data(),  _read.data()+ 128,  _read.data() + 128);
         this->setp(_write.data(), _write.data() + _write.size());
     }
+    ///Move construct from a pipe and use buffers of `buffer_size` characters.
+    basic_pipebuf(pipe_type && p, std::size_t buffer_size)
+            : _pipe(std::move(p)),
+              _write(_clamp_buffer_size(buffer_size)),
+              _read(_clamp_buffer_size(buffer_size))
+    {
+        this->setg(_read.data(),  _read.data()+ 128,  _read.data() + 128);
+        this->setp(_write.data(), _write.data() + _write.size());
+    }
+    ///Construct from a pipe and use buffers of `buffer_size` characters.
+    basic_pipebuf(const pipe_type & p, std::size_t buffer_size)
+            : _pipe(p),
+              _write(_clamp_buffer_size(buffer_size)),
+              _read(_clamp_buffer_size(buffer_size))
+    {
+        this->setg(_read.data(),  _read.data()+ 128,  _read.data() + 128);
+        this->setp(_write.data(), _write.data() + _write.size());
+    }
     ///Copy assign.
     basic_pipebuf& operator=(const basic_pipebuf & ) = delete;
     ///Move assign.
@@ -220,6 +249,85 @@ struct basic_pipebuf : std::basic_streambuf<CharT, Traits>
     }
 
 
+    ///Writes `n` characters, bypassing the put area if they don't fit into it.
+    /** Transfers of at least the buffer size get written directly from `s`,
+     *  gathered with the pending put area into a single system call.
+     */
+    std::streamsize xsputn(const char_type * s, std::streamsize n) override
+    {
+        if (!_pipe.is_open()
+            || (n <= (this->epptr() - this->pptr()))
+            || (n < static_cast<std::streamsize>(_write.size())))
+            return std::basic_streambuf<CharT, Traits>::xsputn(s, n);
+
+        std::streamsize written = 0;
+        while (written < n)
+        {
+            const auto base = this->pbase();
+            const std::ptrdiff_t pending = this->pptr() - base;
+            const auto chunk = static_cast<typename pipe_type::int_type>(
+                    (std::min)(n - written, _max_transfer()));
+
+            std::ptrdiff_t wrt = pending > 0
+                ? _pipe.write(base, static_cast<typename pipe_type::int_type>(pending), s + written, chunk)
+                : _pipe.write(s + written, chunk);
+
+            if (wrt <= 0) //broken pipe
+                break;
+
+            if (wrt < pending)
+            {
+                std::move(base + wrt, base + pending, base);
+                this->pbump(static_cast<int>(-wrt));
+            }
+            else
+            {
+                this->pbump(static_cast<int>(-pending));
+                written += wrt - pending;
+            }
+        }
+        return written;
+    }
+
+    ///Reads `n` characters, bypassing the get area for large transfers.
+    /** Once the buffered data is consumed, remaining transfers of at least the buffer size
+     *  are read directly into `s`, while the internal buffer gets refilled by the same system call.
+     */
+    std::streamsize xsgetn(char_type * s, std::streamsize n) override
+    {
+        const std::streamsize avail = this->egptr() - this->gptr();
+        if (!_pipe.is_open() || (n - avail < static_cast<std::streamsize>(_read.size())))
+            return std::basic_streambuf<CharT, Traits>::xsgetn(s, n);
+
+        traits_type::copy(s, this->gptr(), static_cast<std::size_t>(avail));
+        this->gbump(static_cast<int>(avail));
+        std::streamsize got = avail;
+
+        const auto head = _read.data() + 10;
+        const auto tail = static_cast<typename pipe_type::int_type>(&_read.back() - head);
+
+        while (n - got >= static_cast<std::streamsize>(_read.size()))
+        {
+            const auto chunk = static_cast<typename pipe_type::int_type>(
+                    (std::min)(n - got, _max_transfer()));
+            const std::ptrdiff_t res = _pipe.read(s + got, chunk, head, tail);
+
+            this->setg(_read.data(), head, head);
+            if (res <= 0)
+                return got;
+            else if (res <= chunk)
+                got += res;
+            else
+            {
+                got += chunk;
+                this->setg(_read.data(), head, head + (res - chunk));
+            }
+        }
+        if (got < n)
+            got += std::basic_streambuf<CharT, Traits>::xsgetn(s + got, n - got);
+        return got;
+    }
+
     ///Set the pipe of the streambuf.
     void pipe(pipe_type&& p)      {_pipe = std::move(p); }
     ///Set the pipe of the streambuf.
@@ -234,6 +342,9 @@ struct basic_pipebuf : std::basic_streambuf<CharT, Traits>
     ///Check if the pipe is open
     bool is_open() const {return _pipe.is_open(); }
 
+    ///Get the size of the read & write buffers in characters.
+    std::size_t buffer_size() const {return _write.size();}
+
     ///Open a new pipe
     basic_pipebuf<CharT, Traits>* open()
     {
@@ -274,6 +385,17 @@ private:
     std::vector<char_type> _write;
     std::vector<char_type> _read;
 
+    static std::size_t _clamp_buffer_size(std::size_t buffer_size)
+    {
+        return (std::max)(buffer_size, static_cast<std::size_t>(min_buffer_size));
+    }
+
+    static std::streamsize _max_transfer()
+    {
+        return static_cast<std::streamsize>(
+                (std::numeric_limits<typename pipe_type::int_type>::max)() / sizeof(char_type));
+    }
+
     bool _write_impl()
     {
         if (!_pipe.is_open())
@@ -350,6 +472,24 @@ public:
     {
         std::basic_istream<CharT, Traits>::rdbuf(&_buf);
     }
+    ///Construct with a new pipe, using buffers of `buffer_size` characters.
+    explicit basic_ipstream(std::size_t buffer_size)
+            : std::basic_istream<CharT, Traits>(nullptr), _buf(pipe_type(), buffer_size)
+    {
+        std::basic_istream<CharT, Traits>::rdbuf(&_buf);
+    }
+    ///Move construct from a pipe, using buffers of `buffer_size` characters.
+    basic_ipstream(pipe_type && p, std::size_t buffer_size)
+            : std::basic_istream<CharT, Traits>(nullptr), _buf(std::move(p), buffer_size)
+    {
+        std::basic_istream<CharT, Traits>::rdbuf(&_buf);
+    }
+    ///Copy construct from a pipe, using buffers of `buffer_size` characters.
+    basic_ipstream(const pipe_type & p, std::size_t buffer_size)
+            : std::basic_istream<CharT, Traits>(nullptr), _buf(p, buffer_size)
+    {
+        std::basic_istream<CharT, Traits>::rdbuf(&_buf);
+    }
 
     ///Copy assignment.
     basic_ipstream& operator=(const basic_ipstream & ) = delete;
@@ -460,6 +600,24 @@ public:
     {
         std::basic_ostream<CharT, Traits>::rdbuf(&_buf);
     };
+    ///Construct with a new pipe, using buffers of `buffer_size` characters.
+    explicit basic_opstream(std::size_t buffer_size)
+            : std::basic_ostream<CharT, Traits>(nullptr), _buf(pipe_type(), buffer_size)
+    {
+        std::basic_ostream<CharT, Traits>::rdbuf(&_buf);
+    }
+    ///Move construct from a pipe, using buffers of `buffer_size` characters.
+    basic_opstream(pipe_type && p, std::size_t buffer_size)
+            : std::basic_ostream<CharT, Traits>(nullptr), _buf(std::move(p), buffer_size)
+    {
+        std::basic_ostream<CharT, Traits>::rdbuf(&_buf);
+    }
+    ///Copy construct from a pipe, using buffers of `buffer_size` characters.
+    basic_opstream(const pipe_type & p, std::size_t buffer_size)
+            : std::basic_ostream<CharT, Traits>(nullptr), _buf(p, buffer_size)
+    {
+        std::basic_ostream<CharT, Traits>::rdbuf(&_buf);
+    }
     ///Copy assignment.
     basic_opstream& operator=(const basic_opstream & ) = delete;
     ///Move assignment
@@ -569,6 +727,24 @@ public:
     {
         std::basic_iostream<CharT, Traits>::rdbuf(&_buf);
     };
+    ///Construct with a new pipe, using buffers of `buffer_size` characters.
+    explicit basic_pstream(std::size_t buffer_size)
+            : std::basic_iostream<CharT, Traits>(nullptr), _buf(pipe_type(), buffer_size)
+    {
+        std::basic_iostream<CharT, Traits>::rdbuf(&_buf);
+    }
+    ///Move construct from a pipe, using buffers of `buffer_size` characters.
+    basic_pstream(pipe_type && p, std::size_t buffer_size)
+            : std::basic_iostream<CharT, Traits>(nullptr), _buf(std::move(p), buffer_size)
+    {
+        std::basic_iostream<CharT, Traits>::rdbuf(&_buf);
+    }
+    ///Copy construct from a pipe, using buffers of `buffer_size` characters.
+    basic_pstream(const pipe_type & p, std::size_t buffer_size)
+            : std::basic_iostream<CharT, Traits>(nullptr), _buf(p, buffer_size)
+    {
+        std::basic_iostream<CharT, Traits>::rdbuf(&_buf);
+    }
     ///Copy assignment.
     basic_pstream& operator=(const basic_pstream & ) = delete;
     ///Move assignment
@@ -10,6 +10,10 @@
 #include <boost/process/v1/detail/posix/use_vfork.hpp>
 #include <boost/process/v1/detail/posix/signal.hpp>
 
+#if defined(__linux__)
+#include <boost/process/v1/detail/posix/fork_regions.hpp>
+#endif
+
 
 /** \file boost/process/posix.hpp
  *
@@ -22,6 +26,7 @@ namespace boost {
       <emphasis>unspecified</emphasis> <globalname alt="boost::process::v1::posix::fd">fd</globalname>;
       <emphasis>unspecified</emphasis> <globalname alt="boost::process::v1::posix::sig">sig</globalname>;
       <emphasis>unspecified</emphasis> <globalname alt="boost::process::v1::posix::use_vfork">use_vfork</globalname>;
+      <emphasis>unspecified</emphasis> <globalname alt="boost::process::v1::posix::exclude_fork_regions">exclude_fork_regions</globalname>(v2::posix::fork_region_registry &amp;);
     }
   }
 }
@@ -70,6 +75,19 @@ constexpr ::boost::process::v1::detail::posix::use_vfork_ use_vfork;
 
 using ::boost::process::v1::detail::posix::sighandler_t;
 
+#if defined(__linux__)
+/** This property excludes the regions of a `v2::posix::fork_region_registry` from the forked child
+ * (`MADV_DONTFORK` / `MADV_WIPEONFORK`) while the process gets launched, so `fork` doesn't copy their page tables.
+ * The launch fails with `EFAULT` if the executable, arguments or environment lie in a region.
+ \note Requires linking the boost_process library.
+ */
+inline ::boost::process::v1::detail::posix::exclude_fork_regions_ exclude_fork_regions(
+        ::boost::process::v2::posix::fork_region_registry & registry)
+{
+    return ::boost::process::v1::detail::posix::exclude_fork_regions_(registry);
+}
+#endif
+
 }}}}
 
 #endif /* BOOST_PROCESS_POSIX_HPP_ */
@@ -0,0 +1,272 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_CACHED_EXECUTE_HPP
+#define BOOST_PROCESS_V2_CACHED_EXECUTE_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/process.hpp>
+#include <boost/process/v2/start_dir.hpp>
+#include <boost/process/v2/stdio.hpp>
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/buffer.hpp>
+#include <asio/io_context.hpp>
+#include <asio/read.hpp>
+#include <asio/readable_pipe.hpp>
+#else
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/readable_pipe.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+/// The inputs of a run that determine its output, besides the executable and the arguments.
+struct execution_inputs
+{
+    /// The environment variables whose values are part of the key. The subprocess inherits the whole environment.
+    std::vector<std::string> env_keys;
+    /// The data written to the stdin of the subprocess.
+    std::string stdin_data;
+    /// The working directory, the current one if empty.
+    filesystem::path cwd;
+    /// Identify the executable by its content, instead of its inode, size & modification time.
+    bool hash_content = false;
+};
+
+/// The outcome of a run, either from the subprocess or replayed from the cache.
+struct execution_result
+{
+    /// The exit code of the subprocess.
+    int exit_code = -1;
+    /// Everything the subprocess wrote to stdout.
+    std::string out;
+    /// Everything the subprocess wrote to stderr.
+    std::string err;
+    /// Whether the result was replayed from the cache.
+    bool cached = false;
+};
+
+/// The statistics of an `execution_cache`.
+struct execution_cache_statistics
+{
+    /// The number of lookups that found a result.
+    std::uint64_t hits;
+    /// The number of lookups that didn't find a result.
+    std::uint64_t misses;
+    /// The number of results stored.
+    std::uint64_t stores;
+    /// The number of results removed to stay below the maximum size.
+    std::uint64_t evictions;
+    /// The number of results in the cache.
+    std::uint64_t entries;
+    /// The size of the results in the cache in bytes.
+    std::uint64_t size;
+};
+
+/// A size-bounded on-disk store of execution results, addressed by the hash of their inputs.
+/** Every result is a file in the directory; the least recently used ones get removed once the
+ * total size exceeds `max_size`. The files get replaced atomically, so multiple processes can
+ * share a directory, though the size limit is only enforced for the results known to this object.
+ *
+ * The stored key is compared on lookup, so a hash collision is a miss.
+ * This class is thread-safe.
+ */
+struct execution_cache
+{
+    /// Open or create the cache in `directory`.
+    BOOST_PROCESS_V2_DECL execution_cache(const filesystem::path & directory, std::uint64_t max_size, error_code & ec);
+
+    /// Open or create the cache in `directory`.
+    execution_cache(const filesystem::path & directory, std::uint64_t max_size)
+        : execution_cache(directory, max_size, throw_on_error_{})
+    {
+    }
+
+    execution_cache(const execution_cache & ) = delete;
+    execution_cache& operator=(const execution_cache & ) = delete;
+
+    /// Look up the result stored for `key`. A corrupt or missing file is a miss.
+    BOOST_PROCESS_V2_DECL bool lookup(const std::string & key, execution_result & result);
+
+    /// Store the result for `key`, evicting the least recently used results if needed.
+    BOOST_PROCESS_V2_DECL void store(const std::string & key, const execution_result & result, error_code & ec);
+
+    /// Remove all results.
+    BOOST_PROCESS_V2_DECL void clear(error_code & ec);
+
+    /// Get the statistics of the cache.
+    BOOST_PROCESS_V2_DECL execution_cache_statistics statistics() const;
+
+    /// The directory the results are stored in.
+    const filesystem::path & directory() const {return directory_;}
+
+    /// The maximum size of all results in bytes.
+    std::uint64_t max_size() const {return max_size_;}
+
+  private:
+    struct throw_on_error_ {};
+    execution_cache(const filesystem::path & directory, std::uint64_t max_size, throw_on_error_)
+        : directory_(directory), max_size_(max_size)
+    {
+        error_code ec;
+        open_(ec);
+        if (ec)
+            detail::throw_error(ec, "execution_cache");
+    }
+
+    struct entry
+    {
+        std::list<std::string>::iterator lru;
+        std::uint64_t size;
+    };
+
+    BOOST_PROCESS_V2_DECL void open_(error_code & ec);
+    void touch_(const std::string & name, std::uint64_t size);
+    void remove_(const std::string & name);
+    void evict_();
+
+    filesystem::path directory_;
+    std::uint64_t max_size_;
+
+    mutable std::mutex mutex_;
+    // most recently used first.
+    std::list<std::string> lru_;
+    std::unordered_map<std::string, entry> entries_;
+    execution_cache_statistics stats_{};
+};
+
+namespace detail
+{
+
+// Serializes everything that determines the result of a run. The executable gets resolved,
+// then identified by device, inode, size & modification time, or its content.
+BOOST_PROCESS_V2_DECL std::string execution_key(const filesystem::path & exe,
+                                                const std::vector<std::string> & args,
+                                                const execution_inputs & inputs,
+                                                error_code & ec);
+
+// Runs the process, capturing stdout & stderr. Reports whether it got terminated by a signal.
+inline execution_result execute_captured(const filesystem::path & exe,
+                                         const std::vector<std::string> & args,
+                                         const execution_inputs & inputs,
+                                         bool & signaled,
+                                         error_code & ec)
+{
+    signaled = false;
+    execution_result res;
+    const auto cwd = inputs.cwd.empty() ? filesystem::current_path(ec) : inputs.cwd;
+    if (ec)
+        return res;
+
+    net::io_context ctx;
+    // the pipes get connected to the subprocess by process_stdio.
+    net::readable_pipe out{ctx}, err{ctx};
+    auto proc = default_process_launcher()(ctx, ec, exe, args,
+                                           process_stdio{net::buffer(inputs.stdin_data), out, err},
+                                           process_start_dir{cwd});
+    if (ec)
+        return res;
+
+    // read both pipes at once, so the subprocess can't block on a full one.
+    net::async_read(out, net::dynamic_buffer(res.out), [](error_code, std::size_t){});
+    net::async_read(err, net::dynamic_buffer(res.err), [](error_code, std::size_t){});
+    ctx.run();
+    res.exit_code = proc.wait(ec);
+    signaled = !ec && WIFSIGNALED(proc.native_exit_code());
+    return res;
+}
+
+}
+
+/// Run a process or replay its result from the cache, if it ran with the same inputs before.
+/** The key is made from the executable, the arguments, the `inputs.env_keys` values, the stdin data
+ * and the working directory, so the process needs to be deterministic given those.
+ * Failing to store the result does not make the execution fail.
+ * Results of processes terminated by a signal don't get stored.
+ */
+template<typename Args>
+execution_result cached_execute(execution_cache & cache,
+                                const filesystem::path & exe,
+                                const Args & args,
+                                const execution_inputs & inputs,
+                                error_code & ec)
+{
+    std::vector<std::string> args_;
+    for (auto && arg : args)
+    {
+        const string_view arg_ = arg;
+        args_.emplace_back(arg_.data(), arg_.size());
+    }
+
+    const auto key = detail::execution_key(exe, args_, inputs, ec);
+    if (ec)
+        return execution_result{};
+
+    execution_result res;
+    if (cache.lookup(key, res))
+        return res;
+
+    bool signaled;
+    res = detail::execute_captured(exe, args_, inputs, signaled, ec);
+    // a killed run, e.g. by the OOM killer or a timeout, isn't deterministic.
+    if (!ec && !signaled)
+    {
+        error_code ign;
+        cache.store(key, res, ign);
+    }
+    return res;
+}
+
+/// Run a process or replay its result from the cache, if it ran with the same inputs before.
+template<typename Args>
+execution_result cached_execute(execution_cache & cache,
+                                const filesystem::path & exe,
+                                const Args & args,
+                                const execution_inputs & inputs = {})
+{
+    error_code ec;
+    auto res = cached_execute(cache, exe, args, inputs, ec);
+    if (ec)
+        detail::throw_error(ec, "cached_execute");
+    return res;
+}
+
+/// Run a process or replay its result from the cache, if it ran with the same inputs before.
+inline execution_result cached_execute(execution_cache & cache,
+                                       const filesystem::path & exe,
+                                       std::initializer_list<string_view> args,
+                                       const execution_inputs & inputs,
+                                       error_code & ec)
+{
+    return cached_execute<std::initializer_list<string_view>>(cache, exe, args, inputs, ec);
+}
+
+/// Run a process or replay its result from the cache, if it ran with the same inputs before.
+inline execution_result cached_execute(execution_cache & cache,
+                                       const filesystem::path & exe,
+                                       std::initializer_list<string_view> args,
+                                       const execution_inputs & inputs = {})
+{
+    return cached_execute<std::initializer_list<string_view>>(cache, exe, args, inputs);
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_CACHED_EXECUTE_HPP
@@ -0,0 +1,431 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_CHILD_MONITOR_HPP
+#define BOOST_PROCESS_V2_CHILD_MONITOR_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/detail/throw_exception.hpp>
+#include <boost/process/v2/pid.hpp>
+#include <boost/process/v2/process.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/steady_timer.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/steady_timer.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace detail
+{
+
+// The raw values of /proc/<pid>/stat we're interested in.
+struct proc_stat
+{
+    std::uint64_t user_ticks;
+    std::uint64_t system_ticks;
+    std::uint64_t virtual_memory;
+    std::uint64_t resident_pages;
+};
+
+BOOST_PROCESS_V2_DECL int open_proc_dir(error_code & ec);
+BOOST_PROCESS_V2_DECL void close_proc_dir(int fd);
+// Reads /proc/<pid>/stat relative to proc_fd, using buf as scratch space.
+BOOST_PROCESS_V2_DECL bool read_proc_stat(int proc_fd, pid_type pid, char * buf, std::size_t size,
+                                          proc_stat & st, error_code & ec);
+BOOST_PROCESS_V2_DECL std::uint64_t clock_ticks_per_second();
+BOOST_PROCESS_V2_DECL std::uint64_t page_size();
+
+}
+
+/// The resource usage of a child at one point in time, plus the change since the last sample.
+struct process_sample
+{
+    pid_type pid;
+    /// The cpu time spent in user and kernel mode since the start of the process.
+    std::chrono::nanoseconds user_time;
+    std::chrono::nanoseconds system_time;
+    /// The resident set size & the virtual memory size in bytes.
+    std::uint64_t resident_memory;
+    std::uint64_t virtual_memory;
+
+    /// The cpu time spent since the last sample.
+    std::chrono::nanoseconds user_time_delta;
+    std::chrono::nanoseconds system_time_delta;
+    /// The change of the resident set size since the last sample.
+    std::int64_t resident_memory_delta;
+    /// The cpu usage since the last sample, where 1.0 is one core fully used.
+    double cpu_usage;
+};
+
+/// Periodically samples the resource usage of many children on a single timer (linux only).
+/** All registered processes are sampled in one pass from /proc, sharing one
+ * read buffer, which is much cheaper than a timer per child.
+ *
+ * Threshold callbacks are edge triggered, i.e. they get invoked when a sample first exceeds the
+ * threshold and again only after a sample fell below it in the meantime.
+ *
+ * Processes are removed automatically when they can't be sampled anymore,
+ * i.e. once they got reaped. Note that a pid can get reused after that, so
+ * a process should be removed before waiting for it, if that is a concern.
+ *
+ * @par Example
+ * @code {.cpp}
+ * asio::io_context ctx;
+ * child_monitor mon{ctx, std::chrono::seconds(1)};
+ * mon.on_resident_memory_above(
+ *      1024 * 1024 * 1024,
+ *      [&](const process_sample & s) { kill_job(s.pid); });
+ *
+ * process proc(ctx, "/usr/bin/job", {});
+ * mon.add(proc);
+ * mon.start();
+ * @endcode
+ */
+template<typename Executor = net::any_io_executor>
+struct basic_child_monitor
+{
+    /// The executor of the monitor
+    using executor_type = Executor;
+    /// Get the executor of the monitor
+    executor_type get_executor() {return state_->timer.get_executor();}
+
+    /// The callback type for samples & thresholds.
+    using callback_type = std::function<void(const process_sample &)>;
+
+    /// Rebinds the monitor to another executor.
+    template <typename Executor1>
+    struct rebind_executor
+    {
+        /// The monitor type when rebound to the specified executor.
+        typedef basic_child_monitor<Executor1> other;
+    };
+
+    /// Create a monitor sampling at the given interval.
+    explicit basic_child_monitor(executor_type exec, std::chrono::steady_clock::duration interval)
+        : state_(std::make_shared<state>(std::move(exec), interval))
+    {
+    }
+
+    /// Create a monitor sampling at the given interval.
+    template <typename ExecutionContext>
+    explicit basic_child_monitor(ExecutionContext & context, std::chrono::steady_clock::duration interval,
+                                 typename std::enable_if<
+                                     std::is_convertible<ExecutionContext&,
+                                          net::execution_context&>::value, void *>::type = nullptr)
+        : basic_child_monitor(executor_type(context.get_executor()), interval)
+    {
+    }
+
+    basic_child_monitor(basic_child_monitor && ) = default;
+    basic_child_monitor& operator=(basic_child_monitor && lhs)
+    {
+        stop();
+        state_ = std::move(lhs.state_);
+        return *this;
+    }
+
+    /// Stops the monitor.
+    ~basic_child_monitor()
+    {
+        stop();
+    }
+
+    /// Add a process to be monitored.
+    template<typename Executor1>
+    void add(basic_process<Executor1> & proc)
+    {
+        add(proc.id());
+    }
+
+    /// Add a process by pid. It does not need to be a child, as long as it can be read from /proc.
+    void add(pid_type pid)
+    {
+        auto & cs = state_->children;
+        if (std::find_if(cs.begin(), cs.end(), [&](const child & c){return c.pid == pid;}) == cs.end())
+        {
+            cs.push_back(child{pid});
+            state_->generation++;
+        }
+    }
+
+    /// Stop monitoring a process.
+    template<typename Executor1>
+    void remove(basic_process<Executor1> & proc)
+    {
+        remove(proc.id());
+    }
+
+    /// Stop monitoring a process by pid.
+    void remove(pid_type pid)
+    {
+        auto & cs = state_->children;
+        cs.erase(std::remove_if(cs.begin(), cs.end(), [&](const child & c){return c.pid == pid;}), cs.end());
+        state_->generation++;
+    }
+
+    /// The number of monitored processes.
+    std::size_t size() const {return state_->children.size();}
+
+    /// Invoke a callback for every sample.
+    void on_sample(callback_type cb)
+    {
+        state_->on_sample = std::move(cb);
+    }
+
+    /// Invoke a callback when the resident memory of a process exceeds the given number of bytes.
+    void on_resident_memory_above(std::uint64_t bytes, callback_type cb)
+    {
+        add_threshold_(threshold::resident_memory, static_cast<double>(bytes), std::move(cb));
+    }
+
+    /// Invoke a callback when the cpu usage of a process exceeds `usage`, e.g. 0.5 for half a core.
+    void on_cpu_usage_above(double usage, callback_type cb)
+    {
+        add_threshold_(threshold::cpu_usage, usage, std::move(cb));
+    }
+
+    /// Start sampling, throws if /proc can't be opened.
+    void start()
+    {
+        error_code ec;
+        start(ec);
+        if (ec)
+            detail::throw_error(ec, "child_monitor::start");
+    }
+
+    /// Start sampling.
+    void start(error_code & ec)
+    {
+        auto & st = *state_;
+        if (st.running)
+            return;
+        if (st.proc_fd == -1)
+        {
+            st.proc_fd = detail::open_proc_dir(ec);
+            if (ec)
+                return;
+        }
+        st.running = true;
+        // take an initial sample so the first interval yields proper deltas
+        sample_(st);
+        schedule_(state_, ++st.run);
+    }
+
+    /// Stop sampling, the monitor can be restarted later.
+    void stop()
+    {
+        if (!state_)
+            return;
+        state_->running = false;
+        state_->timer.cancel();
+    }
+
+    /// Sample all processes right now, independent of the timer.
+    void sample()
+    {
+        auto & st = *state_;
+        if (st.proc_fd == -1)
+        {
+            error_code ec;
+            st.proc_fd = detail::open_proc_dir(ec);
+            if (ec)
+                detail::throw_error(ec, "child_monitor::sample");
+        }
+        sample_(st);
+    }
+
+  private:
+    struct threshold
+    {
+        enum kind_t {resident_memory, cpu_usage} kind;
+        double value;
+        callback_type callback;
+    };
+
+    struct child
+    {
+        pid_type pid;
+        bool sampled = false;
+        detail::proc_stat last{};
+        std::chrono::steady_clock::time_point time{};
+        // bit n is set while the sample is above threshold n
+        std::uint64_t exceeded = 0u;
+    };
+
+    struct state
+    {
+        state(executor_type exec, std::chrono::steady_clock::duration interval)
+            : timer(std::move(exec)), interval(interval)
+        {
+        }
+        ~state()
+        {
+            if (proc_fd != -1)
+                detail::close_proc_dir(proc_fd);
+        }
+
+        net::basic_waitable_timer<std::chrono::steady_clock,
+                                  net::wait_traits<std::chrono::steady_clock>,
+                                  executor_type> timer;
+        std::chrono::steady_clock::duration interval;
+        int proc_fd = -1;
+        bool running = false;
+        // identifies the current timer chain, so a completion queued before a restart is ignored
+        std::size_t run = 0u;
+        std::vector<child> children;
+        // changed by add & remove, so sample_ notices if a callback modified the children
+        std::size_t generation = 0u;
+        std::vector<threshold> thresholds;
+        callback_type on_sample;
+        char buffer[1024];
+        std::uint64_t ticks_per_second = detail::clock_ticks_per_second();
+        std::uint64_t page_size = detail::page_size();
+    };
+
+    std::shared_ptr<state> state_;
+
+    void add_threshold_(typename threshold::kind_t kind, double value, callback_type cb)
+    {
+        if (state_->thresholds.size() == 64u)
+            detail::throw_exception(std::length_error("child_monitor: too many thresholds"));
+        state_->thresholds.push_back(threshold{kind, value, std::move(cb)});
+    }
+
+    static void schedule_(const std::shared_ptr<state> & st, std::size_t run)
+    {
+        st->timer.expires_after(st->interval);
+        st->timer.async_wait(
+            [st, run](error_code ec)
+            {
+                if (ec || !st->running || st->run != run)
+                    return;
+                sample_(*st);
+                if (st->running && st->run == run)
+                    schedule_(st, run);
+            });
+    }
+
+    static std::chrono::nanoseconds ticks_to_ns_(std::uint64_t ticks, std::uint64_t per_second)
+    {
+        return std::chrono::nanoseconds(static_cast<std::int64_t>(ticks * (1000000000u / per_second)));
+    }
+
+    static void sample_(state & st)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        // callbacks may add or remove children, so index based
+        for (std::size_t i = 0u; i < st.children.size(); )
+        {
+            error_code ec;
+            detail::proc_stat ps;
+            if (!detail::read_proc_stat(st.proc_fd, st.children[i].pid, st.buffer, sizeof(st.buffer), ps, ec))
+            {
+                // the process is gone
+                st.children.erase(st.children.begin() + static_cast<std::ptrdiff_t>(i));
+                continue;
+            }
+
+            auto & c = st.children[i];
+            process_sample s;
+            s.pid = c.pid;
+            s.user_time   = ticks_to_ns_(ps.user_ticks,   st.ticks_per_second);
+            s.system_time = ticks_to_ns_(ps.system_ticks, st.ticks_per_second);
+            s.resident_memory = ps.resident_pages * st.page_size;
+            s.virtual_memory  = ps.virtual_memory;
+
+            const bool first = !c.sampled;
+            if (first)
+            {
+                s.user_time_delta = s.system_time_delta = std::chrono::nanoseconds::zero();
+                s.resident_memory_delta = 0;
+                s.cpu_usage = 0.;
+            }
+            else
+            {
+                s.user_time_delta   = ticks_to_ns_(ps.user_ticks   - c.last.user_ticks,   st.ticks_per_second);
+                s.system_time_delta = ticks_to_ns_(ps.system_ticks - c.last.system_ticks, st.ticks_per_second);
+                s.resident_memory_delta = static_cast<std::int64_t>(s.resident_memory)
+                                        - static_cast<std::int64_t>(c.last.resident_pages * st.page_size);
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - c.time);
+                s.cpu_usage = elapsed.count() > 0
+                            ? static_cast<double>((s.user_time_delta + s.system_time_delta).count())
+                                / static_cast<double>(elapsed.count())
+                            : 0.;
+            }
+            c.sampled = true;
+            c.last = ps;
+            c.time = now;
+
+            // callbacks may add or remove children, so the position needs to be rechecked afterwards
+            const auto pid = c.pid;
+            auto generation = st.generation;
+            auto locate = [&]() -> bool
+            {
+                if (generation == st.generation)
+                    return i < st.children.size();
+                generation = st.generation;
+                auto itr = std::find_if(st.children.begin(), st.children.end(),
+                                        [&](const child & ch){return ch.pid == pid;});
+                if (itr == st.children.end())
+                    return false;
+                i = static_cast<std::size_t>(itr - st.children.begin());
+                return true;
+            };
+
+            if (st.on_sample)
+                st.on_sample(s);
+
+            bool present = locate();
+            for (std::size_t t = 0u; present && t < st.thresholds.size(); t++)
+            {
+                const auto & th = st.thresholds[t];
+                // the cpu usage of the first sample is unknown
+                if (th.kind == threshold::cpu_usage && first)
+                    continue;
+                const double value = th.kind == threshold::resident_memory
+                                   ? static_cast<double>(s.resident_memory)
+                                   : s.cpu_usage;
+                const auto bit = std::uint64_t(1u) << t;
+                auto & exceeded = st.children[i].exceeded;
+                if (value <= th.value)
+                    exceeded &= ~bit;
+                else if ((exceeded & bit) == 0u)
+                {
+                    exceeded |= bit;
+                    // copied, because the callback might add thresholds
+                    auto cb = th.callback;
+                    cb(s);
+                    present = locate();
+                }
+            }
+            if (present)
+                i++;
+        }
+    }
+};
+
+/// A child_monitor with the default executor.
+typedef basic_child_monitor<> child_monitor;
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_CHILD_MONITOR_HPP
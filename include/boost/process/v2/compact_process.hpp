@@ -0,0 +1,356 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_COMPACT_PROCESS_HPP
+#define BOOST_PROCESS_V2_COMPACT_PROCESS_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+
+#include <boost/process/v2/detail/complete_immediately.hpp>
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/exit_code.hpp>
+#include <boost/process/v2/pid.hpp>
+#include <boost/process/v2/process.hpp>
+#include <boost/process/v2/posix/detail/pidfd_wait_set.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/compose.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/compose.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+/// A process handle that only holds the pid, the pidfd & the exit status (linux only).
+/** Unlike `basic_process` it has no executor and isn't registered with the reactor,
+ * so it takes 12 bytes instead of more than 400 bytes including the reactor's state.
+ * Waiting asynchronously is done through a shared `basic_process_reaper`.
+ *
+ * Signals are sent through the pidfd, so they can't hit another process reusing the pid.
+ * The process does not get terminated when the handle is destroyed.
+ */
+struct compact_process
+{
+    /// Create a closed handle.
+    compact_process() = default;
+
+    /// Attach to a child process by its pid.
+    explicit compact_process(pid_type pid)
+    {
+        error_code ec;
+        open_(pid, ec);
+        if (ec)
+            detail::throw_error(ec, "pidfd_open");
+    }
+
+    /// Attach to a child process by its pid.
+    compact_process(pid_type pid, error_code & ec)
+    {
+        open_(pid, ec);
+    }
+
+    /// Take over the pidfd of a process, which gets detached.
+    template<typename Executor>
+    explicit compact_process(basic_process<Executor> && proc)
+        : pid_(proc.id()), exit_status_(proc.native_exit_code())
+    {
+        pidfd_ = proc.detach().release_pidfd();
+    }
+
+    compact_process(compact_process && lhs) noexcept
+        : pid_(lhs.pid_), pidfd_(lhs.pidfd_), exit_status_(lhs.exit_status_)
+    {
+        lhs.pid_ = -1;
+        lhs.pidfd_ = -1;
+    }
+
+    compact_process& operator=(compact_process && lhs) noexcept
+    {
+        if (this != &lhs)
+        {
+            close_();
+            pid_ = lhs.pid_;
+            pidfd_ = lhs.pidfd_;
+            exit_status_ = lhs.exit_status_;
+            lhs.pid_ = -1;
+            lhs.pidfd_ = -1;
+        }
+        return *this;
+    }
+
+    /// Closes the pidfd, but does not terminate the process.
+    ~compact_process()
+    {
+        close_();
+    }
+
+    /// Get the id of the process.
+    pid_type id() const {return pid_;}
+    /// Get the pidfd.
+    int native_handle() const {return pidfd_;}
+    /// Check if the handle refers to a process, that might have exited already.
+    bool is_open() const {return pidfd_ != -1;}
+
+    /// The native exit code of the process, or `still_active`.
+    native_exit_code_type native_exit_code() const {return exit_status_;}
+    /// The exit code of the process, if it exited.
+    int exit_code() const {return evaluate_exit_code(exit_status_);}
+
+    /// Check if the process is running, storing the exit code if it exited.
+    BOOST_PROCESS_V2_DECL bool running(error_code & ec);
+    /// Throwing @overload bool running(error_code & ec)
+    bool running()
+    {
+        error_code ec;
+        const auto res = running(ec);
+        if (ec)
+            detail::throw_error(ec, "running failed");
+        return res;
+    }
+
+    /// Wait for the process to exit & return the exit code.
+    BOOST_PROCESS_V2_DECL int wait(error_code & ec);
+    /// Throwing @overload int wait(error_code & ec)
+    int wait()
+    {
+        error_code ec;
+        const auto res = wait(ec);
+        if (ec)
+            detail::throw_error(ec, "wait failed");
+        return res;
+    }
+
+    /// Send SIGINT to the process.
+    void interrupt(error_code & ec) {signal_(SIGINT, ec);}
+    /// Throwing @overload void interrupt(error_code & ec)
+    void interrupt()
+    {
+        error_code ec;
+        interrupt(ec);
+        if (ec)
+            detail::throw_error(ec, "interrupt failed");
+    }
+
+    /// Send SIGTERM to the process.
+    void request_exit(error_code & ec) {signal_(SIGTERM, ec);}
+    /// Throwing @overload void request_exit(error_code & ec)
+    void request_exit()
+    {
+        error_code ec;
+        request_exit(ec);
+        if (ec)
+            detail::throw_error(ec, "request_exit failed");
+    }
+
+    /// Kill the process & wait for it.
+    void terminate(error_code & ec)
+    {
+        signal_(SIGKILL, ec);
+        if (!ec)
+            wait(ec);
+    }
+    /// Throwing @overload void terminate(error_code & ec)
+    void terminate()
+    {
+        error_code ec;
+        terminate(ec);
+        if (ec)
+            detail::throw_error(ec, "terminate failed");
+    }
+
+  private:
+    BOOST_PROCESS_V2_DECL void open_(pid_type pid, error_code & ec);
+    BOOST_PROCESS_V2_DECL void close_();
+    BOOST_PROCESS_V2_DECL void signal_(int sig, error_code & ec);
+
+    pid_type pid_ = -1;
+    int pidfd_ = -1;
+    native_exit_code_type exit_status_{detail::still_active};
+};
+
+/// Waits for many `compact_process` objects using one epoll set, that is a single descriptor in the reactor.
+/** A process is only in the set while it's waited for & every wakeup reaps all exited processes in a batch.
+ *
+ * @par Example
+ * @code {.cpp}
+ * asio::io_context ctx;
+ * process_reaper reaper{ctx};
+ * std::vector<compact_process> children;
+ * for (auto & job : jobs)
+ *   children.emplace_back(process(ctx, "/usr/bin/job", {job}));
+ *
+ * for (auto & c : children)
+ *   reaper.async_wait(c, [](error_code ec, int exit_code) {});
+ * ctx.run();
+ * @endcode
+ */
+template<typename Executor = net::any_io_executor>
+struct basic_process_reaper
+{
+    /// The executor of the reaper.
+    using executor_type = Executor;
+    /// Get the executor of the reaper.
+    executor_type get_executor() {return state_->set.get_executor();}
+
+    /// Rebinds the reaper to another executor.
+    template <typename Executor1>
+    struct rebind_executor
+    {
+        /// The reaper type when rebound to the specified executor.
+        typedef basic_process_reaper<Executor1> other;
+    };
+
+    /// Create a reaper.
+    explicit basic_process_reaper(executor_type exec)
+        : state_(std::make_shared<state>(std::move(exec)))
+    {
+    }
+
+    /// Create a reaper.
+    template <typename ExecutionContext>
+    explicit basic_process_reaper(ExecutionContext & context,
+                                  typename std::enable_if<
+                                      std::is_convertible<ExecutionContext&,
+                                           net::execution_context&>::value, void *>::type = nullptr)
+        : basic_process_reaper(executor_type(context.get_executor()))
+    {
+    }
+
+    basic_process_reaper(basic_process_reaper && ) = default;
+    basic_process_reaper& operator=(basic_process_reaper && lhs)
+    {
+        cancel();
+        state_ = std::move(lhs.state_);
+        return *this;
+    }
+
+    /// Cancels all pending waits.
+    ~basic_process_reaper()
+    {
+        cancel();
+    }
+
+    /// The number of pending waits.
+    std::size_t size() const {return state_ ? state_->waiters.size() : 0u;}
+
+    /// Cancel all pending waits, which complete with `operation_aborted`.
+    void cancel()
+    {
+        if (!state_)
+            return;
+        auto waiters = std::move(state_->waiters);
+        state_->waiters.clear();
+        for (auto & w : waiters)
+        {
+            state_->remove(w.first);
+            w.second->complete(net::error::operation_aborted, -1);
+        }
+        state_->cancel();
+    }
+
+  private:
+    struct state : posix::detail::basic_pidfd_wait_set<Executor>
+    {
+        // the waiters by pidfd, which is also the key in the epoll set.
+        std::unordered_map<int, std::unique_ptr<posix::detail::pidfd_waiter>> waiters;
+
+        explicit state(executor_type exec) : posix::detail::basic_pidfd_wait_set<Executor>(std::move(exec)) {}
+
+        bool waiting() const {return !waiters.empty();}
+
+        void on_exit(std::uint64_t key)
+        {
+            const auto fd = static_cast<int>(key);
+            auto itr = waiters.find(fd);
+            if (itr == waiters.end())
+                return;
+            auto w = std::move(itr->second);
+            waiters.erase(itr);
+            this->remove(fd);
+            w->complete(error_code{}, -1);
+        }
+
+        void on_error(error_code ec)
+        {
+            auto ws = std::move(waiters);
+            waiters.clear();
+            for (auto & w : ws)
+                w.second->complete(ec, -1);
+        }
+    };
+
+    struct wait_op_
+    {
+        std::shared_ptr<state> st;
+        compact_process * proc;
+
+        template<typename Self>
+        void operator()(Self && self)
+        {
+            error_code ec;
+            if (!proc->is_open())
+            {
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            }
+            else if (proc->running(ec))
+            {
+                const int fd = proc->native_handle();
+                st->add(fd, static_cast<std::uint64_t>(fd), ec);
+                if (!ec)
+                {
+                    auto s = st;
+                    using self_type = typename std::decay<Self>::type;
+                    s->waiters.emplace(fd, std::unique_ptr<posix::detail::pidfd_waiter>(
+                            new posix::detail::pidfd_waiter_impl<self_type, executor_type>(
+                                    std::move(self), s->set.get_executor())));
+                    state::arm(s);
+                    return;
+                }
+            }
+
+            detail::complete_immediately(std::move(self), st->set.get_executor(), ec, proc->exit_code());
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec, int /*exit_code*/)
+        {
+            // the process exited, so this doesn't block.
+            if (!ec)
+                proc->wait(ec);
+            self.complete(ec, proc->exit_code());
+        }
+    };
+
+    std::shared_ptr<state> state_;
+
+  public:
+    /// Wait for the process to exit & reap it. The process needs to outlive the operation.
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, int))
+             WaitHandler = net::default_completion_token_t<executor_type>>
+    auto async_wait(compact_process & proc,
+                    WaitHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<WaitHandler, void(error_code, int)>(
+                wait_op_{nullptr, nullptr}, handler, std::declval<executor_type>()))
+    {
+        return net::async_compose<WaitHandler, void(error_code, int)>(
+                wait_op_{state_, &proc}, handler, state_->set.get_executor());
+    }
+};
+
+/// A process_reaper with the default executor.
+typedef basic_process_reaper<> process_reaper;
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_COMPACT_PROCESS_HPP
@@ -0,0 +1,70 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_DETAIL_COMPLETE_IMMEDIATELY_HPP
+#define BOOST_PROCESS_V2_DETAIL_COMPLETE_IMMEDIATELY_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/associated_immediate_executor.hpp>
+#include <asio/dispatch.hpp>
+#else
+#include <boost/asio/associated_immediate_executor.hpp>
+#include <boost/asio/dispatch.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace detail
+{
+
+template<typename Self, typename ... Args>
+struct immediate_completion
+{
+    // args come first, so they get copied before self gets moved.
+    std::tuple<Args...> args;
+    Self self;
+
+    void operator()()
+    {
+        complete_<sizeof...(Args)>();
+    }
+
+  private:
+    // unpacks args from the back, so it works without std::index_sequence.
+    template<std::size_t N, typename ... Unpacked>
+    typename std::enable_if<N != 0u>::type complete_(Unpacked && ... unpacked)
+    {
+        complete_<N - 1u>(std::move(std::get<N - 1u>(args)), std::forward<Unpacked>(unpacked)...);
+    }
+
+    template<std::size_t N, typename ... Unpacked>
+    typename std::enable_if<N == 0u>::type complete_(Unpacked && ... unpacked)
+    {
+        self.complete(std::forward<Unpacked>(unpacked)...);
+    }
+};
+
+// Completes the composed operation self with args, without running the handler inside the initiating function.
+// io_executor is the executor of the I/O object, used if the handler has no associated immediate executor.
+template<typename Self, typename Executor, typename ... Args>
+void complete_immediately(Self && self, const Executor & io_executor, Args && ... args)
+{
+    // get the executor before self gets moved.
+    auto exec = net::get_associated_immediate_executor(self, io_executor);
+    net::dispatch(exec, immediate_completion<typename std::decay<Self>::type, typename std::decay<Args>::type...>{
+            std::make_tuple(std::forward<Args>(args)...), std::move(self)});
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_DETAIL_COMPLETE_IMMEDIATELY_HPP
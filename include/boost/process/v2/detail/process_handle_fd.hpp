@@ -10,6 +10,7 @@
 
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <sys/syscall.h>
 
 #include <boost/process/v2/detail/last_error.hpp>
@@ -103,6 +104,16 @@ struct basic_process_handle_fd
 
     native_handle_type native_handle() {return pid_;}
 
+    // The pidfd, used to wait for many processes at once.
+    int pidfd() {return descriptor_.native_handle();}
+
+    // Releases the pidfd, leaving the handle closed.
+    int release_pidfd()
+    {
+        pid_ = -1;
+        return descriptor_.release();
+    }
+
     void terminate_if_running(error_code &)
     {
         if (pid_ <= 0)
@@ -125,11 +136,11 @@ struct basic_process_handle_fd
         }
     }
 
-    void wait(native_exit_code_type &exit_status, error_code &ec)
+    void wait(native_exit_code_type &exit_status, error_code &ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return;
-        while (::waitpid(pid_, &exit_status, 0) < 0)
+        while (::wait4(pid_, &exit_status, 0, usage) < 0)
         {
             if (errno != EINTR)
             {
@@ -220,14 +231,14 @@ struct basic_process_handle_fd
         if (::kill(pid_, SIGCONT) == -1)
             ec = get_last_error();
     }
-    void terminate(native_exit_code_type &exit_status, error_code &ec)
+    void terminate(native_exit_code_type &exit_status, error_code &ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return;
         if (::kill(pid_, SIGKILL) == -1)
             ec = get_last_error();
         else
-            wait(exit_status, ec);
+            wait(exit_status, ec, usage);
     }
 
     void terminate(native_exit_code_type &exit_status)
@@ -240,12 +251,12 @@ struct basic_process_handle_fd
             detail::throw_error(ec, "terminate");
     }
 
-    bool running(native_exit_code_type &exit_code, error_code & ec)
+    bool running(native_exit_code_type &exit_code, error_code & ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return false;
         int code = 0;
-        int res = ::waitpid(pid_, &code, WNOHANG);
+        int res = ::wait4(pid_, &code, WNOHANG, usage);
         if (res == -1)
             ec = get_last_error();
         else if (res == 0)
@@ -287,6 +298,7 @@ struct basic_process_handle_fd
         net::posix::basic_descriptor<Executor> &descriptor;
         pid_type pid_;
         native_exit_code_type & exit_code;
+        struct rusage * usage;
         template<typename Self>
         void operator()(Self &&self)
         {
@@ -297,7 +309,7 @@ struct basic_process_handle_fd
               BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
             else if (process_is_running(exit_code))
             {
-                wait_res = ::waitpid(pid_, &exit_code, WNOHANG);
+                wait_res = ::wait4(pid_, &exit_code, WNOHANG, usage);
                 if (wait_res == -1)
                     ec = get_last_error();
             }
@@ -327,7 +339,7 @@ struct basic_process_handle_fd
         void operator()(Self &&self, error_code ec, int = 0)
         {
             if (!ec && process_is_running(exit_code))
-                if (::waitpid(pid_, &exit_code, 0) == -1)
+                if (::wait4(pid_, &exit_code, 0, usage) == -1)
                     ec = get_last_error();
             std::move(self).complete(ec);
         }
@@ -339,10 +351,22 @@ struct basic_process_handle_fd
     auto async_wait(native_exit_code_type & exit_code,
                     WaitHandler &&handler = net::default_completion_token_t<executor_type>())
     -> decltype(net::async_compose<WaitHandler, void(error_code)>(
-        async_wait_op_{descriptor_, pid_, exit_code}, handler, descriptor_))
+        async_wait_op_{descriptor_, pid_, exit_code, nullptr}, handler, descriptor_))
+    {
+      return net::async_compose<WaitHandler, void(error_code)>(
+          async_wait_op_{descriptor_, pid_, exit_code, nullptr}, handler, descriptor_);
+    }
+
+    /// Wait asynchronously and store the resource usage of the process once reaped.
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code))
+    WaitHandler = net::default_completion_token_t<executor_type>>
+    auto async_wait(native_exit_code_type & exit_code, struct rusage & usage,
+                    WaitHandler &&handler = net::default_completion_token_t<executor_type>())
+    -> decltype(net::async_compose<WaitHandler, void(error_code)>(
+        async_wait_op_{descriptor_, pid_, exit_code, &usage}, handler, descriptor_))
     {
       return net::async_compose<WaitHandler, void(error_code)>(
-          async_wait_op_{descriptor_, pid_, exit_code}, handler, descriptor_);
+          async_wait_op_{descriptor_, pid_, exit_code, &usage}, handler, descriptor_);
     }
 
 };
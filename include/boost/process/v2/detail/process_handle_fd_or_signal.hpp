@@ -10,6 +10,7 @@
 
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 
 #include <boost/process/v2/detail/last_error.hpp>
 #include <boost/process/v2/detail/throw_error.hpp>
@@ -160,11 +161,11 @@ struct basic_process_handle_fd_or_signal
         }
     }
 
-    void wait(native_exit_code_type &exit_status, error_code &ec)
+    void wait(native_exit_code_type &exit_status, error_code &ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return;
-        while (::waitpid(pid_, &exit_status, 0) < 0)
+        while (::wait4(pid_, &exit_status, 0, usage) < 0)
         {
             if (errno != EINTR)
             {
@@ -257,14 +258,14 @@ struct basic_process_handle_fd_or_signal
             ec = get_last_error();
     }
 
-    void terminate(native_exit_code_type &exit_status, error_code &ec)
+    void terminate(native_exit_code_type &exit_status, error_code &ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return;
         if (::kill(pid_, SIGKILL) == -1)
             ec = get_last_error();
         else
-            wait(exit_status, ec);
+            wait(exit_status, ec, usage);
     }
 
     void terminate(native_exit_code_type &exit_status)
@@ -277,12 +278,12 @@ struct basic_process_handle_fd_or_signal
             detail::throw_error(ec, "terminate");
     }
 
-    bool running(native_exit_code_type &exit_code, error_code & ec)
+    bool running(native_exit_code_type &exit_code, error_code & ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return false;
         int code = 0;
-        int res = ::waitpid(pid_, &code, WNOHANG);
+        int res = ::wait4(pid_, &code, WNOHANG, usage);
         if (res == -1)
             ec = get_last_error();
         else if (res == 0)
@@ -333,6 +334,7 @@ struct basic_process_handle_fd_or_signal
 #endif
         pid_type pid_;
         native_exit_code_type & exit_code;
+        struct rusage * usage;
         bool needs_post = true;
 
         template<typename Self>
@@ -350,7 +352,7 @@ struct basic_process_handle_fd_or_signal
                 ec = net::error::bad_descriptor;
             else if (process_is_running(exit_code))
             {
-                wait_res = ::waitpid(pid_, &exit_code, WNOHANG);
+                wait_res = ::wait4(pid_, &exit_code, WNOHANG, usage);
                 if (wait_res == -1)
                     ec = get_last_error();
             }
@@ -400,10 +402,22 @@ struct basic_process_handle_fd_or_signal
     auto async_wait(native_exit_code_type & exit_code,
                     WaitHandler &&handler = net::default_completion_token_t<executor_type>())
       -> decltype(net::async_compose<WaitHandler, void(error_code)>(
-                  async_wait_op_{descriptor_, signal_set_, pid_, exit_code}, handler, descriptor_))
+                  async_wait_op_{descriptor_, signal_set_, pid_, exit_code, nullptr}, handler, descriptor_))
     {
         return net::async_compose<WaitHandler, void(error_code)>(
-                async_wait_op_{descriptor_, signal_set_, pid_, exit_code}, handler, descriptor_);
+                async_wait_op_{descriptor_, signal_set_, pid_, exit_code, nullptr}, handler, descriptor_);
+    }
+
+    /// Wait asynchronously and store the resource usage of the process once reaped.
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code))
+             WaitHandler = net::default_completion_token_t<executor_type>>
+    auto async_wait(native_exit_code_type & exit_code, struct rusage & usage,
+                    WaitHandler &&handler = net::default_completion_token_t<executor_type>())
+      -> decltype(net::async_compose<WaitHandler, void(error_code)>(
+                  async_wait_op_{descriptor_, signal_set_, pid_, exit_code, &usage}, handler, descriptor_))
+    {
+        return net::async_compose<WaitHandler, void(error_code)>(
+                async_wait_op_{descriptor_, signal_set_, pid_, exit_code, &usage}, handler, descriptor_);
     }
 };
 }
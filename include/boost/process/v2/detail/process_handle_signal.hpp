@@ -9,6 +9,7 @@
 
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 
 #include <boost/process/v2/detail/last_error.hpp>
 #include <boost/process/v2/detail/throw_error.hpp>
@@ -133,11 +134,11 @@ struct basic_process_handle_signal
         }
     }
 
-    void wait(native_exit_code_type &exit_status, error_code &ec)
+    void wait(native_exit_code_type &exit_status, error_code &ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return;
-        while (::waitpid(pid_, &exit_status, 0) < 0)
+        while (::wait4(pid_, &exit_status, 0, usage) < 0)
         {
             if (errno != EINTR)
             {
@@ -229,14 +230,14 @@ struct basic_process_handle_signal
             ec = get_last_error();
     }
 
-    void terminate(native_exit_code_type &exit_status, error_code &ec)
+    void terminate(native_exit_code_type &exit_status, error_code &ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return;
         if (::kill(pid_, SIGKILL) == -1)
             ec = get_last_error();
         else
-            wait(exit_status, ec);
+            wait(exit_status, ec, usage);
     }
 
     void terminate(native_exit_code_type &exit_status)
@@ -249,12 +250,12 @@ struct basic_process_handle_signal
             detail::throw_error(ec, "terminate");
     }
 
-    bool running(native_exit_code_type &exit_code, error_code & ec)
+    bool running(native_exit_code_type &exit_code, error_code & ec, struct rusage * usage = nullptr)
     {
         if (pid_ <= 0)
             return false;
         int code = 0;
-        int res = ::waitpid(pid_, &code, WNOHANG);
+        int res = ::wait4(pid_, &code, WNOHANG, usage);
         if (res == -1)
             ec = get_last_error();
         else if (res == 0)
@@ -309,6 +310,7 @@ struct basic_process_handle_signal
         net::basic_signal_set<Executor> &handle;
         pid_type pid_;
         native_exit_code_type & exit_code;
+        struct rusage * usage;
 
         template<typename Self>
         void operator()(Self &&self)
@@ -333,7 +335,7 @@ struct basic_process_handle_signal
                 ec = net::error::bad_descriptor;
             else if (!ec && process_is_running(exit_code))
             {
-                wait_res = ::waitpid(pid_, &exit_code, WNOHANG);
+                wait_res = ::wait4(pid_, &exit_code, WNOHANG, usage);
                 if (wait_res == -1)
                     ec = get_last_error();
             }
@@ -371,10 +373,22 @@ struct basic_process_handle_signal
     auto async_wait(native_exit_code_type & exit_code,
                     WaitHandler &&handler = net::default_completion_token_t<executor_type>())
       -> decltype(net::async_compose<WaitHandler, void(error_code)>(
-                    async_wait_op_{signal_set_, pid_, exit_code}, handler, signal_set_))
+                    async_wait_op_{signal_set_, pid_, exit_code, nullptr}, handler, signal_set_))
     {
         return net::async_compose<WaitHandler, void(error_code)>(
-                async_wait_op_{signal_set_, pid_, exit_code}, handler, signal_set_);
+                async_wait_op_{signal_set_, pid_, exit_code, nullptr}, handler, signal_set_);
+    }
+
+    /// Wait asynchronously and store the resource usage of the process once reaped.
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code))
+             WaitHandler = net::default_completion_token_t<executor_type>>
+    auto async_wait(native_exit_code_type & exit_code, struct rusage & usage,
+                    WaitHandler &&handler = net::default_completion_token_t<executor_type>())
+      -> decltype(net::async_compose<WaitHandler, void(error_code)>(
+                    async_wait_op_{signal_set_, pid_, exit_code, &usage}, handler, signal_set_))
+    {
+        return net::async_compose<WaitHandler, void(error_code)>(
+                async_wait_op_{signal_set_, pid_, exit_code, &usage}, handler, signal_set_);
     }
 };
 
@@ -7,6 +7,7 @@
 
 #include <boost/process/v2/detail/config.hpp>
 #include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/error.hpp>
 
 BOOST_PROCESS_V2_BEGIN_NAMESPACE
 
@@ -21,6 +22,15 @@ BOOST_PROCESS_V2_DECL std::size_t convert_to_utf8(const wchar_t * in, std::size_
 BOOST_PROCESS_V2_DECL std::size_t convert_to_wide(const  char   * in, std::size_t size,  
                                                   wchar_t * out, std::size_t max_size, error_code & ec);
 
+// Convert as much as fits into the output, `next` points to the first input character not converted.
+// Yields `error::insufficient_buffer` with the converted size if the output is too small.
+BOOST_PROCESS_V2_DECL std::size_t convert_some_to_utf8(const wchar_t * in, std::size_t size,
+                                                       char * out, std::size_t max_size,
+                                                       const wchar_t * & next, error_code & ec);
+BOOST_PROCESS_V2_DECL std::size_t convert_some_to_wide(const  char   * in, std::size_t size,
+                                                       wchar_t * out, std::size_t max_size,
+                                                       const char * & next, error_code & ec);
+
 template<typename CharOut, typename Traits = std::char_traits<CharOut>, 
          typename Allocator = std::allocator<CharOut>, typename CharIn,
          typename = typename std::enable_if<std::is_same<CharOut, CharIn>::value>::type> 
@@ -39,15 +49,25 @@ std::basic_string<CharOut, Traits, Allocator> conv_string(
     const wchar_t * data, std::size_t size, 
     const Allocator allocator = Allocator{})
 {
-    error_code ec;
-    const auto req_size = size_as_utf8(data, size, ec);
-    if (ec)
-        detail::throw_error(ec, "size_as_utf8");
-
     std::basic_string<CharOut, Traits, Allocator> res(allocator);
-    res.resize(req_size);
+    if (size == 0u)
+        return res;
 
-    auto res_size = convert_to_utf8(data, size, &res.front(), req_size,  ec);
+    // optimistically assume ascii, so most strings only get traversed once.
+    error_code ec;
+    res.resize(size);
+    const wchar_t * next = data;
+    auto res_size = convert_some_to_utf8(data, size, &res.front(), size, next, ec);
+    if (ec == error_code(error::insufficient_buffer, error::get_utf8_category()))
+    {
+        ec.clear();
+        const auto rest = static_cast<std::size_t>(data + size - next);
+        const auto req_size = size_as_utf8(next, rest, ec);
+        if (ec)
+            detail::throw_error(ec, "size_as_utf8");
+        res.resize(res_size + req_size);
+        res_size += convert_to_utf8(next, rest, &res.front() + res_size, req_size, ec);
+    }
     if (ec)
         detail::throw_error(ec, "convert_to_utf8");
 
@@ -62,15 +82,14 @@ std::basic_string<CharOut, Traits, Allocator> conv_string(
     const char * data, std::size_t size, 
     const Allocator allocator = Allocator{})
 {
-    error_code ec;
-    const auto req_size = size_as_wide(data, size, ec);
-    if (ec)
-        detail::throw_error(ec, "size_as_wide");
-
     std::basic_string<CharOut, Traits, Allocator> res(allocator);
-    res.resize(req_size);
+    if (size == 0u)
+        return res;
 
-    auto res_size = convert_to_wide(data, size, &res.front(), req_size,  ec);
+    // utf-8 never has less octets than characters, so this converts in a single pass.
+    error_code ec;
+    res.resize(size);
+    auto res_size = convert_to_wide(data, size, &res.front(), size, ec);
     if (ec)
         detail::throw_error(ec, "convert_to_wide");
 
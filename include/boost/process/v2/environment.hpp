@@ -1435,6 +1435,180 @@ auto find_key(Environment & env, key_view ky)
 }
 
 
+/// An environment with a hash index over its keys.
+/**
+ * Looking up a key in an environment range is a linear scan over all entries.
+ * `indexed_view` builds a hash index once, so that lookups through `find`,
+ * `home` and `find_executable` are constant time.
+ *
+ * @code
+ * environment::indexed_view env;
+ * auto home = environment::home(env);
+ * auto exe  = environment::find_executable("gcc", env);
+ * @endcode
+ *
+ * The view references the entries of the underlying environment, which must outlive it.
+ * When indexing the current environment, `stale` can be used to check if it has changed since.
+ */
+struct indexed_view
+{
+  using value_type     = key_value_pair_view;
+  using iterator       = std::vector<key_value_pair_view>::const_iterator;
+  using const_iterator = iterator;
+
+  /// Index the current environment of this process.
+  indexed_view() : current_(new current_view())
+  {
+    index_(*current_);
+  }
+
+  /// Index an environment range with elements convertible to `key_value_pair_view`.
+  template<typename Environment>
+  explicit indexed_view(Environment && env,
+                        typename std::enable_if<
+                          std::is_convertible<decltype(*std::begin(env)), key_value_pair_view>::value
+                          && !std::is_same<typename std::decay<Environment>::type, indexed_view>::value
+                        >::type * = nullptr)
+  {
+    index_(env);
+  }
+
+  indexed_view(indexed_view && ) = default;
+  indexed_view& operator=(indexed_view && ) = default;
+
+  iterator begin() const {return entries_.begin();}
+  iterator   end() const {return entries_.end();}
+  std::size_t size() const {return entries_.size();}
+  bool empty() const {return entries_.empty();}
+
+  /// Look up the value of a key, returns an empty value if not found.
+  value_view find(key_view k) const
+  {
+    const auto idx = lookup_(k);
+    return idx != npos_ ? entries_[idx].value() : value_view();
+  }
+
+  /// Check if the key is present.
+  bool contains(key_view k) const {return lookup_(k) != npos_;}
+
+  /// Check if the current environment changed since it got indexed.
+  /** This compares the entries without looking at the strings on posix,
+   * it is always false if the view wasn't created from the current environment. */
+  bool stale() const
+  {
+    if (!current_)
+      return false;
+    current_view now;
+    auto itr = entries_.begin();
+    for (key_value_pair_view kv : now)
+    {
+      if (itr == entries_.end())
+        return true;
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+      if (kv.native() != itr->native())
+#else
+      if (kv.native().data() != itr->native().data())
+#endif
+        return true;
+      ++itr;
+    }
+    return itr != entries_.end();
+  }
+
+  /// Re-index the current environment, if that's what got indexed.
+  void refresh()
+  {
+    if (!current_)
+      return;
+    current_.reset(new current_view());
+    index_(*current_);
+  }
+
+ private:
+  constexpr static std::size_t npos_ = static_cast<std::size_t>(-1);
+
+  // keeps the environment alive, if it's an owning view.
+  std::unique_ptr<current_view> current_;
+  std::vector<key_value_pair_view> entries_;
+  std::vector<std::size_t> hashes_;
+  // open addressing with linear probing, holding entry index + 1.
+  std::vector<std::size_t> slots_;
+
+  static std::size_t hash_(key_view k)
+  {
+    // FNV-1a, folding case like key_char_traits does.
+    std::size_t h = static_cast<std::size_t>(14695981039346656037ull);
+    for (auto c : k.native())
+    {
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+      c = key_char_traits<char_type>::to_lower(c);
+#endif
+      h = (h ^ static_cast<std::size_t>(c)) * static_cast<std::size_t>(1099511628211ull);
+    }
+    return h;
+  }
+
+  std::size_t lookup_(key_view k) const
+  {
+    if (slots_.empty())
+      return npos_;
+    const auto h = hash_(k);
+    const auto mask = slots_.size() - 1u;
+    for (auto i = h & mask; slots_[i] != 0u; i = (i + 1u) & mask)
+    {
+      const auto idx = slots_[i] - 1u;
+      if (hashes_[idx] == h && entries_[idx].key() == k)
+        return idx;
+    }
+    return npos_;
+  }
+
+  template<typename Environment>
+  void index_(Environment && env)
+  {
+    entries_.clear();
+    hashes_.clear();
+    for (auto && e : env)
+    {
+      const key_value_pair_view kv = e;
+      entries_.push_back(kv);
+      hashes_.push_back(hash_(kv.key()));
+    }
+
+    std::size_t cap = 8u;
+    while (cap < entries_.size() * 2u)
+      cap <<= 1;
+    slots_.assign(cap, 0u);
+
+    const auto mask = cap - 1u;
+    for (std::size_t idx = 0u; idx < entries_.size(); idx++)
+    {
+      // like a linear scan, the first occurrence of a key wins.
+      if (lookup_(entries_[idx].key()) != npos_)
+        continue;
+      auto i = hashes_[idx] & mask;
+      while (slots_[i] != 0u)
+        i = (i + 1u) & mask;
+      slots_[i] = idx + 1u;
+    }
+  }
+};
+
+namespace detail
+{
+
+inline value_view find_key(const indexed_view & env, key_view ky)
+{
+  return env.find(ky);
+}
+
+inline value_view find_key(indexed_view & env, key_view ky)
+{
+  return env.find(ky);
+}
+
+}
+
 /// Find the home folder in an environment-like type.
 /** 
  * @param env The environment to search. Defaults to the current environment of this process
@@ -1822,6 +1996,119 @@ struct process_environment
 
 };
 
+namespace environment
+{
+
+/// A copy-on-write layer on top of the current environment, usable as an initializer.
+/**
+ * The overlay only stores the variables that get set or removed; the environment
+ * of the subprocess is assembled when it gets launched, reusing the entries
+ * of the current environment that are not overridden.
+ *
+ * @code {.cpp}
+ * environment::overlay env;
+ * env.set("FOO", "BAR");
+ * env.unset("TMPDIR");
+ * process proc{executor, find_executable("printenv"), {"FOO"}, env};
+ * @endcode
+ *
+ * The memory used for assembling the environment is kept, so that an overlay
+ * can be used for multiple launches without reallocating.
+ */
+struct overlay
+{
+  overlay() = default;
+
+  /// Set the variables of an initializer list, e.g. `{{"FOO", "BAR"}}`.
+  overlay(std::initializer_list<std::pair<key_view, value_view>> kvs)
+  {
+    for (auto & kv : kvs)
+      set(kv.first, kv.second);
+  }
+
+  /// Set a variable for the subprocess, replacing the one of the current environment.
+  void set(key_view k, value_view v)
+  {
+    auto itr = find_(k);
+    if (itr != deltas_.end())
+    {
+      *itr = delta_{key_value_pair(k, v), false};
+    }
+    else
+      deltas_.push_back(delta_{key_value_pair(k, v), false});
+  }
+
+  /// Remove a variable from the environment of the subprocess.
+  void unset(key_view k)
+  {
+    auto itr = find_(k);
+    if (itr != deltas_.end())
+      *itr = delta_{key_value_pair(k, value_view()), true};
+    else
+      deltas_.push_back(delta_{key_value_pair(k, value_view()), true});
+  }
+
+  /// Drop the change to a variable, so it is inherited from the current environment again.
+  void reset(key_view k)
+  {
+    auto itr = find_(k);
+    if (itr != deltas_.end())
+      deltas_.erase(itr);
+  }
+
+  /// Drop all changes.
+  void clear() {deltas_.clear();}
+
+  /// Check if any variable gets changed.
+  bool empty() const {return deltas_.empty();}
+
+  /// The number of variables that get changed.
+  std::size_t size() const {return deltas_.size();}
+
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+  BOOST_PROCESS_V2_DECL
+  error_code on_setup(windows::default_launcher & launcher,
+                      const filesystem::path &, const std::wstring &);
+#else
+  BOOST_PROCESS_V2_DECL
+  error_code on_setup(posix::default_launcher & launcher,
+                      const filesystem::path &, const char * const *);
+#endif
+
+ private:
+  struct delta_
+  {
+    key_value_pair pair;
+    bool removed;
+  };
+
+  std::vector<delta_> deltas_;
+
+  std::vector<delta_>::iterator find_(key_view k)
+  {
+    return std::find_if(deltas_.begin(), deltas_.end(),
+                        [&](const delta_ & d) {return d.pair.key() == k;});
+  }
+
+  // true if the variable is set or removed by this overlay.
+  bool overrides_(key_view k) const
+  {
+    for (auto & d : deltas_)
+      if (d.pair.key() == k)
+        return true;
+    return false;
+  }
+
+  // the arena the environment gets assembled in, reused between launches.
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+  std::vector<wchar_t> block_;
+#else
+  std::vector<const char *> envp_;
+#endif
+};
+
+}
+
 
 
 BOOST_PROCESS_V2_END_NAMESPACE
@@ -7,10 +7,18 @@
 
 #include <boost/process/v2/process.hpp>
 
+#include <memory>
+
 #if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/associated_allocator.hpp>
+#include <asio/async_result.hpp>
 #include <asio/bind_cancellation_slot.hpp>
+#include <asio/recycling_allocator.hpp>
 #else
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/async_result.hpp>
 #include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/recycling_allocator.hpp>
 #endif
 
 BOOST_PROCESS_V2_BEGIN_NAMESPACE
@@ -40,10 +48,25 @@ inline int execute(basic_process<Executor> proc, error_code & ec)
 namespace detail
 {
 
-template<typename Executor>
+// Frees the process with the allocator it was allocated with.
+template<typename Executor, typename Allocator>
+struct execute_deleter
+{
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<basic_process<Executor>>;
+    allocator_type alloc;
+
+    void operator()(basic_process<Executor> * proc)
+    {
+        using traits = std::allocator_traits<allocator_type>;
+        traits::destroy(alloc, proc);
+        traits::deallocate(alloc, proc, 1u);
+    }
+};
+
+template<typename Executor, typename Allocator>
 struct execute_op
 {
-    std::unique_ptr<basic_process<Executor>> proc;
+    std::unique_ptr<basic_process<Executor>, execute_deleter<Executor, Allocator>> proc;
 
     struct cancel
     {
@@ -82,10 +105,38 @@ struct execute_op
     void operator()(Self && self, error_code ec, int res)
     { 
         self.get_cancellation_state().slot().clear();
+        // free the process before the upcall, so the handler can reuse the memory.
+        proc.reset();
         self.complete(ec, res);
     }
 };
 
+template<typename Executor>
+struct initiate_execute
+{
+    // The process gets allocated with the handler's allocator, which defaults to the recycling allocator,
+    // so that repeated executions reuse the memory of the previous one.
+    template<typename Handler>
+    void operator()(Handler && handler, basic_process<Executor> proc) const
+    {
+        using handler_type = typename std::decay<Handler>::type;
+        using allocator_type = typename net::associated_allocator<
+                handler_type, net::recycling_allocator<void>>::type;
+        using deleter_type = execute_deleter<Executor, allocator_type>;
+        using traits = std::allocator_traits<typename deleter_type::allocator_type>;
+
+        typename deleter_type::allocator_type alloc{
+                net::get_associated_allocator(handler, net::recycling_allocator<void>())};
+        auto p = traits::allocate(alloc, 1u);
+        traits::construct(alloc, p, std::move(proc));
+        std::unique_ptr<basic_process<Executor>, deleter_type> pro_(p, deleter_type{alloc});
+
+        auto exec = pro_->get_executor();
+        net::async_compose<handler_type, void(error_code, int)>(
+                execute_op<Executor, allocator_type>{std::move(pro_)}, handler, exec);
+    }
+};
+
 }
 
 /// Execute a process asynchronously
@@ -107,13 +158,11 @@ template<typename Executor = net::any_io_executor,
 inline
 auto async_execute(basic_process<Executor> proc,
                          WaitHandler && handler = net::default_completion_token_t<Executor>())
-   -> decltype(net::async_compose<WaitHandler, void(error_code, int)>(
-                  detail::execute_op<Executor>{nullptr}, handler, std::declval<Executor>()))
+   -> decltype(net::async_initiate<WaitHandler, void(error_code, int)>(
+                  detail::initiate_execute<Executor>{}, handler, std::move(proc)))
 {
-    std::unique_ptr<basic_process<Executor>> pro_(new basic_process<Executor>(std::move(proc)));
-    auto exec = pro_->get_executor();
-    return net::async_compose<WaitHandler, void(error_code, int)>(
-            detail::execute_op<Executor>{std::move(pro_)}, handler, exec);
+    return net::async_initiate<WaitHandler, void(error_code, int)>(
+            detail::initiate_execute<Executor>{}, handler, std::move(proc));
 }
 
 BOOST_PROCESS_V2_END_NAMESPACE
@@ -12,5 +12,6 @@
 #include <boost/process/v2/ext/cwd.hpp>
 #include <boost/process/v2/ext/env.hpp>
 #include <boost/process/v2/ext/exe.hpp>
+#include <boost/process/v2/ext/snapshot.hpp>
 
 #endif //BOOST_PROCESS_V2_EXT_HPP
@@ -0,0 +1,206 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_EXT_SNAPSHOT_HPP
+#define BOOST_PROCESS_V2_EXT_SNAPSHOT_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/cstring_ref.hpp>
+#include <boost/process/v2/pid.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace ext {
+
+/// Gathers information about many processes at once (linux only).
+/** Where `cmd`, `cwd`, `exe` & `env` open a new path and allocate a result for every call,
+ * a snapshot keeps a handle to `/proc` open, reads the files relative to it
+ * directly into one buffer and keeps all results in that buffer.
+ * Updating a snapshot reuses its memory, so a monitor that scrapes periodically
+ * doesn't allocate once the buffer has grown large enough.
+ *
+ * @par Example
+ * @code {.cpp}
+ * ext::snapshot snap;
+ * snap.update(all_pids(), ext::snapshot::cmd | ext::snapshot::exe);
+ * for (auto && e : snap)
+ *   if (!e.error)
+ *     std::cout << e.pid << ": " << e.exe << std::endl;
+ * @endcode
+ *
+ * The results are views into the snapshot, that stay valid until the next update.
+ */
+struct snapshot
+{
+    /// The fields to gather, which can be combined with `|`.
+    enum field : unsigned
+    {
+        cmd = 1u,
+        cwd = 2u,
+        exe = 4u,
+        env = 8u,
+        all = cmd | cwd | exe | env
+    };
+
+    /// A sequence of null terminated strings, as used by the command line and the environment.
+    struct string_list
+    {
+        struct iterator
+        {
+            using value_type = cstring_ref;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const cstring_ref *;
+            using reference = cstring_ref;
+            using iterator_category = std::forward_iterator_tag;
+
+            iterator() = default;
+            explicit iterator(const char * pos) : pos_(pos) {}
+
+            cstring_ref operator*() const {return cstring_ref(pos_);}
+            iterator & operator++()
+            {
+                pos_ += std::strlen(pos_) + 1u;
+                return *this;
+            }
+            iterator operator++(int)
+            {
+                auto last = *this;
+                ++(*this);
+                return last;
+            }
+
+            friend bool operator==(const iterator & lhs, const iterator & rhs) {return lhs.pos_ == rhs.pos_;}
+            friend bool operator!=(const iterator & lhs, const iterator & rhs) {return lhs.pos_ != rhs.pos_;}
+          private:
+            const char * pos_ = nullptr;
+        };
+
+        string_list() = default;
+        string_list(const char * data, std::size_t size) : data_(data), size_(size) {}
+
+        iterator begin() const {return iterator(data_);}
+        iterator end()   const {return iterator(data_ + size_);}
+        bool empty() const {return size_ == 0u;}
+        /// The raw data, i.e. all strings including their null terminators.
+        string_view raw() const {return string_view(data_, size_);}
+
+      private:
+        const char * data_ = nullptr;
+        std::size_t size_ = 0u;
+    };
+
+    /// The information gathered about one process.
+    struct entry
+    {
+        pid_type pid;
+        /// The first error that occurred, e.g. `no_such_file_or_directory` if the process exited.
+        /** Fields that couldn't be read are empty, but the others are still available. */
+        error_code error;
+        string_list cmd;
+        cstring_ref cwd;
+        cstring_ref exe;
+        string_list env;
+    };
+
+    /// Open `/proc`, throws on failure.
+    BOOST_PROCESS_V2_DECL snapshot();
+    /// Open `/proc`.
+    BOOST_PROCESS_V2_DECL explicit snapshot(error_code & ec);
+
+    snapshot(const snapshot &) = delete;
+    snapshot& operator=(const snapshot &) = delete;
+    BOOST_PROCESS_V2_DECL snapshot(snapshot && lhs) noexcept;
+    BOOST_PROCESS_V2_DECL snapshot& operator=(snapshot && lhs) noexcept;
+    BOOST_PROCESS_V2_DECL ~snapshot();
+
+    /// Replace the content with the `fields` of the given processes.
+    /** Errors of individual processes are reported in their entry, `ec` only on failure to read at all. */
+    BOOST_PROCESS_V2_DECL void update(const pid_type * pids, std::size_t count, unsigned fields, error_code & ec);
+    BOOST_PROCESS_V2_DECL void update(const pid_type * pids, std::size_t count, unsigned fields = all);
+
+    void update(const std::vector<pid_type> & pids, unsigned fields, error_code & ec)
+    {
+        update(pids.data(), pids.size(), fields, ec);
+    }
+
+    void update(const std::vector<pid_type> & pids, unsigned fields = all)
+    {
+        update(pids.data(), pids.size(), fields);
+    }
+
+    struct const_iterator
+    {
+        using value_type = entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const entry *;
+        using reference = entry;
+        using iterator_category = std::forward_iterator_tag;
+
+        const_iterator() = default;
+        const_iterator(const snapshot * snap, std::size_t idx) : snap_(snap), idx_(idx) {}
+
+        entry operator*() const {return (*snap_)[idx_];}
+        const_iterator & operator++() {idx_++; return *this;}
+        const_iterator operator++(int) {auto last = *this; idx_++; return last;}
+
+        friend bool operator==(const const_iterator & lhs, const const_iterator & rhs) {return lhs.idx_ == rhs.idx_;}
+        friend bool operator!=(const const_iterator & lhs, const const_iterator & rhs) {return lhs.idx_ != rhs.idx_;}
+      private:
+        const snapshot * snap_ = nullptr;
+        std::size_t idx_ = 0u;
+    };
+
+    const_iterator begin() const {return const_iterator(this, 0u);}
+    const_iterator end()   const {return const_iterator(this, records_.size());}
+
+    std::size_t size() const {return records_.size();}
+    bool empty() const {return records_.empty();}
+
+    /// Get the entry for the n-th pid of the last update.
+    BOOST_PROCESS_V2_DECL entry operator[](std::size_t idx) const;
+
+    /// The number of bytes the snapshot currently uses for its results.
+    std::size_t buffer_size() const {return size_;}
+
+  private:
+    // offsets into the buffer, which can move when it grows.
+    struct record
+    {
+        pid_type pid;
+        error_code error;
+        std::size_t offset[4];
+        std::size_t length[4];
+    };
+
+    int proc_fd_ = -1;
+    std::vector<record> records_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t size_ = 0u;
+    std::size_t capacity_ = 0u;
+
+    void reserve_(std::size_t extra);
+    std::size_t read_file_(const char * path, error_code & ec);
+    std::size_t read_link_(const char * path, error_code & ec);
+};
+
+inline snapshot::field operator|(snapshot::field lhs, snapshot::field rhs)
+{
+    return static_cast<snapshot::field>(static_cast<unsigned>(lhs) | static_cast<unsigned>(rhs));
+}
+
+} // namespace ext
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif // BOOST_PROCESS_V2_EXT_SNAPSHOT_HPP
@@ -0,0 +1,551 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_LAUNCH_SCHEDULER_HPP
+#define BOOST_PROCESS_V2_LAUNCH_SCHEDULER_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+#include <boost/process/v2/default_launcher.hpp>
+#include <boost/process/v2/process.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/compose.hpp>
+#include <asio/steady_timer.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/steady_timer.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+/// Limits the number of concurrently running processes, queueing launches until a slot is free.
+/** Every launch takes a slot, which is held until the process exits, i.e. until the slot
+ * handed out with the process gets destroyed or released.
+ * Launch requests that can't be served right away get queued & started in the order of:
+ *
+ *  1. their priority, higher first.
+ *  2. the fair share of their tenant, i.e. tenants get slots in proportion to their weight,
+ *     regardless of how many requests they queued.
+ *  3. the order they were queued in.
+ *
+ * If a launch fails with `resource_unavailable_try_again` (i.e. `fork` returned `EAGAIN`) while
+ * other processes are running, the request is put back at the front of the queue,
+ * waiting for the next slot to free up.
+ *
+ * @par Example
+ * @code {.cpp}
+ * asio::io_context ctx;
+ * launch_scheduler sched{ctx, 64};
+ * sched.async_launch(
+ *      tenant_id, priority, "/usr/bin/job", {"--batch"},
+ *      [](error_code ec, process proc, launch_scheduler::slot sl)
+ *      {
+ *          // the slot gets released when the wait completes.
+ *          proc.async_wait(asio::consign(asio::detached, std::move(sl)));
+ *      });
+ * // or let the scheduler wait
+ * sched.async_execute(tenant_id, priority, "/usr/bin/job", {"--batch"},
+ *                     [](error_code ec, int exit_code) {});
+ * @endcode
+ *
+ * @note The scheduler is not thread-safe, it should only be used from its executor.
+ */
+template<typename Executor = net::any_io_executor, typename Launcher = default_process_launcher>
+struct basic_launch_scheduler
+{
+    /// The executor of the scheduler & its processes.
+    using executor_type = Executor;
+    /// The launcher used to start the processes, see `bind_launcher` to add initializers.
+    using launcher_type = Launcher;
+    /// The identifier of a tenant for the fair share.
+    using tenant_type = std::size_t;
+
+    /// Rebinds the scheduler to another executor.
+    template<typename Executor1>
+    struct rebind_executor
+    {
+        /// The scheduler type when rebound to the specified executor.
+        typedef basic_launch_scheduler<Executor1, Launcher> other;
+    };
+
+  private:
+    struct state;
+  public:
+
+    /// A running slot, that is released when destroyed.
+    struct slot
+    {
+        slot() = default;
+        slot(const slot & ) = delete;
+        slot& operator=(const slot & ) = delete;
+        slot(slot && lhs) noexcept : state_(std::move(lhs.state_)) {}
+        slot& operator=(slot && lhs) noexcept
+        {
+            release();
+            state_ = std::move(lhs.state_);
+            return *this;
+        }
+        ~slot()
+        {
+            release();
+        }
+
+        /// Release the slot, so another process can be launched.
+        void release()
+        {
+            if (auto st = std::move(state_))
+                st->release();
+        }
+
+        /// Check if the slot is held.
+        explicit operator bool() const {return state_ != nullptr;}
+      private:
+        friend struct basic_launch_scheduler;
+        explicit slot(std::shared_ptr<state> st) : state_(std::move(st)) {}
+        std::shared_ptr<state> state_;
+    };
+
+    /// Create a scheduler allowing `max_running` processes to run concurrently.
+    basic_launch_scheduler(executor_type exec, std::size_t max_running, launcher_type launcher = launcher_type{})
+        : state_(std::make_shared<state>(std::move(exec), max_running, std::move(launcher)))
+    {
+    }
+
+    /// Create a scheduler allowing `max_running` processes to run concurrently.
+    template <typename ExecutionContext>
+    basic_launch_scheduler(ExecutionContext & context, std::size_t max_running, launcher_type launcher = launcher_type{},
+                           typename std::enable_if<
+                               std::is_convertible<ExecutionContext&,
+                                    net::execution_context&>::value, void *>::type = nullptr)
+        : basic_launch_scheduler(executor_type(context.get_executor()), max_running, std::move(launcher))
+    {
+    }
+
+    basic_launch_scheduler(basic_launch_scheduler && ) = default;
+    basic_launch_scheduler& operator=(basic_launch_scheduler && lhs)
+    {
+        cancel();
+        state_ = std::move(lhs.state_);
+        return *this;
+    }
+
+    /// Cancels all queued launches. Running processes are not affected.
+    ~basic_launch_scheduler()
+    {
+        cancel();
+    }
+
+    /// Get the executor of the scheduler.
+    executor_type get_executor() const {return state_->exec;}
+
+    /// The maximum number of concurrently running processes.
+    std::size_t max_running() const {return state_->max_running;}
+    /// Change the maximum number of running processes, raising it starts queued launches.
+    void max_running(std::size_t value)
+    {
+        state_->max_running = value;
+        state_->grant();
+    }
+
+    /// The number of slots currently held.
+    std::size_t running() const {return state_->running;}
+    /// The number of queued launches.
+    std::size_t queued() const {return state_->queued;}
+
+    /// Set the weight of a tenant for the fair share, the default is 1.
+    /** A tenant with weight 2 gets twice as many slots as one with weight 1, if both have launches queued. */
+    void set_weight(tenant_type tenant, unsigned weight)
+    {
+        state_->tenants[tenant].weight = weight == 0u ? 1u : weight;
+    }
+
+    /// Cancel all queued launches, which complete with `operation_aborted`.
+    void cancel()
+    {
+        if (!state_)
+            return;
+        auto & st = *state_;
+        for (auto & t : st.tenants)
+        {
+            for (auto & w : t.second.queue)
+                w->timer.cancel();
+            t.second.queue.clear();
+        }
+        st.queued = 0u;
+    }
+
+  private:
+    // one queued launch, woken up by cancelling its timer.
+    struct waiter
+    {
+        waiter(const executor_type & exec, tenant_type tenant, int priority, std::uint64_t seq)
+            : timer(exec, std::chrono::steady_clock::time_point::max()),
+              tenant(tenant), priority(priority), seq(seq)
+        {
+        }
+
+        net::basic_waitable_timer<std::chrono::steady_clock,
+                                  net::wait_traits<std::chrono::steady_clock>,
+                                  executor_type> timer;
+        tenant_type tenant;
+        int priority;
+        std::uint64_t seq;
+        bool granted = false;
+    };
+
+    struct tenant_state
+    {
+        unsigned weight = 1u;
+        // the virtual time this tenant's last slot finished, i.e. start-time fair queuing
+        double finish = 0.;
+        // sorted by priority, then seq
+        std::deque<std::shared_ptr<waiter>> queue;
+    };
+
+    struct state
+    {
+        state(executor_type exec, std::size_t max_running, launcher_type launcher)
+            : exec(std::move(exec)), max_running(max_running), launcher(std::move(launcher))
+        {
+        }
+
+        executor_type exec;
+        std::size_t max_running;
+        launcher_type launcher;
+        std::size_t running = 0u;
+        std::size_t queued  = 0u;
+        std::uint64_t seq   = 0u;
+        double vtime = 0.;
+        std::map<tenant_type, tenant_state> tenants;
+
+        // charge a slot to the tenant
+        void charge(tenant_type tenant)
+        {
+            auto & t = tenants[tenant];
+            const auto start = (std::max)(vtime, t.finish);
+            t.finish = start + 1. / t.weight;
+            vtime = start;
+            running++;
+        }
+
+        void enqueue(const std::shared_ptr<waiter> & w, bool front = false)
+        {
+            auto & q = tenants[w->tenant].queue;
+            auto itr = front
+                ? std::find_if(q.begin(), q.end(),
+                               [&](const std::shared_ptr<waiter> & o) {return o->priority <= w->priority;})
+                : std::find_if(q.begin(), q.end(),
+                               [&](const std::shared_ptr<waiter> & o) {return o->priority < w->priority;});
+            q.insert(itr, w);
+            queued++;
+        }
+
+        bool dequeue(const std::shared_ptr<waiter> & w)
+        {
+            auto t = tenants.find(w->tenant);
+            if (t == tenants.end())
+                return false;
+            auto & q = t->second.queue;
+            auto itr = std::find(q.begin(), q.end(), w);
+            if (itr == q.end())
+                return false;
+            q.erase(itr);
+            queued--;
+            return true;
+        }
+
+        // start as many queued launches as there are free slots
+        void grant()
+        {
+            while (running < max_running && queued > 0u)
+            {
+                tenant_state * best = nullptr;
+                tenant_type best_id{};
+                for (auto & t : tenants)
+                {
+                    if (t.second.queue.empty())
+                        continue;
+                    if (best == nullptr || less_(t.second, *best))
+                    {
+                        best = &t.second;
+                        best_id = t.first;
+                    }
+                }
+
+                auto w = std::move(best->queue.front());
+                best->queue.pop_front();
+                queued--;
+                charge(best_id);
+                w->granted = true;
+                w->timer.cancel();
+            }
+
+            // forget tenants that are idle & have used no more than their share
+            for (auto itr = tenants.begin(); itr != tenants.end(); )
+            {
+                if (itr->second.queue.empty() && itr->second.weight == 1u && itr->second.finish <= vtime)
+                    itr = tenants.erase(itr);
+                else
+                    itr++;
+            }
+        }
+
+        void release()
+        {
+            running--;
+            grant();
+        }
+
+      private:
+        bool less_(const tenant_state & lhs, const tenant_state & rhs) const
+        {
+            const auto & l = *lhs.queue.front();
+            const auto & r = *rhs.queue.front();
+            if (l.priority != r.priority)
+                return l.priority > r.priority;
+            const auto ls = (std::max)(vtime, lhs.finish);
+            const auto rs = (std::max)(vtime, rhs.finish);
+            if (ls != rs)
+                return ls < rs;
+            return l.seq < r.seq;
+        }
+    };
+
+    std::shared_ptr<state> state_;
+
+    // the queueing & launching, shared by async_launch & async_execute
+    template<typename Args>
+    struct launch_request_
+    {
+        std::shared_ptr<state> st;
+        std::shared_ptr<waiter> w;
+        filesystem::path exe;
+        Args args;
+
+        template<typename Self>
+        void start(Self && self)
+        {
+            auto & s = *st;
+            if (s.running < s.max_running && s.queued == 0u)
+            {
+                // still goes through the timer, so the completion doesn't happen inline.
+                s.charge(w->tenant);
+                w->granted = true;
+                w->timer.expires_at(std::chrono::steady_clock::time_point::min());
+            }
+            else
+                s.enqueue(w);
+
+            auto & t = w->timer;
+            t.async_wait(std::move(self));
+        }
+
+        // invoked when the timer completes, returns false if it's waiting again.
+        template<typename Self>
+        bool launch(Self && self, error_code & ec, basic_process<executor_type> & proc, slot & sl)
+        {
+            auto & s = *st;
+            if (!w->granted)
+            {
+                // cancelled while queued
+                s.dequeue(w);
+                if (!ec)
+                    BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::operation_aborted);
+                return true;
+            }
+
+            ec.clear();
+            sl = slot{st};
+            proc = s.launcher(s.exec, ec, exe, args);
+            if (ec == error_code(EAGAIN, system_category()) && s.running > 1u)
+            {
+                // wait for another process to exit, before trying again.
+                // the slot is given up without granting it, which would just retry right away.
+                w->granted = false;
+                w->timer.expires_at(std::chrono::steady_clock::time_point::max());
+                s.enqueue(w, true);
+                sl.state_.reset();
+                s.running--;
+                auto & t = w->timer;
+                t.async_wait(std::move(self));
+                return false;
+            }
+            if (ec)
+                sl.release();
+            return true;
+        }
+    };
+
+    template<typename Args>
+    struct async_launch_op_
+    {
+        launch_request_<Args> request;
+
+        template<typename Self>
+        void operator()(Self && self)
+        {
+            request.start(std::move(self));
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec)
+        {
+            basic_process<executor_type> proc{request.st->exec};
+            slot sl;
+            if (request.launch(self, ec, proc, sl))
+                self.complete(ec, std::move(proc), std::move(sl));
+        }
+    };
+
+    template<typename Args>
+    struct async_execute_op_
+    {
+        launch_request_<Args> request;
+        // the process needs a stable address while waiting
+        std::unique_ptr<basic_process<executor_type>> proc;
+        slot sl;
+
+        template<typename Self>
+        void operator()(Self && self)
+        {
+            request.start(std::move(self));
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec)
+        {
+            if (!request.launch(self, ec, *proc, sl))
+                return;
+            if (ec)
+                self.complete(ec, -1);
+            else
+            {
+                auto & p = *proc;
+                p.async_wait(std::move(self));
+            }
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec, int exit_code)
+        {
+            sl.release();
+            self.complete(ec, exit_code);
+        }
+    };
+
+    template<typename Args>
+    launch_request_<typename std::decay<Args>::type> make_request_(
+        tenant_type tenant, int priority, const filesystem::path & exe, Args && args)
+    {
+        auto w = std::make_shared<waiter>(state_->exec, tenant, priority, state_->seq++);
+        return launch_request_<typename std::decay<Args>::type>{
+            state_, std::move(w), exe, std::forward<Args>(args)};
+    }
+
+    static std::vector<std::string> copy_args_(std::initializer_list<string_view> args)
+    {
+        std::vector<std::string> res;
+        res.reserve(args.size());
+        for (auto & a : args)
+            res.emplace_back(a.data(), a.size());
+        return res;
+    }
+
+  public:
+    /// Launch a process once a slot is available.
+    /** The arguments get stored until the launch. The process is only running while the slot is held,
+     * so it should be released once the process exited, e.g. by binding it to `async_wait`.
+     * The slot is empty if the launch failed.
+     *
+     * Cancelling the operation removes it from the queue, if the launch hasn't happened yet.
+     *
+     * @par Completion Signature
+     * `void(error_code, basic_process<Executor>, slot)`
+     */
+    template<typename Args,
+             BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, basic_process<Executor>, slot))
+             LaunchHandler = net::default_completion_token_t<executor_type>>
+    auto async_launch(tenant_type tenant, int priority, const filesystem::path & exe, Args && args,
+                      LaunchHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<LaunchHandler, void(error_code, basic_process<Executor>, slot)>(
+                std::declval<async_launch_op_<typename std::decay<Args>::type>>(), handler, std::declval<executor_type>()))
+    {
+        return net::async_compose<LaunchHandler, void(error_code, basic_process<Executor>, slot)>(
+                async_launch_op_<typename std::decay<Args>::type>{
+                    make_request_(tenant, priority, exe, std::forward<Args>(args))},
+                handler, state_->exec);
+    }
+
+    /// Launch a process once a slot is available.
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, basic_process<Executor>, slot))
+             LaunchHandler = net::default_completion_token_t<executor_type>>
+    auto async_launch(tenant_type tenant, int priority, const filesystem::path & exe,
+                      std::initializer_list<string_view> args,
+                      LaunchHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<LaunchHandler, void(error_code, basic_process<Executor>, slot)>(
+                std::declval<async_launch_op_<std::vector<std::string>>>(), handler, std::declval<executor_type>()))
+    {
+        return net::async_compose<LaunchHandler, void(error_code, basic_process<Executor>, slot)>(
+                async_launch_op_<std::vector<std::string>>{make_request_(tenant, priority, exe, copy_args_(args))},
+                handler, state_->exec);
+    }
+
+    /// Launch a process once a slot is available & wait for it to exit, which releases the slot.
+    /**
+     * @par Completion Signature
+     * `void(error_code, int)`, with the exit code of the process.
+     */
+    template<typename Args,
+             BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, int))
+             ExecuteHandler = net::default_completion_token_t<executor_type>>
+    auto async_execute(tenant_type tenant, int priority, const filesystem::path & exe, Args && args,
+                       ExecuteHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<ExecuteHandler, void(error_code, int)>(
+                std::declval<async_execute_op_<typename std::decay<Args>::type>>(), handler,
+                std::declval<executor_type>()))
+    {
+        return net::async_compose<ExecuteHandler, void(error_code, int)>(
+                async_execute_op_<typename std::decay<Args>::type>{
+                    make_request_(tenant, priority, exe, std::forward<Args>(args)),
+                    std::unique_ptr<basic_process<executor_type>>(new basic_process<executor_type>(state_->exec)),
+                    slot()},
+                handler, state_->exec);
+    }
+
+    /// Launch a process once a slot is available & wait for it to exit, which releases the slot.
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, int))
+             ExecuteHandler = net::default_completion_token_t<executor_type>>
+    auto async_execute(tenant_type tenant, int priority, const filesystem::path & exe,
+                       std::initializer_list<string_view> args,
+                       ExecuteHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<ExecuteHandler, void(error_code, int)>(
+                std::declval<async_execute_op_<std::vector<std::string>>>(), handler,
+                std::declval<executor_type>()))
+    {
+        return net::async_compose<ExecuteHandler, void(error_code, int)>(
+                async_execute_op_<std::vector<std::string>>{
+                    make_request_(tenant, priority, exe, copy_args_(args)),
+                    std::unique_ptr<basic_process<executor_type>>(new basic_process<executor_type>(state_->exec)),
+                    slot()},
+                handler, state_->exec);
+    }
+};
+
+/// A launch_scheduler with the default executor & launcher.
+typedef basic_launch_scheduler<> launch_scheduler;
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_LAUNCH_SCHEDULER_HPP
@@ -8,9 +8,16 @@
 #include <boost/process/v2/detail/config.hpp>
 #include <boost/process/v2/cstring_ref.hpp>
 #include <boost/process/v2/posix/detail/close_handles.hpp>
+#include <boost/process/v2/posix/executable_handle.hpp>
+#include <boost/process/v2/posix/launch_trace.hpp>
 #include <boost/process/v2/detail/throw_error.hpp>
 #include <boost/process/v2/detail/utf8.hpp>
 
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+#include <boost/process/v2/posix/fork_safety.hpp>
+#include <typeinfo>
+#endif
+
 #if defined(BOOST_PROCESS_V2_STANDALONE)
 #include <asio/execution/executor.hpp>
 #include <asio/is_executor.hpp>
@@ -25,6 +32,8 @@
 #include <boost/asio/query.hpp>
 #endif
 
+#include <algorithm>
+
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -202,6 +211,9 @@ inline auto invoke_on_exec_setup(Launcher & launcher, const filesystem::path &ex
                                  Init && init, derived && )
 -> decltype(init.on_exec_setup(launcher, executable, cmd_line))
 {
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+    posix::detail::fork_safety_scope scope{typeid(init).name()};
+#endif
     return init.on_exec_setup(launcher, executable, cmd_line);
 }
 
@@ -271,6 +283,9 @@ struct default_launcher
     /// The whitelist for file descriptors.
     std::vector<int> fd_whitelist = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
 
+    /// An optional hook that gets the timestamps of every launch, e.g. launch_histograms.
+    launch_tracer * tracer = nullptr;
+
     default_launcher() = default;
 
     template<typename ExecutionContext, typename Args, typename ... Inits>
@@ -344,16 +359,25 @@ struct default_launcher
                 BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
                 return basic_process<Executor>{exec};
             }
+            // the descriptors added for this launch get dropped afterwards, so a reused launcher doesn't grow.
+            const auto whitelist_size = fd_whitelist.size();
+            trace_begin_();
             ec = detail::on_setup(*this, executable, argv, inits ...);
+            trace_mark_(&launch_timestamps::setup_done);
             if (ec)
             {
+                fd_whitelist.resize(whitelist_size);
                 detail::on_error(*this, executable, argv, ec, inits...);
+                trace_end_(ec);
                 return basic_process<Executor>(exec);
             }
             fd_whitelist.push_back(pg.p[1]);
 
             auto & ctx = net::query(
                     exec, net::execution::context);
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+            posix::detail::fork_safety_guard safety;
+#endif
 #if !defined(BOOST_PROCESS_V2_DISABLE_NOTIFY_FORK)
             ctx.notify_fork(net::execution_context::fork_prepare);
 #endif
@@ -363,25 +387,33 @@ struct default_launcher
 #if !defined(BOOST_PROCESS_V2_DISABLE_NOTIFY_FORK)
                 ctx.notify_fork(net::execution_context::fork_parent);
 #endif
+                fd_whitelist.resize(whitelist_size);
                 detail::on_fork_error(*this, executable, argv, ec, inits...);
                 detail::on_error(*this, executable, argv, ec, inits...);
 
                 BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
+                trace_end_(ec);
                 return basic_process<Executor>{exec};
             }
             else if (pid == 0)
             {
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+                safety.enter_child();
+#endif
+                trace_mark_(&launch_timestamps::child_start);
                 ::close(pg.p[0]);
 #if !defined(BOOST_PROCESS_V2_DISABLE_NOTIFY_FORK)
                 ctx.notify_fork(net::execution_context::fork_child);
 #endif
                 ec = detail::on_exec_setup(*this, executable, argv, inits...);
+                trace_mark_(&launch_timestamps::exec_setup_done);
                 if (!ec)
                 {
                     close_all_fds(ec);
                 }                
+                trace_report_(pg.p[1]);
                 if (!ec)
-                    ::execve(executable.c_str(), const_cast<char * const *>(argv), const_cast<char * const *>(env));
+                    detail::exec_descriptor(exec_fd_, executable.c_str(), argv, env);
 
                 ignore_unused(::write(pg.p[1], &errno, sizeof(int)));
                 BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
@@ -389,40 +421,187 @@ struct default_launcher
                 ::exit(EXIT_FAILURE);
                 return basic_process<Executor>{exec};
             }
+            trace_mark_(&launch_timestamps::forked);
 #if !defined(BOOST_PROCESS_V2_DISABLE_NOTIFY_FORK)
             ctx.notify_fork(net::execution_context::fork_parent);
 #endif
+            fd_whitelist.resize(whitelist_size);
             ::close(pg.p[1]);
             pg.p[1] = -1;
-            int child_error{0};
-            int count = -1;
-            while ((count = ::read(pg.p[0], &child_error, sizeof(child_error))) == -1)
-            {
-                int err = errno;
-                if ((err != EAGAIN) && (err != EINTR))
-                {
-                    BOOST_PROCESS_V2_ASSIGN_EC(ec, err, system_category());
-                    break;
-                }
-            }
-            if (count != 0)
-                BOOST_PROCESS_V2_ASSIGN_EC(ec, child_error, system_category());
+            read_error_pipe_(pg.p[0], ec);
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+            safety.finish(ec);
+#endif
 
             if (ec)
             {
                 detail::on_error(*this, executable, argv, ec, inits...);
                 do { ::waitpid(pid, nullptr, 0); } while (errno == EINTR);
+                trace_end_(ec);
                 return basic_process<Executor>{exec};
             }
         }
         basic_process<Executor> proc(exec, pid);
         detail::on_success(*this, executable, argv, ec, inits...);
+        trace_end_(ec);
+        return proc;
+
+    }
+
+    /// Launch the executable through its open descriptor, instead of looking up its path.
+    template<typename ExecutionContext, typename Args, typename ... Inits>
+    auto operator()(ExecutionContext & context,
+                    const typename std::enable_if<std::is_convertible<
+                            ExecutionContext&, net::execution_context&>::value,
+                            executable_handle >::type & executable,
+                    Args && args,
+                    Inits && ... inits ) -> basic_process<typename ExecutionContext::executor_type>
+    {
+        error_code ec;
+        auto proc =  (*this)(context.get_executor(), ec, executable, std::forward<Args>(args), std::forward<Inits>(inits)...);
+
+        if (ec)
+            v2::detail::throw_error(ec, "default_launcher");
+
         return proc;
+    }
 
+    /// Launch the executable through its open descriptor, instead of looking up its path.
+    template<typename ExecutionContext, typename Args, typename ... Inits>
+    auto operator()(ExecutionContext & context,
+                    error_code & ec,
+                    const typename std::enable_if<std::is_convertible<
+                            ExecutionContext&, net::execution_context&>::value,
+                            executable_handle >::type & executable,
+                    Args && args,
+                    Inits && ... inits ) -> basic_process<typename ExecutionContext::executor_type>
+    {
+        return (*this)(context.get_executor(), ec, executable, std::forward<Args>(args), std::forward<Inits>(inits)...);
+    }
+
+    /// Launch the executable through its open descriptor, instead of looking up its path.
+    template<typename Executor, typename Args, typename ... Inits>
+    auto operator()(Executor exec,
+                    const typename std::enable_if<
+                            net::execution::is_executor<Executor>::value ||
+                            net::is_executor<Executor>::value,
+                            executable_handle >::type & executable,
+                    Args && args,
+                    Inits && ... inits ) -> basic_process<Executor>
+    {
+        error_code ec;
+        auto proc =  (*this)(std::move(exec), ec, executable, std::forward<Args>(args), std::forward<Inits>(inits)...);
+
+        if (ec)
+            v2::detail::throw_error(ec, "default_launcher");
+
+        return proc;
+    }
+
+    /// Launch the executable through its open descriptor, instead of looking up its path.
+    template<typename Executor, typename Args, typename ... Inits>
+    auto operator()(Executor exec,
+                    error_code & ec,
+                    const typename std::enable_if<
+                            net::execution::is_executor<Executor>::value ||
+                            net::is_executor<Executor>::value,
+                            executable_handle >::type & executable,
+                    Args && args,
+                    Inits && ... inits ) -> basic_process<Executor>
+    {
+        // the descriptor needs to survive close_all_fds in the child, it gets closed by the exec.
+        exec_fd_ = executable.native_handle();
+        if (exec_fd_ != -1)
+            fd_whitelist.push_back(exec_fd_);
+        auto proc = (*this)(std::move(exec), ec, executable.path(), std::forward<Args>(args), std::forward<Inits>(inits)...);
+        if (exec_fd_ != -1)
+            fd_whitelist.erase(std::remove(fd_whitelist.begin(), fd_whitelist.end(), exec_fd_), fd_whitelist.end());
+        exec_fd_ = -1;
+        return proc;
     }
   protected:
 
     void ignore_unused(std::size_t ) {}
+
+    // the descriptor of the executable if launched from an executable_handle, otherwise the path gets used.
+    int exec_fd_ = -1;
+
+    // the timestamps of the current launch, only recorded if there's a tracer.
+    launch_timestamps trace_{};
+
+    void trace_begin_()
+    {
+        if (tracer)
+        {
+            trace_ = launch_timestamps{};
+            trace_.start = detail::monotonic_now();
+        }
+    }
+
+    void trace_mark_(std::uint64_t launch_timestamps::* ts)
+    {
+        if (tracer)
+            trace_.*ts = detail::monotonic_now();
+    }
+
+    // called by the child right before exec, passing its timestamps to the parent through the error pipe.
+    void trace_report_(int fd)
+    {
+        if (!tracer)
+            return;
+        trace_.exec_start = detail::monotonic_now();
+        ignore_unused(::write(fd, &trace_, sizeof(trace_)));
+    }
+
+    void trace_end_(const error_code & ec)
+    {
+        if (!tracer)
+            return;
+        trace_.done = detail::monotonic_now();
+        tracer->on_launch(trace_, ec);
+    }
+
+    // reads until the pipe is closed or the data is complete, returns the number of bytes read.
+    std::size_t read_pipe_(int fd, void * data, std::size_t size, error_code & ec)
+    {
+        std::size_t n = 0u;
+        while (n < size)
+        {
+            const auto count = ::read(fd, static_cast<char*>(data) + n, size - n);
+            if (count > 0)
+                n += static_cast<std::size_t>(count);
+            else if (count == 0)
+                break;
+            else if ((errno != EAGAIN) && (errno != EINTR))
+            {
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
+                break;
+            }
+        }
+        return n;
+    }
+
+    // waits for the child to exec, which closes the error pipe. 
+    // If it fails it writes errno into the pipe, preceded by its timestamps if traced.
+    void read_error_pipe_(int fd, error_code & ec)
+    {
+        if (tracer)
+        {
+            launch_timestamps child;
+            if (read_pipe_(fd, &child, sizeof(child), ec) == sizeof(child))
+            {
+                trace_.child_start     = child.child_start;
+                trace_.exec_setup_done = child.exec_setup_done;
+                trace_.exec_start      = child.exec_start;
+            }
+            if (ec)
+                return;
+        }
+
+        int child_error{0};
+        if (read_pipe_(fd, &child_error, sizeof(child_error), ec) != 0u && !ec)
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, child_error, system_category());
+    }
     void close_all_fds(error_code & ec)
     {
         std::sort(fd_whitelist.begin(), fd_whitelist.end());
@@ -456,6 +635,8 @@ struct default_launcher
                                                      cstring_ref>::value>::type * = nullptr)
     {
         const auto arg_cnt = std::distance(std::begin(args), std::end(args));
+        // the launcher might get reused, so drop the arguments of the last launch.
+        argv_.clear();
         argv_.reserve(arg_cnt + 2);
         argv_.push_back(pt.native().data());
         for (auto && arg : args)
@@ -478,6 +659,8 @@ struct default_launcher
                                                       cstring_ref>::value>::type * = nullptr)
     {
         const auto arg_cnt = std::distance(std::begin(args), std::end(args));
+        argv_.clear();
+        argv_buffer_.clear();
         argv_.reserve(arg_cnt + 2);
         argv_buffer_.reserve(arg_cnt);
         argv_.push_back(pt.native().data());
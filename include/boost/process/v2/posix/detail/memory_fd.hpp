@@ -0,0 +1,39 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_DETAIL_MEMORY_FD_HPP
+#define BOOST_PROCESS_V2_POSIX_DETAIL_MEMORY_FD_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+#include <cstdint>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+// Creates a sealed, read-only in-memory file (memfd on linux, an unlinked temporary file elsewhere)
+// holding a copy of data, positioned at its beginning. The descriptor is opened with FD_CLOEXEC.
+BOOST_PROCESS_V2_DECL int open_memory_fd(const void * data, std::size_t size, error_code & ec);
+
+// Creates a writable in-memory file of the given size to be shared with a subprocess through mmap.
+// The descriptor is opened with FD_CLOEXEC.
+BOOST_PROCESS_V2_DECL int create_shared_memory_fd(std::size_t size, error_code & ec);
+
+// Opens a region of a file for reading. A region that extends to the end of the file
+// is passed as the file itself, otherwise it gets copied into a memory fd by the kernel.
+BOOST_PROCESS_V2_DECL int open_file_region(const filesystem::path & pth,
+                                           std::uint64_t offset, std::uint64_t length,
+                                           error_code & ec);
+
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_POSIX_DETAIL_MEMORY_FD_HPP
@@ -0,0 +1,163 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_DETAIL_PIDFD_WAIT_SET_HPP
+#define BOOST_PROCESS_V2_POSIX_DETAIL_PIDFD_WAIT_SET_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/wait_any.hpp>
+
+#include <cstdint>
+#include <memory>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/associated_executor.hpp>
+#include <asio/posix/basic_stream_descriptor.hpp>
+#include <asio/post.hpp>
+#else
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/posix/basic_stream_descriptor.hpp>
+#include <boost/asio/post.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+// A pending wait on a pidfd_wait_set, completed with an error & an exit code.
+struct pidfd_waiter
+{
+    virtual void complete(error_code ec, int exit_code) = 0;
+    virtual ~pidfd_waiter() = default;
+};
+
+template<typename Self, typename Executor>
+struct pidfd_waiter_impl final : pidfd_waiter
+{
+    Self self;
+    Executor exec;
+
+    pidfd_waiter_impl(Self && self, Executor exec) : self(std::move(self)), exec(std::move(exec)) {}
+
+    struct resume_
+    {
+        Self self;
+        error_code ec;
+        int exit_code;
+
+        void operator()()
+        {
+            self(ec, exit_code);
+        }
+    };
+
+    // posted, so a handler can wait again or destroy the owner while a batch gets completed.
+    void complete(error_code ec, int exit_code) override
+    {
+        auto ex = net::get_associated_executor(self, exec);
+        net::post(ex, resume_{std::move(self), ec, exit_code});
+    }
+};
+
+// An epoll set of pidfds, which takes a single descriptor in the reactor.
+// It's the base of the shared state of its owner, which provides
+//
+//   void on_exit(std::uint64_t key);  // the pidfd added with key became readable, i.e. the process exited.
+//   void on_error(error_code ec);     // waiting failed, all pending waits need to complete with ec.
+//   bool waiting() const;             // if there are pending waits, so the set needs to be waited for.
+template<typename Executor>
+struct basic_pidfd_wait_set
+{
+    net::posix::basic_stream_descriptor<Executor> set;
+    bool armed = false;
+
+    explicit basic_pidfd_wait_set(Executor exec) : set(std::move(exec))
+    {
+        error_code ec;
+        const int fd = v2::detail::open_wait_set(ec);
+        if (!ec)
+        {
+            set.assign(fd, ec);
+            if (ec)
+                v2::detail::close_wait_set(fd);
+        }
+        if (ec)
+            v2::detail::throw_error(ec, "epoll_create1");
+    }
+
+    void add(int pidfd, std::uint64_t key, error_code & ec)
+    {
+        v2::detail::add_to_wait_set(set.native_handle(), pidfd, key, ec);
+    }
+
+    void remove(int pidfd)
+    {
+        error_code ign;
+        v2::detail::remove_from_wait_set(set.native_handle(), pidfd, ign);
+    }
+
+    // makes a pending wait of the set complete with operation_aborted.
+    void cancel()
+    {
+        error_code ign;
+        set.cancel(ign);
+    }
+
+    // waits for the set, unless it's already waited for or nobody is waiting.
+    template<typename State>
+    static void arm(const std::shared_ptr<State> & st)
+    {
+        if (st->armed || !st->waiting())
+            return;
+        st->armed = true;
+        st->set.async_wait(net::posix::descriptor_base::wait_read, on_ready_<State>{st});
+    }
+
+  private:
+    template<typename State>
+    struct on_ready_
+    {
+        std::shared_ptr<State> st;
+
+        void operator()(error_code ec)
+        {
+            st->armed = false;
+            if (!ec)
+            {
+                std::uint64_t ready[64];
+                std::size_t n;
+                do
+                {
+                    n = v2::detail::drain_wait_set(st->set.native_handle(), ready, 64u, ec);
+                    for (std::size_t i = 0u; i < n; i++)
+                        st->on_exit(ready[i]);
+                }
+                while (n == 64u && !ec);
+            }
+
+            if (ec && ec != net::error::operation_aborted)
+                st->on_error(ec);
+            // new waits might have been added after a cancel
+            arm(st);
+        }
+    };
+};
+
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_POSIX_DETAIL_PIDFD_WAIT_SET_HPP
@@ -0,0 +1,365 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_DETAIL_SHM_RING_HPP
+#define BOOST_PROCESS_V2_POSIX_DETAIL_SHM_RING_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/error.hpp>
+#else
+#include <boost/asio/error.hpp>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// This header is used by the child side as well, so it must stay header-only.
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+// The descriptors of a channel, in the order they get passed to the child.
+enum shm_channel_fd : int
+{
+    shm_memory_fd           = 0, // the memfd holding the header & both rings
+    shm_child_readable_fd   = 1, // rung when the parent wrote data
+    shm_child_writable_fd   = 2, // rung when the parent freed space
+    shm_parent_readable_fd  = 3, // rung when the child wrote data
+    shm_parent_writable_fd  = 4, // rung when the child freed space
+    shm_fd_count            = 5
+};
+
+constexpr std::uint32_t shm_channel_magic   = 0x68737062u; // "bpsh"
+constexpr std::uint32_t shm_channel_version = 1u;
+
+// One single-producer single-consumer ring. The positions grow monotonically,
+// the waiting flags tell the other side to ring a doorbell.
+struct shm_ring_state
+{
+    // written by the consumer
+    alignas(64) std::atomic<std::uint64_t> head;
+    std::atomic<std::uint32_t> consumer_waiting;
+    std::atomic<std::uint32_t> reader_closed;
+    // written by the producer
+    alignas(64) std::atomic<std::uint64_t> tail;
+    std::atomic<std::uint32_t> producer_waiting;
+    std::atomic<std::uint32_t> writer_closed;
+};
+
+// rings[0] is parent -> child, rings[1] is child -> parent
+struct shm_channel_header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t capacity;
+    shm_ring_state rings[2];
+};
+
+#if defined(__cpp_lib_atomic_is_always_lock_free)
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free
+           && std::atomic<std::uint32_t>::is_always_lock_free,
+              "the shm channel requires address-free atomics");
+#endif
+
+// One side of a shared memory channel.
+struct shm_endpoint
+{
+    shm_channel_header * header = nullptr;
+    unsigned char * data = nullptr;
+    std::size_t mapped_size = 0u;
+    int side = 0; // 0 = parent, 1 = child
+    int fds[shm_fd_count] = {-1, -1, -1, -1, -1};
+
+    static std::size_t header_size()
+    {
+        return (sizeof(shm_channel_header) + 63u) & ~static_cast<std::size_t>(63u);
+    }
+
+    static std::size_t mapping_size(std::size_t capacity)
+    {
+        return header_size() + 2u * capacity;
+    }
+
+    // maps the memory of fds[shm_memory_fd]; validate is used by the child.
+    bool map(std::size_t size, bool validate, error_code & ec)
+    {
+        void * p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[shm_memory_fd], 0);
+        if (p == MAP_FAILED)
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
+            return false;
+        }
+        header = static_cast<shm_channel_header*>(p);
+        data = static_cast<unsigned char*>(p) + header_size();
+        mapped_size = size;
+
+        if (validate
+            && (   header->magic != shm_channel_magic
+                || header->version != shm_channel_version
+                || header->capacity == 0u
+                || (header->capacity & (header->capacity - 1u)) != 0u
+                || mapping_size(static_cast<std::size_t>(header->capacity)) > size))
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+            unmap();
+            return false;
+        }
+        return true;
+    }
+
+    // maps the memory of the child side and checks the header written by the parent.
+    bool attach(error_code & ec)
+    {
+        struct stat st;
+        if (::fstat(fds[shm_memory_fd], &st) == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
+            return false;
+        }
+        if (static_cast<std::size_t>(st.st_size) < header_size())
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+            return false;
+        }
+        return map(static_cast<std::size_t>(st.st_size), true, ec);
+    }
+
+    // initializes the header on the parent side.
+    void init(std::size_t capacity)
+    {
+        new (header) shm_channel_header();
+        header->magic = shm_channel_magic;
+        header->version = shm_channel_version;
+        header->capacity = capacity;
+        for (auto & r : header->rings)
+        {
+            r.head.store(0u);
+            r.consumer_waiting.store(0u);
+            r.reader_closed.store(0u);
+            r.tail.store(0u);
+            r.producer_waiting.store(0u);
+            r.writer_closed.store(0u);
+        }
+    }
+
+    void unmap()
+    {
+        if (header != nullptr)
+            ::munmap(header, mapped_size);
+        header = nullptr;
+        data = nullptr;
+        mapped_size = 0u;
+    }
+
+    std::size_t capacity() const {return header ? static_cast<std::size_t>(header->capacity) : 0u;}
+
+    shm_ring_state & out_ring() {return header->rings[side];}
+    shm_ring_state & in_ring()  {return header->rings[1 - side];}
+    unsigned char * out_data() {return data + side * capacity();}
+    unsigned char * in_data()  {return data + (1 - side) * capacity();}
+
+    int own_readable()  const {return fds[side == 0 ? shm_parent_readable_fd : shm_child_readable_fd];}
+    int own_writable()  const {return fds[side == 0 ? shm_parent_writable_fd : shm_child_writable_fd];}
+    int peer_readable() const {return fds[side == 0 ? shm_child_readable_fd  : shm_parent_readable_fd];}
+    int peer_writable() const {return fds[side == 0 ? shm_child_writable_fd  : shm_parent_writable_fd];}
+
+    static void ring(int fd)
+    {
+        const std::uint64_t one = 1u;
+        while (::write(fd, &one, sizeof(one)) == -1 && errno == EINTR);
+    }
+
+    // the doorbells are non-blocking, so this doesn't block if another waiter drained it.
+    static void drain(int fd)
+    {
+        std::uint64_t cnt;
+        while (::read(fd, &cnt, sizeof(cnt)) == -1 && errno == EINTR);
+    }
+
+    // the peer won't write anymore, i.e. reading yields eof once the ring is drained.
+    bool input_closed()
+    {
+        return in_ring().writer_closed.load(std::memory_order_acquire) != 0u;
+    }
+
+    // the peer won't read anymore, i.e. writing yields broken_pipe.
+    bool output_closed()
+    {
+        return out_ring().reader_closed.load(std::memory_order_acquire) != 0u;
+    }
+
+    // Write as much as fits into the ring without blocking.
+    std::size_t write_some(const void * buf, std::size_t n)
+    {
+        auto & r = out_ring();
+        const auto cap  = capacity();
+        const auto tail = r.tail.load(std::memory_order_relaxed);
+        const auto head = r.head.load(std::memory_order_acquire);
+        n = (std::min)(n, static_cast<std::size_t>(cap - (tail - head)));
+        if (n == 0u)
+            return 0u;
+
+        const auto pos   = static_cast<std::size_t>(tail & (cap - 1u));
+        const auto first = (std::min)(n, cap - pos);
+        std::memcpy(out_data() + pos, buf, first);
+        std::memcpy(out_data(), static_cast<const unsigned char*>(buf) + first, n - first);
+        r.tail.store(tail + n, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (r.consumer_waiting.load(std::memory_order_relaxed) != 0u
+            && r.consumer_waiting.exchange(0u) != 0u)
+            ring(peer_readable());
+        return n;
+    }
+
+    // Read what's available in the ring without blocking.
+    std::size_t read_some(void * buf, std::size_t n)
+    {
+        auto & r = in_ring();
+        const auto cap  = capacity();
+        const auto head = r.head.load(std::memory_order_relaxed);
+        const auto tail = r.tail.load(std::memory_order_acquire);
+        n = (std::min)(n, static_cast<std::size_t>(tail - head));
+        if (n == 0u)
+            return 0u;
+
+        const auto pos   = static_cast<std::size_t>(head & (cap - 1u));
+        const auto first = (std::min)(n, cap - pos);
+        std::memcpy(buf, in_data() + pos, first);
+        std::memcpy(static_cast<unsigned char*>(buf) + first, in_data(), n - first);
+        r.head.store(head + n, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (r.producer_waiting.load(std::memory_order_relaxed) != 0u
+            && r.producer_waiting.exchange(0u) != 0u)
+            ring(peer_writable());
+        return n;
+    }
+
+    // Announce that we're about to wait for own_readable(). Returns false if there's no need to.
+    bool prepare_read_wait()
+    {
+        auto & r = in_ring();
+        r.consumer_waiting.store(1u, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (r.tail.load(std::memory_order_acquire) != r.head.load(std::memory_order_relaxed) || input_closed())
+        {
+            r.consumer_waiting.store(0u, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // Announce that we're about to wait for own_writable(). Returns false if there's no need to.
+    bool prepare_write_wait()
+    {
+        auto & r = out_ring();
+        r.producer_waiting.store(1u, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if ((r.tail.load(std::memory_order_relaxed) - r.head.load(std::memory_order_acquire)) < capacity()
+            || output_closed())
+        {
+            r.producer_waiting.store(0u, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // Signal the end of our output to the peer, like shutdown(SHUT_WR) on a socket.
+    void shutdown_write()
+    {
+        out_ring().writer_closed.store(1u, std::memory_order_release);
+        ring(peer_readable());
+    }
+
+    // Mark both directions as closed & wake up the peer.
+    void close_side()
+    {
+        out_ring().writer_closed.store(1u, std::memory_order_release);
+        in_ring().reader_closed.store(1u, std::memory_order_release);
+        ring(peer_readable());
+        ring(peer_writable());
+    }
+
+    static bool wait_for(int fd, error_code & ec)
+    {
+        ::pollfd pfd{fd, POLLIN, 0};
+        while (::poll(&pfd, 1, -1) == -1)
+        {
+            if (errno != EINTR)
+            {
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
+                return false;
+            }
+        }
+        drain(fd);
+        return true;
+    }
+
+    // Blocking read of at least one byte, eof if the peer closed its output.
+    std::size_t read_blocking(void * buf, std::size_t n, error_code & ec)
+    {
+        if (n == 0u)
+            return 0u;
+        for (;;)
+        {
+            auto res = read_some(buf, n);
+            if (res > 0u)
+                return res;
+            if (input_closed())
+            {
+                res = read_some(buf, n);
+                if (res == 0u)
+                    BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::eof);
+                return res;
+            }
+            if (prepare_read_wait() && !wait_for(own_readable(), ec))
+                return 0u;
+        }
+    }
+
+    // Blocking write of at least one byte, broken_pipe if the peer closed the channel.
+    std::size_t write_blocking(const void * buf, std::size_t n, error_code & ec)
+    {
+        if (n == 0u)
+            return 0u;
+        for (;;)
+        {
+            if (output_closed())
+            {
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::broken_pipe);
+                return 0u;
+            }
+            const auto res = write_some(buf, n);
+            if (res > 0u)
+                return res;
+            if (prepare_write_wait() && !wait_for(own_writable(), ec))
+                return 0u;
+        }
+    }
+};
+
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_POSIX_DETAIL_SHM_RING_HPP
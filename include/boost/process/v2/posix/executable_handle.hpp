@@ -0,0 +1,160 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_EXECUTABLE_HANDLE_HPP
+#define BOOST_PROCESS_V2_POSIX_EXECUTABLE_HANDLE_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+#include <boost/process/v2/detail/throw_error.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+// Executes the file referred to by fd, i.e. execveat with AT_EMPTY_PATH on linux and fexecve elsewhere.
+// Falls back to execve of the path if the system can't execute a descriptor.
+// Only returns on error; it is async-signal-safe.
+BOOST_PROCESS_V2_DECL void exec_descriptor(int fd, const char * path,
+                                           const char * const * argv, const char * const * env);
+
+}
+
+/// An open descriptor of an executable, that can be launched in place of its path.
+/** Launching through the descriptor spares the kernel the path lookup for every launch
+ * and keeps the executable alive, even if it gets replaced on disk.
+ *
+ * The descriptor is opened with FD_CLOEXEC, which is fine for binaries, but means an
+ * interpreted script (i.e. starting with `#!`) can't be executed this way on linux.
+ */
+struct executable_handle
+{
+    /// Construct an empty handle.
+    executable_handle() = default;
+
+    /// Open the executable at `exe`.
+    explicit executable_handle(const filesystem::path & exe, error_code & ec)
+    {
+        open_(exe, ec);
+    }
+
+    /// Open the executable at `exe`.
+    explicit executable_handle(const filesystem::path & exe)
+    {
+        error_code ec;
+        open_(exe, ec);
+        if (ec)
+            v2::detail::throw_error(ec, "executable_handle");
+    }
+
+    executable_handle(const executable_handle & ) = delete;
+    executable_handle& operator=(const executable_handle & ) = delete;
+
+    executable_handle(executable_handle && lhs) noexcept
+        : path_(std::move(lhs.path_)), fd_(lhs.fd_)
+    {
+        lhs.fd_ = -1;
+    }
+
+    executable_handle& operator=(executable_handle && lhs) noexcept
+    {
+        close_();
+        path_ = std::move(lhs.path_);
+        fd_ = lhs.fd_;
+        lhs.fd_ = -1;
+        return *this;
+    }
+
+    ~executable_handle()
+    {
+        close_();
+    }
+
+    /// The path the executable got opened from, used as `argv[0]`.
+    const filesystem::path & path() const {return path_;}
+
+    /// The open descriptor of the executable.
+    int native_handle() const {return fd_;}
+
+    /// Check if the handle holds an executable.
+    bool is_open() const {return fd_ != -1;}
+
+    /// Ask the kernel to read the executable into the page cache, so the first launch doesn't fault it in from disk.
+    /** This doesn't wait for the read to finish. */
+    BOOST_PROCESS_V2_DECL void prefetch(error_code & ec);
+
+    /// Ask the kernel to read the executable into the page cache, so the first launch doesn't fault it in from disk.
+    void prefetch()
+    {
+        error_code ec;
+        prefetch(ec);
+        if (ec)
+            v2::detail::throw_error(ec, "prefetch");
+    }
+
+  private:
+    BOOST_PROCESS_V2_DECL void open_(const filesystem::path & exe, error_code & ec);
+    BOOST_PROCESS_V2_DECL void close_();
+
+    filesystem::path path_;
+    int fd_ = -1;
+};
+
+/// A set of executable handles, opened and prefetched the first time they're used.
+/** The references returned stay valid until the cache is cleared or destroyed. This class is not thread-safe. */
+struct executable_cache
+{
+    /// Get the handle of the executable at `exe`, opening and prefetching it if it isn't in the cache yet.
+    const executable_handle & get(const filesystem::path & exe, error_code & ec)
+    {
+        auto itr = handles_.find(exe.native());
+        if (itr != handles_.end())
+            return itr->second;
+
+        executable_handle handle{exe, ec};
+        if (ec)
+            return empty_;
+
+        // a failed prefetch only makes the first launch slower.
+        error_code ign;
+        handle.prefetch(ign);
+        return handles_.emplace(exe.native(), std::move(handle)).first->second;
+    }
+
+    /// Get the handle of the executable at `exe`, opening and prefetching it if it isn't in the cache yet.
+    const executable_handle & get(const filesystem::path & exe)
+    {
+        error_code ec;
+        auto & res = get(exe, ec);
+        if (ec)
+            v2::detail::throw_error(ec, "executable_cache");
+        return res;
+    }
+
+    /// Remove the executable from the cache, e.g. after it got updated on disk.
+    void erase(const filesystem::path & exe) {handles_.erase(exe.native());}
+
+    /// Remove all executables from the cache.
+    void clear() {handles_.clear();}
+
+    /// The number of cached executables.
+    std::size_t size() const {return handles_.size();}
+
+  private:
+    std::unordered_map<std::string, executable_handle> handles_;
+    executable_handle empty_;
+};
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_POSIX_EXECUTABLE_HANDLE_HPP
@@ -0,0 +1,187 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_FORK_REGIONS_HPP
+#define BOOST_PROCESS_V2_POSIX_FORK_REGIONS_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/detail/throw_error.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+/// How a registered region is kept out of a forked child.
+enum class fork_region_mode
+{
+    /// `MADV_DONTFORK`: the region isn't mapped in the child, touching it crashes the child.
+    dont_fork,
+    /// `MADV_WIPEONFORK`: the child gets zero-filled pages. Private anonymous memory only, linux 4.14 or later.
+    wipe_on_fork
+};
+
+/// A set of memory regions that forked children don't need, e.g. arena blocks or caches.
+/** While the regions are excluded, `fork` doesn't copy their page tables,
+ * which dominates its cost for processes with large heaps.
+ * Use the `exclude_fork_regions` initializer to exclude them around a launch only,
+ * so other code forking the process isn't affected.
+ *
+ * Regions are shrunk to whole pages, so memory sharing a page with a region is never excluded.
+ * A region must be removed before its memory gets unmapped or freed.
+ *
+ * All functions are thread-safe; exclusions nest, so concurrent launches can share a registry.
+ */
+struct fork_region_registry
+{
+    fork_region_registry() = default;
+    fork_region_registry(const fork_region_registry & ) = delete;
+    fork_region_registry& operator=(const fork_region_registry & ) = delete;
+
+    /// Restores all regions.
+    BOOST_PROCESS_V2_DECL ~fork_region_registry();
+
+    /// Register a region. Fails with `invalid_argument` if it doesn't contain a whole page or overlaps another region.
+    /** If the regions are currently excluded, the new one gets excluded right away. */
+    BOOST_PROCESS_V2_DECL void add(void * addr, std::size_t size, fork_region_mode mode, error_code & ec);
+
+    /// Throwing @overload void add(void * addr, std::size_t size, fork_region_mode mode, error_code & ec)
+    void add(void * addr, std::size_t size, fork_region_mode mode = fork_region_mode::dont_fork)
+    {
+        error_code ec;
+        add(addr, size, mode, ec);
+        if (ec)
+            v2::detail::throw_error(ec, "fork_region_registry::add");
+    }
+
+    /// Remove the region registered at `addr`, restoring it if it is excluded.
+    BOOST_PROCESS_V2_DECL void remove(void * addr);
+
+    /// Check if any byte of [addr, addr + size) is excluded while the regions are.
+    BOOST_PROCESS_V2_DECL bool overlaps(const void * addr, std::size_t size) const;
+
+    /// The number of registered regions.
+    BOOST_PROCESS_V2_DECL std::size_t size() const;
+    /// The number of bytes in all registered regions.
+    BOOST_PROCESS_V2_DECL std::size_t bytes() const;
+
+    /// Exclude all regions from children forked from now on.
+    /** Only the first of nested calls applies the advice. If a region can't be excluded,
+     * the ones before it get restored and the error is returned. */
+    BOOST_PROCESS_V2_DECL void exclude(error_code & ec);
+    /// Undo one call to `exclude`, the last one restores the regions.
+    BOOST_PROCESS_V2_DECL void restore();
+    /// Check if the regions are currently excluded.
+    BOOST_PROCESS_V2_DECL bool excluded() const;
+
+  private:
+    struct region
+    {
+        // the registered address, used as the key for remove
+        void * addr;
+        // the page aligned range that gets excluded
+        std::uintptr_t begin, end;
+        fork_region_mode mode;
+    };
+
+    mutable std::mutex mutex_;
+    // sorted by begin
+    std::vector<region> regions_;
+    std::size_t excluded_ = 0u;
+};
+
+/// An initializer, excluding the regions of a registry while the process gets launched.
+/** Before the regions are excluded, it checks that the executable, the arguments
+ * and the environment passed to the child, as well as the launcher itself, don't lie in a region;
+ * otherwise the launch fails with `bad_address` instead of a crashing child.
+ * Initializers that touch other memory in `on_exec_setup` can check it with
+ * `fork_region_registry::overlaps` in their `on_setup`.
+ */
+struct exclude_fork_regions
+{
+    fork_region_registry & registry;
+
+    explicit exclude_fork_regions(fork_region_registry & registry) : registry(registry) {}
+
+    // in case the launch threw before on_success or on_error got invoked.
+    ~exclude_fork_regions()
+    {
+        restore_();
+    }
+
+    template<typename Launcher>
+    error_code on_setup(Launcher & launcher, const filesystem::path & executable, const char * const * (&cmd_line))
+    {
+        error_code ec;
+        if (touches_(&launcher, sizeof(launcher)) || touches_(executable.c_str())
+            || touches_(cmd_line) || touches_(launcher.env))
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, EFAULT, system_category());
+            return ec;
+        }
+        registry.exclude(ec);
+        applied_ = !ec;
+        return ec;
+    }
+
+    template<typename Launcher>
+    void on_success(Launcher & , const filesystem::path &, const char * const * (&))
+    {
+        restore_();
+    }
+
+    template<typename Launcher>
+    void on_error(Launcher & , const filesystem::path &, const char * const * (&), const error_code & )
+    {
+        restore_();
+    }
+
+  private:
+    bool applied_ = false;
+
+    void restore_()
+    {
+        if (applied_)
+            registry.restore();
+        applied_ = false;
+    }
+
+    bool touches_(const void * addr, std::size_t size) const
+    {
+        return registry.overlaps(addr, size);
+    }
+
+    bool touches_(const char * str) const
+    {
+        return str != nullptr && registry.overlaps(str, std::char_traits<char>::length(str) + 1u);
+    }
+
+    // a null terminated array of strings, i.e. argv or the environment.
+    bool touches_(const char * const * strs) const
+    {
+        if (strs == nullptr)
+            return false;
+        std::size_t n = 0u;
+        for (; strs[n] != nullptr; n++)
+            if (touches_(strs[n]))
+                return true;
+        return registry.overlaps(strs, (n + 1u) * sizeof(*strs));
+    }
+};
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_POSIX_FORK_REGIONS_HPP
@@ -0,0 +1,87 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_FORK_SAFETY_HPP
+#define BOOST_PROCESS_V2_POSIX_FORK_SAFETY_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#include <cstdint>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+/// What a forked child did between fork and exec.
+/** Only recorded if both the library and the application are built with `BOOST_PROCESS_V2_CHECK_FORK_SAFETY`,
+ * which interposes the allocator, the pthread locks and common system call wrappers of libc.
+ *
+ * In the child of a multithreaded parent, another thread might have held a lock in the moment of the fork,
+ * that never gets released in the child. So calling malloc or taking a lock in `on_exec_setup` can deadlock.
+ * In this mode, the child gets terminated at the first such call of an initializer,
+ * and the launch fails with `resource_deadlock_would_occur`.
+ */
+struct fork_safety_report
+{
+    /// The calls to malloc, free & friends, including the ones made by the launcher itself.
+    std::uint32_t allocations = 0u;
+    /// The acquisitions of pthread mutexes & rwlocks, including the ones made by the launcher itself.
+    std::uint32_t locks = 0u;
+    /// The system calls made through the checked libc wrappers, e.g. close, dup2, fcntl, chdir or execve.
+    std::uint32_t syscalls = 0u;
+    /// The type name of the initializer that made an unsafe call, or null.
+    const char * offender = nullptr;
+    /// The unsafe call, e.g. "malloc", or null.
+    const char * call = nullptr;
+
+    /// Check if an initializer made an unsafe call.
+    bool violated() const {return offender != nullptr;}
+};
+
+/// A function invoked in the parent with the report of every checked launch.
+typedef void (*fork_safety_handler)(const fork_safety_report & report);
+
+/// Install a handler, returning the previous one. The default handler prints violations to stderr.
+BOOST_PROCESS_V2_DECL fork_safety_handler set_fork_safety_handler(fork_safety_handler handler) noexcept;
+
+namespace detail
+{
+
+// Created by a launcher in the parent before forking, holding the report shared with the child.
+struct fork_safety_guard
+{
+    BOOST_PROCESS_V2_DECL fork_safety_guard() noexcept;
+    BOOST_PROCESS_V2_DECL ~fork_safety_guard();
+    fork_safety_guard(const fork_safety_guard & ) = delete;
+    fork_safety_guard& operator=(const fork_safety_guard & ) = delete;
+
+    // Called in the child right after the fork, starts recording.
+    BOOST_PROCESS_V2_DECL void enter_child() noexcept;
+    // Called in the parent once the child has exec'd or failed. Invokes the handler & fails the launch on a violation.
+    BOOST_PROCESS_V2_DECL void finish(error_code & ec) noexcept;
+
+  private:
+    fork_safety_report * report_;
+};
+
+// Marks the initializer whose on_exec_setup runs in the child, unsafe calls in its scope are violations.
+struct fork_safety_scope
+{
+    BOOST_PROCESS_V2_DECL explicit fork_safety_scope(const char * initializer) noexcept;
+    BOOST_PROCESS_V2_DECL ~fork_safety_scope();
+    fork_safety_scope(const fork_safety_scope & ) = delete;
+    fork_safety_scope& operator=(const fork_safety_scope & ) = delete;
+
+  private:
+    const char * previous_;
+};
+
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_POSIX_FORK_SAFETY_HPP
@@ -0,0 +1,673 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_JOBSERVER_HPP
+#define BOOST_PROCESS_V2_POSIX_JOBSERVER_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+#include <boost/process/v2/detail/complete_immediately.hpp>
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/default_launcher.hpp>
+#include <boost/process/v2/environment.hpp>
+#include <boost/process/v2/execute.hpp>
+#include <boost/process/v2/process.hpp>
+
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/associated_allocator.hpp>
+#include <asio/compose.hpp>
+#include <asio/posix/basic_stream_descriptor.hpp>
+#include <asio/recycling_allocator.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/posix/basic_stream_descriptor.hpp>
+#include <boost/asio/recycling_allocator.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+// The token pipe given by `--jobserver-auth=R,W`, `--jobserver-fds=R,W` or `--jobserver-auth=fifo:PATH`.
+struct jobserver_auth
+{
+    int read_fd  = -1;
+    int write_fd = -1;
+    std::string fifo;
+};
+
+// Finds the last jobserver option in MAKEFLAGS, returns false if there is none or it's disabled.
+BOOST_PROCESS_V2_DECL bool parse_jobserver_auth(string_view makeflags, jobserver_auth & auth);
+
+// Opens descriptors of the token pipe owned by this process, with a non-blocking read end.
+BOOST_PROCESS_V2_DECL void open_jobserver(const jobserver_auth & auth, int & read_fd, int & write_fd, error_code & ec);
+
+// Creates a token pipe holding `tokens` tokens, fails with EINVAL if the pipe can't hold them.
+BOOST_PROCESS_V2_DECL void create_jobserver(std::size_t tokens, int & read_fd, int & write_fd, error_code & ec);
+
+// Replaces the jobserver & -j options of makeflags with ones for the given pipe.
+BOOST_PROCESS_V2_DECL std::string jobserver_makeflags(string_view makeflags, std::size_t jobs,
+                                                      int read_fd, int write_fd);
+
+// Reads a token without blocking, returns false if none is available.
+BOOST_PROCESS_V2_DECL bool take_jobserver_token(int fd, char & token, error_code & ec);
+
+// Writes a token back into the pipe.
+BOOST_PROCESS_V2_DECL void put_jobserver_token(int fd, char token);
+
+}
+
+/// An initializer passing a jobserver on to a subprocess, i.e. a nested make.
+/** It keeps the descriptors of the token pipe open in the subprocess and sets `MAKEFLAGS`
+ * through the overlay `env`, which should be used to set other variables too, since another
+ * environment initializer would drop `MAKEFLAGS`.
+ */
+struct inherit_jobserver
+{
+    /// The environment of the subprocess, including `MAKEFLAGS` if this process is the jobserver.
+    environment::overlay env;
+    /// The read end of the token pipe, -1 if it doesn't need to be inherited.
+    int read_fd  = -1;
+    /// The write end of the token pipe, -1 if it doesn't need to be inherited.
+    int write_fd = -1;
+
+    error_code on_setup(posix::default_launcher & launcher, const filesystem::path & exe, const char * const * cmd_line)
+    {
+        if (!env.empty())
+        {
+            auto ec = env.on_setup(launcher, exe, cmd_line);
+            if (ec)
+                return ec;
+        }
+        if (read_fd != -1)
+            launcher.fd_whitelist.push_back(read_fd);
+        if (write_fd != -1)
+            launcher.fd_whitelist.push_back(write_fd);
+        return error_code{};
+    }
+
+    /// Implementation of the initialization function.
+    error_code on_exec_setup(posix::default_launcher & /*launcher*/, const filesystem::path &, const char * const *)
+    {
+        // the pipe created by a jobserver is FD_CLOEXEC, but needs to survive the exec.
+        if (read_fd != -1 && ::fcntl(read_fd, F_SETFD, 0) == -1)
+            return error_code(errno, system_category());
+        if (write_fd != -1 && ::fcntl(write_fd, F_SETFD, 0) == -1)
+            return error_code(errno, system_category());
+        return error_code ();
+    }
+};
+
+/// A GNU make jobserver, limiting the processes running concurrently across nested builds.
+/** A jobserver is a pipe holding one byte per job that may run in addition to the ones already
+ * running; every process owns one implicit token, which it needs no byte for. Before a process gets
+ * launched, a token has to be acquired and the token is released once the process exited.
+ *
+ * The jobserver either connects to the one given by `MAKEFLAGS` (i.e. when run by `make -j`),
+ * or creates its own pipe, which gets passed to subprocesses through `inherit()`. If there is no
+ * jobserver in `MAKEFLAGS`, the client only has its implicit token, i.e. it runs one job at a time,
+ * like make does.
+ *
+ * @par Example
+ * @code {.cpp}
+ * asio::io_context ctx;
+ * // use the jobserver of make, if any.
+ * posix::jobserver js{ctx};
+ * // or be the jobserver of nested builds, with 8 jobs.
+ * posix::jobserver js{ctx, 8};
+ * js.async_execute("/usr/bin/make", {"-C", "subdir"}, [](error_code ec, int exit_code) {});
+ * @endcode
+ *
+ * The read end of the pipe gets opened again, so it can be non-blocking without affecting other
+ * processes using it. Where that isn't possible (i.e. without `/proc`), the shared read end is set
+ * to non-blocking.
+ *
+ * @note The jobserver is not thread-safe, it should only be used from its executor.
+ */
+template<typename Executor = net::any_io_executor, typename Launcher = default_process_launcher>
+struct basic_jobserver
+{
+    /// The executor of the jobserver & its processes.
+    using executor_type = Executor;
+    /// The launcher used to start the processes, see `bind_launcher` to add initializers.
+    using launcher_type = Launcher;
+
+    /// Rebinds the jobserver to another executor.
+    template<typename Executor1>
+    struct rebind_executor
+    {
+        /// The jobserver type when rebound to the specified executor.
+        typedef basic_jobserver<Executor1, Launcher> other;
+    };
+
+  private:
+    struct state;
+  public:
+
+    /// A job token, that is released when destroyed.
+    struct token
+    {
+        token() = default;
+        token(const token & ) = delete;
+        token& operator=(const token & ) = delete;
+        token(token && lhs) noexcept
+            : state_(std::move(lhs.state_)), value_(lhs.value_), implicit_(lhs.implicit_)
+        {
+        }
+        token& operator=(token && lhs) noexcept
+        {
+            release();
+            state_ = std::move(lhs.state_);
+            value_ = lhs.value_;
+            implicit_ = lhs.implicit_;
+            return *this;
+        }
+        ~token()
+        {
+            release();
+        }
+
+        /// Release the token, so another job can run.
+        void release()
+        {
+            if (auto st = std::move(state_))
+                st->release(value_, implicit_);
+        }
+
+        /// Check if this is the implicit token of this process, which isn't taken from the pipe.
+        bool implicit() const {return state_ != nullptr && implicit_;}
+
+        /// Check if the token is held.
+        explicit operator bool() const {return state_ != nullptr;}
+      private:
+        friend struct basic_jobserver;
+        token(std::shared_ptr<state> st, char value, bool implicit)
+            : state_(std::move(st)), value_(value), implicit_(implicit)
+        {
+        }
+        std::shared_ptr<state> state_;
+        char value_ = '+';
+        bool implicit_ = false;
+    };
+
+    /// Connect to the jobserver in the `MAKEFLAGS` of the current environment.
+    /** Fails with `bad_descriptor` if the descriptors of the jobserver aren't open, which make does
+     * for recipes that aren't marked with `+`.
+     */
+    basic_jobserver(executor_type exec, error_code & ec, launcher_type launcher = launcher_type{})
+        : state_(std::make_shared<state>(std::move(exec), std::move(launcher)))
+    {
+        connect_(ec);
+    }
+
+    /// Connect to the jobserver in the `MAKEFLAGS` of the current environment.
+    explicit basic_jobserver(executor_type exec, launcher_type launcher = launcher_type{})
+        : state_(std::make_shared<state>(std::move(exec), std::move(launcher)))
+    {
+        error_code ec;
+        connect_(ec);
+        if (ec)
+            v2::detail::throw_error(ec, "jobserver");
+    }
+
+    /// Connect to the jobserver in the `MAKEFLAGS` of the current environment.
+    template <typename ExecutionContext>
+    explicit basic_jobserver(ExecutionContext & context,
+                             typename std::enable_if<
+                                 std::is_convertible<ExecutionContext&,
+                                     net::execution_context&>::value, void *>::type = nullptr)
+        : basic_jobserver(executor_type(context.get_executor()))
+    {
+    }
+
+    /// Create a jobserver allowing `jobs` processes to run concurrently, this one included.
+    /** Fails with `invalid_argument` if the pipe can't hold `jobs - 1` tokens, even after growing it. */
+    basic_jobserver(executor_type exec, std::size_t jobs, error_code & ec, launcher_type launcher = launcher_type{})
+        : state_(std::make_shared<state>(std::move(exec), std::move(launcher)))
+    {
+        create_(jobs, ec);
+    }
+
+    /// Create a jobserver allowing `jobs` processes to run concurrently, this one included.
+    basic_jobserver(executor_type exec, std::size_t jobs, launcher_type launcher = launcher_type{})
+        : state_(std::make_shared<state>(std::move(exec), std::move(launcher)))
+    {
+        error_code ec;
+        create_(jobs, ec);
+        if (ec)
+            v2::detail::throw_error(ec, "jobserver");
+    }
+
+    /// Create a jobserver allowing `jobs` processes to run concurrently, this one included.
+    template <typename ExecutionContext>
+    basic_jobserver(ExecutionContext & context, std::size_t jobs,
+                    typename std::enable_if<
+                        std::is_convertible<ExecutionContext&,
+                            net::execution_context&>::value, void *>::type = nullptr)
+        : basic_jobserver(executor_type(context.get_executor()), jobs)
+    {
+    }
+
+    basic_jobserver(basic_jobserver && ) = default;
+    basic_jobserver& operator=(basic_jobserver && lhs)
+    {
+        cancel();
+        state_ = std::move(lhs.state_);
+        return *this;
+    }
+
+    /// Cancels all pending acquisitions. Tokens & running processes are not affected.
+    ~basic_jobserver()
+    {
+        cancel();
+    }
+
+    /// Get the executor of the jobserver.
+    executor_type get_executor() const {return state_->read.get_executor();}
+
+    /// Check if this process created the jobserver, instead of connecting to one.
+    bool is_server() const {return state_->server;}
+
+    /// Check if the tokens are shared with other processes, i.e. a jobserver was created or found.
+    bool is_shared() const {return state_->shared;}
+
+    /// The initializer passing the jobserver on to a subprocess.
+    /** It's added to every launch of the jobserver, but can be used with any launch. */
+    inherit_jobserver & inherit() {return state_->inherit;}
+
+    /// Cancel all pending acquisitions, which complete with `operation_aborted`.
+    void cancel()
+    {
+        if (state_)
+            state_->read.cancel();
+    }
+
+  private:
+    struct state
+    {
+        state(executor_type exec, launcher_type launcher)
+            : read(std::move(exec)), launcher(std::move(launcher))
+        {
+        }
+
+        ~state()
+        {
+            // the implicit token got written into the pipe & has to be taken back, if it's still there.
+            char c;
+            error_code ec;
+            if (implicit_lent && read.is_open())
+                detail::take_jobserver_token(read.native_handle(), c, ec);
+            if (write_fd != -1)
+                ::close(write_fd);
+            if (server)
+            {
+                ::close(inherit.read_fd);
+                ::close(inherit.write_fd);
+            }
+        }
+
+        net::posix::basic_stream_descriptor<executor_type> read;
+        int write_fd = -1;
+        launcher_type launcher;
+        inherit_jobserver inherit;
+        bool server = false;
+        bool shared = false;
+        bool implicit_available = true;
+        // the implicit token was handed to a waiter through the pipe.
+        bool implicit_lent = false;
+        std::size_t waiting = 0u;
+
+        bool try_acquire(char & value, bool & implicit, error_code & ec)
+        {
+            implicit = implicit_available;
+            if (implicit_available)
+            {
+                implicit_available = false;
+                return true;
+            }
+            return detail::take_jobserver_token(read.native_handle(), value, ec);
+        }
+
+        void release(char value, bool implicit)
+        {
+            if (implicit)
+            {
+                // waiters are waiting on the pipe, so the implicit token needs to go through it.
+                if (waiting > 0u)
+                {
+                    detail::put_jobserver_token(write_fd, '+');
+                    implicit_lent = true;
+                }
+                else
+                    implicit_available = true;
+            }
+            else if (implicit_lent && waiting == 0u)
+            {
+                // keep the token in place of the lent implicit one.
+                implicit_lent = false;
+                implicit_available = true;
+            }
+            else
+                detail::put_jobserver_token(write_fd, value);
+        }
+    };
+
+    std::shared_ptr<state> state_;
+
+    void open_(const detail::jobserver_auth & auth, error_code & ec)
+    {
+        int rfd = -1, wfd = -1;
+        detail::open_jobserver(auth, rfd, wfd, ec);
+        if (ec)
+            return;
+        state_->write_fd = wfd;
+        state_->read.assign(rfd, ec);
+        if (ec)
+            ::close(rfd);
+    }
+
+    void connect_(error_code & ec)
+    {
+        const auto makeflags = ::getenv("MAKEFLAGS");
+        detail::jobserver_auth auth;
+        if (makeflags != nullptr && detail::parse_jobserver_auth(makeflags, auth))
+        {
+            // the pipe of make is inherited, so it needs to be passed on. a fifo gets opened by name.
+            if (auth.fifo.empty())
+            {
+                state_->inherit.read_fd  = auth.read_fd;
+                state_->inherit.write_fd = auth.write_fd;
+            }
+            state_->shared = true;
+            open_(auth, ec);
+        }
+        else
+            // a private pipe without tokens, so waiters get woken up by the implicit token.
+            create_(1u, ec, false);
+    }
+
+    void create_(std::size_t jobs, error_code & ec, bool shared = true)
+    {
+        if (jobs == 0u)
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+            return;
+        }
+        detail::jobserver_auth auth;
+        detail::create_jobserver(jobs - 1u, auth.read_fd, auth.write_fd, ec);
+        if (ec)
+            return;
+        state_->server = true;
+        open_(auth, ec);
+        if (!shared)
+        {
+            ::close(auth.read_fd);
+            ::close(auth.write_fd);
+            state_->server = false;
+            return;
+        }
+        state_->shared = true;
+        state_->inherit.read_fd  = auth.read_fd;
+        state_->inherit.write_fd = auth.write_fd;
+        const auto makeflags = ::getenv("MAKEFLAGS");
+        state_->inherit.env.set("MAKEFLAGS",
+                                detail::jobserver_makeflags(makeflags ? makeflags : "",
+                                                            jobs, auth.read_fd, auth.write_fd));
+    }
+
+    struct async_acquire_op_
+    {
+        std::shared_ptr<state> st;
+        bool waited = false;
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec = error_code{})
+        {
+            auto & s = *st;
+            if (waited)
+                s.waiting--;
+
+            char value = '+';
+            bool implicit = false;
+            token tk;
+            if (!ec && s.try_acquire(value, implicit, ec))
+                tk = token{st, value, implicit};
+            else if (!ec)
+            {
+                // another process might take the token first, so this can wake up without one.
+                waited = true;
+                s.waiting++;
+                auto & rd = s.read;
+                rd.async_wait(net::posix::descriptor_base::wait_read, std::move(self));
+                return;
+            }
+
+            v2::detail::complete_immediately(std::move(self), s.read.get_executor(), ec, std::move(tk));
+        }
+    };
+
+    template<typename Args>
+    struct async_launch_op_
+    {
+        std::shared_ptr<state> st;
+        filesystem::path exe;
+        Args args;
+
+        template<typename Self>
+        void operator()(Self && self)
+        {
+            async_acquire_(st, std::move(self));
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec, token tk)
+        {
+            basic_process<executor_type> proc{st->read.get_executor()};
+            if (!ec)
+                proc = st->launcher(st->read.get_executor(), ec, exe, args, st->inherit);
+            if (ec)
+                tk.release();
+            self.complete(ec, std::move(proc), std::move(tk));
+        }
+    };
+
+    template<typename Args, typename Allocator>
+    struct async_execute_op_
+    {
+        std::shared_ptr<state> st;
+        filesystem::path exe;
+        Args args;
+        // the process needs a stable address while waiting
+        std::unique_ptr<basic_process<executor_type>, v2::detail::execute_deleter<executor_type, Allocator>> proc;
+        token tk;
+
+        template<typename Self>
+        void operator()(Self && self)
+        {
+            async_acquire_(st, std::move(self));
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec, token tk_)
+        {
+            if (!ec)
+                *proc = st->launcher(st->read.get_executor(), ec, exe, args, st->inherit);
+            if (ec)
+            {
+                proc.reset();
+                self.complete(ec, -1);
+            }
+            else
+            {
+                tk = std::move(tk_);
+                auto & p = *proc;
+                p.async_wait(std::move(self));
+            }
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec, int exit_code)
+        {
+            tk.release();
+            // free the process before the upcall, so the handler can reuse the memory.
+            proc.reset();
+            self.complete(ec, exit_code);
+        }
+    };
+
+    // The process gets allocated with the handler's allocator, which defaults to the recycling allocator,
+    // like in async_execute of a process.
+    template<typename Args>
+    struct initiate_execute_
+    {
+        std::shared_ptr<state> st;
+
+        template<typename Handler>
+        void operator()(Handler && handler, filesystem::path exe, Args args) const
+        {
+            using handler_type = typename std::decay<Handler>::type;
+            using allocator_type = typename net::associated_allocator<
+                    handler_type, net::recycling_allocator<void>>::type;
+            using deleter_type = v2::detail::execute_deleter<executor_type, allocator_type>;
+            using traits = std::allocator_traits<typename deleter_type::allocator_type>;
+
+            typename deleter_type::allocator_type alloc{
+                    net::get_associated_allocator(handler, net::recycling_allocator<void>())};
+            auto p = traits::allocate(alloc, 1u);
+            traits::construct(alloc, p, st->read.get_executor());
+            std::unique_ptr<basic_process<executor_type>, deleter_type> proc(p, deleter_type{alloc});
+
+            auto & rd = st->read;
+            net::async_compose<handler_type, void(error_code, int)>(
+                    async_execute_op_<Args, allocator_type>{st, std::move(exe), std::move(args), std::move(proc), token()},
+                    handler, rd);
+        }
+    };
+
+    template<typename AcquireHandler>
+    static auto async_acquire_(const std::shared_ptr<state> & st, AcquireHandler && handler)
+        -> decltype(net::async_compose<AcquireHandler, void(error_code, token)>(
+                std::declval<async_acquire_op_>(), handler, st->read))
+    {
+        return net::async_compose<AcquireHandler, void(error_code, token)>(
+                async_acquire_op_{st}, handler, st->read);
+    }
+
+    static std::vector<std::string> copy_args_(std::initializer_list<string_view> args)
+    {
+        std::vector<std::string> res;
+        res.reserve(args.size());
+        for (auto & a : args)
+            res.emplace_back(a.data(), a.size());
+        return res;
+    }
+
+  public:
+    /// Acquire a token, which is the implicit one if it's not in use.
+    /** Cancelling the operation or the jobserver completes it with `operation_aborted`.
+     *
+     * @par Completion Signature
+     * `void(error_code, token)`
+     */
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, token))
+             AcquireHandler = net::default_completion_token_t<executor_type>>
+    auto async_acquire(AcquireHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(async_acquire_(std::declval<const std::shared_ptr<state>&>(), std::forward<AcquireHandler>(handler)))
+    {
+        return async_acquire_(state_, std::forward<AcquireHandler>(handler));
+    }
+
+    /// Launch a process once a token is acquired, passing the jobserver on to it.
+    /** The process should only be running while the token is held,
+     * so it should be released once the process exited, e.g. by binding it to `async_wait`.
+     * The token is empty if the launch failed.
+     *
+     * @par Completion Signature
+     * `void(error_code, basic_process<Executor>, token)`
+     */
+    template<typename Args,
+             BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, basic_process<Executor>, token))
+             LaunchHandler = net::default_completion_token_t<executor_type>>
+    auto async_launch(const filesystem::path & exe, Args && args,
+                      LaunchHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<LaunchHandler, void(error_code, basic_process<Executor>, token)>(
+                std::declval<async_launch_op_<typename std::decay<Args>::type>>(), handler,
+                std::declval<net::posix::basic_stream_descriptor<executor_type>&>()))
+    {
+        return net::async_compose<LaunchHandler, void(error_code, basic_process<Executor>, token)>(
+                async_launch_op_<typename std::decay<Args>::type>{
+                    state_, exe, std::forward<Args>(args)},
+                handler, state_->read);
+    }
+
+    /// Launch a process once a token is acquired, passing the jobserver on to it.
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, basic_process<Executor>, token))
+             LaunchHandler = net::default_completion_token_t<executor_type>>
+    auto async_launch(const filesystem::path & exe, std::initializer_list<string_view> args,
+                      LaunchHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<LaunchHandler, void(error_code, basic_process<Executor>, token)>(
+                std::declval<async_launch_op_<std::vector<std::string>>>(), handler,
+                std::declval<net::posix::basic_stream_descriptor<executor_type>&>()))
+    {
+        return net::async_compose<LaunchHandler, void(error_code, basic_process<Executor>, token)>(
+                async_launch_op_<std::vector<std::string>>{state_, exe, copy_args_(args)},
+                handler, state_->read);
+    }
+
+    /// Launch a process once a token is acquired & wait for it to exit, which releases the token.
+    /**
+     * @par Completion Signature
+     * `void(error_code, int)`, with the exit code of the process.
+     */
+    template<typename Args,
+             BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, int))
+             ExecuteHandler = net::default_completion_token_t<executor_type>>
+    auto async_execute(const filesystem::path & exe, Args && args,
+                       ExecuteHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_initiate<ExecuteHandler, void(error_code, int)>(
+                std::declval<initiate_execute_<typename std::decay<Args>::type>>(), handler,
+                exe, std::forward<Args>(args)))
+    {
+        return net::async_initiate<ExecuteHandler, void(error_code, int)>(
+                initiate_execute_<typename std::decay<Args>::type>{state_}, handler,
+                exe, std::forward<Args>(args));
+    }
+
+    /// Launch a process once a token is acquired & wait for it to exit, which releases the token.
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, int))
+             ExecuteHandler = net::default_completion_token_t<executor_type>>
+    auto async_execute(const filesystem::path & exe, std::initializer_list<string_view> args,
+                       ExecuteHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_initiate<ExecuteHandler, void(error_code, int)>(
+                std::declval<initiate_execute_<std::vector<std::string>>>(), handler,
+                exe, copy_args_(args)))
+    {
+        return net::async_initiate<ExecuteHandler, void(error_code, int)>(
+                initiate_execute_<std::vector<std::string>>{state_}, handler,
+                exe, copy_args_(args));
+    }
+};
+
+/// A jobserver with the default executor & launcher.
+typedef basic_jobserver<> jobserver;
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_POSIX_JOBSERVER_HPP
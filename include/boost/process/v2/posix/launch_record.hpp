@@ -0,0 +1,619 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_LAUNCH_RECORD_HPP
+#define BOOST_PROCESS_V2_POSIX_LAUNCH_RECORD_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/default_launcher.hpp>
+#include <boost/process/v2/environment.hpp>
+#include <boost/process/v2/posix/launch_trace.hpp>
+#include <boost/process/v2/process.hpp>
+#include <boost/process/v2/stdio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/buffer.hpp>
+#include <asio/connect_pipe.hpp>
+#include <asio/io_context.hpp>
+#include <asio/post.hpp>
+#include <asio/readable_pipe.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/writable_pipe.hpp>
+#else
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/connect_pipe.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/readable_pipe.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/writable_pipe.hpp>
+#endif
+
+#include <time.h>
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+/// A launch, as stored by a `launch_recorder`.
+struct launch_record
+{
+    /// When the launch started, in nanoseconds since the recording started.
+    std::uint64_t start = 0u;
+    /// How long the launcher took, in nanoseconds.
+    std::uint64_t duration = 0u;
+    /// When the exit of the process got recorded, in nanoseconds since the recording started. Zero if it wasn't.
+    std::uint64_t exit_time = 0u;
+    /// The pid of the process, zero if the launch failed.
+    pid_type pid = 0;
+    /// The error of a failed launch, zero if it succeeded.
+    int error = 0;
+    /// The native exit code, if the exit got recorded.
+    int exit_code = 0;
+    /// The executable as passed to the launcher.
+    std::string executable;
+    /// The number of arguments including `argv[0]`, and their size including the terminators.
+    std::uint32_t argc = 0u;
+    std::uint32_t argv_bytes = 0u;
+    /// The number of environment variables, and their size including the terminators.
+    std::uint32_t envc = 0u;
+    std::uint32_t env_bytes = 0u;
+    /// The type names of the initializers passed to the launcher.
+    std::vector<std::string> initializers;
+};
+
+namespace detail
+{
+
+// What a recording_launcher collects during a launch, without allocating.
+struct launch_sample
+{
+    std::uint64_t start;
+    std::uint64_t duration;
+    pid_type pid;
+    int error;
+    const char * executable;
+    std::uint32_t argc, argv_bytes, envc, env_bytes;
+    // typeid names, null terminated.
+    const char * const * initializers;
+};
+
+}
+
+/// A log of launches in a compact binary file, to replay them with `replay_launches`.
+/** The launches get recorded by a `recording_launcher`; their exits need to be recorded explicitly,
+ * e.g. after waiting for the process. A replay counts the launches without one in `replay_report::unmatched`.
+ * The records are buffered and written in native byte order;
+ * strings, i.e. executables and initializer names, are stored once and referenced by index.
+ *
+ * All functions are thread-safe, so launchers on multiple threads can share a recorder.
+ */
+struct launch_recorder
+{
+    /// Create or truncate the file.
+    BOOST_PROCESS_V2_DECL launch_recorder(const filesystem::path & file, error_code & ec);
+
+    /// Create or truncate the file.
+    explicit launch_recorder(const filesystem::path & file) : launch_recorder(file, throw_on_error_{})
+    {
+    }
+
+    launch_recorder(const launch_recorder & ) = delete;
+    launch_recorder& operator=(const launch_recorder & ) = delete;
+
+    /// Flush & close the file.
+    BOOST_PROCESS_V2_DECL ~launch_recorder();
+
+    /// Record the exit of a process, with its native exit code.
+    BOOST_PROCESS_V2_DECL void record_exit(pid_type pid, int exit_code);
+
+    /// Record the exit of a process, after it got waited for.
+    template<typename Executor>
+    void record_exit(const basic_process<Executor> & proc)
+    {
+        record_exit(proc.id(), proc.native_exit_code());
+    }
+
+    /// Record a launch, as done by the recording_launcher.
+    BOOST_PROCESS_V2_DECL void record_launch(const detail::launch_sample & sample);
+
+    /// Write the buffered records to the file. Returns the first write error, if any.
+    BOOST_PROCESS_V2_DECL void flush(error_code & ec);
+
+    /// The number of launches recorded.
+    BOOST_PROCESS_V2_DECL std::uint64_t launches() const;
+
+    /// The time since the recording started in nanoseconds.
+    std::uint64_t now() const
+    {
+        return detail::monotonic_now() - origin_;
+    }
+
+  private:
+    struct throw_on_error_ {};
+    launch_recorder(const filesystem::path & file, throw_on_error_) : launch_recorder()
+    {
+        error_code ec;
+        open_(file, ec);
+        if (ec)
+            v2::detail::throw_error(ec, "launch_recorder");
+    }
+    launch_recorder() = default;
+
+    BOOST_PROCESS_V2_DECL void open_(const filesystem::path & file, error_code & ec);
+    std::uint32_t intern_(const std::string & str);
+    void flush_();
+
+    mutable std::mutex mutex_;
+    int fd_ = -1;
+    std::uint64_t origin_ = detail::monotonic_now();
+    std::uint64_t launches_ = 0u;
+    std::string buffer_;
+    error_code error_;
+    std::unordered_map<std::string, std::uint32_t> strings_;
+    // typeid names are unique per type, so they get looked up by address first.
+    std::unordered_map<const void *, std::uint32_t> type_names_;
+};
+
+/// Read all records of a file written by a `launch_recorder`.
+/** An exit gets matched to the latest launch with the same pid. A truncated last record,
+ * e.g. of a crashed recorder, gets ignored; a file that isn't a launch log fails with `invalid_argument`.
+ */
+BOOST_PROCESS_V2_DECL std::vector<launch_record> read_launch_records(const filesystem::path & file, error_code & ec);
+
+/// Read all records of a file written by a `launch_recorder`.
+inline std::vector<launch_record> read_launch_records(const filesystem::path & file)
+{
+    error_code ec;
+    auto res = read_launch_records(file, ec);
+    if (ec)
+        v2::detail::throw_error(ec, "read_launch_records");
+    return res;
+}
+
+namespace detail
+{
+
+// Appended to the initializers by the recording_launcher, so it sees the final argv & environment.
+struct launch_record_probe
+{
+    launch_sample & sample;
+
+    template<typename Launcher>
+    error_code on_setup(Launcher & launcher, const filesystem::path &, const char * const * (&cmd_line))
+    {
+        count_(cmd_line, sample.argc, sample.argv_bytes);
+        count_(launcher.env, sample.envc, sample.env_bytes);
+        return error_code{};
+    }
+
+    static void count_(const char * const * strs, std::uint32_t & n, std::uint32_t & bytes)
+    {
+        n = bytes = 0u;
+        if (strs == nullptr)
+            return;
+        for (; strs[n] != nullptr; n++)
+            bytes += static_cast<std::uint32_t>(std::strlen(strs[n]) + 1u);
+    }
+};
+
+}
+
+/// A launcher, recording every launch of the launcher it wraps.
+/** It records the executable, the number & size of the arguments and environment variables,
+ * the types of the initializers, the duration of the launch and its error.
+ * It doesn't see the exit of the process, which needs to be passed to `launch_recorder::record_exit`.
+ * Every launch uses a copy of `launcher`, so what the initializers set on it doesn't leak into the next one.
+ *
+ * @par Example
+ * @code {.cpp}
+ * posix::launch_recorder recorder{"launches.bin"};
+ * posix::recording_launcher<> launcher{recorder};
+ * auto proc = launcher(ctx, "/usr/bin/tool", {"--flag"});
+ * proc.wait();
+ * recorder.record_exit(proc);
+ * @endcode
+ */
+template<typename Launcher = default_process_launcher>
+struct recording_launcher
+{
+    launch_recorder & recorder;
+    Launcher launcher;
+
+    explicit recording_launcher(launch_recorder & recorder, Launcher launcher = Launcher{})
+        : recorder(recorder), launcher(std::move(launcher))
+    {
+    }
+
+    template<typename ExecutionContext, typename Args, typename ... Inits>
+    auto operator()(ExecutionContext & context,
+                    const typename std::enable_if<std::is_convertible<
+                            ExecutionContext&, net::execution_context&>::value,
+                            filesystem::path >::type & executable,
+                    Args && args,
+                    Inits && ... inits) -> basic_process<typename ExecutionContext::executor_type>
+    {
+        error_code ec;
+        auto proc = (*this)(context, ec, executable, std::forward<Args>(args), std::forward<Inits>(inits)...);
+        if (ec)
+            v2::detail::throw_error(ec, "recording_launcher");
+        return proc;
+    }
+
+    template<typename ExecutionContext, typename Args, typename ... Inits>
+    auto operator()(ExecutionContext & context,
+                    error_code & ec,
+                    const typename std::enable_if<std::is_convertible<
+                            ExecutionContext&, net::execution_context&>::value,
+                            filesystem::path >::type & executable,
+                    Args && args,
+                    Inits && ... inits ) -> basic_process<typename ExecutionContext::executor_type>
+    {
+        return invoke_(context, ec, executable, std::forward<Args>(args), std::forward<Inits>(inits)...);
+    }
+
+    template<typename Executor, typename Args, typename ... Inits>
+    auto operator()(Executor exec,
+                    const typename std::enable_if<
+                            net::execution::is_executor<Executor>::value ||
+                            net::is_executor<Executor>::value,
+                            filesystem::path >::type & executable,
+                    Args && args,
+                    Inits && ... inits ) -> basic_process<Executor>
+    {
+        error_code ec;
+        auto proc = (*this)(std::move(exec), ec, executable, std::forward<Args>(args), std::forward<Inits>(inits)...);
+        if (ec)
+            v2::detail::throw_error(ec, "recording_launcher");
+        return proc;
+    }
+
+    template<typename Executor, typename Args, typename ... Inits>
+    auto operator()(Executor exec,
+                    error_code & ec,
+                    const typename std::enable_if<
+                            net::execution::is_executor<Executor>::value ||
+                            net::is_executor<Executor>::value,
+                            filesystem::path >::type & executable,
+                    Args && args,
+                    Inits && ... inits ) -> basic_process<Executor>
+    {
+        return invoke_(std::move(exec), ec, executable, std::forward<Args>(args), std::forward<Inits>(inits)...);
+    }
+
+  private:
+    template<typename Target, typename Args, typename ... Inits>
+    auto invoke_(Target && target, error_code & ec, const filesystem::path & executable,
+                 Args && args, Inits && ... inits)
+        -> decltype(launcher(std::forward<Target>(target), ec, executable, std::forward<Args>(args),
+                             std::forward<Inits>(inits)..., std::declval<detail::launch_record_probe>()))
+    {
+        const char * const initializers[] = {typeid(Inits).name()..., nullptr};
+        detail::launch_sample sample{};
+        sample.executable = executable.c_str();
+        sample.initializers = initializers;
+        sample.start = recorder.now();
+
+        Launcher l = launcher;
+        auto proc = l(std::forward<Target>(target), ec, executable, std::forward<Args>(args),
+                      std::forward<Inits>(inits)..., detail::launch_record_probe{sample});
+
+        sample.duration = recorder.now() - sample.start;
+        sample.error = ec.value();
+        sample.pid = ec ? 0 : proc.id();
+        recorder.record_launch(sample);
+        return proc;
+    }
+};
+
+/// How `replay_launches` paces the launches.
+struct replay_options
+{
+    /// The factor the recorded pace is accelerated by, e.g. 10. replays ten times as fast.
+    /** Zero launches as fast as possible. */
+    double speed = 1.;
+    /// Accelerate the lifetimes of the children by `speed` as well.
+    bool scale_lifetimes = true;
+    /// Arguments passed to the stub before the replayed ones, e.g. to select a mode of the executable.
+    std::vector<std::string> stub_args;
+};
+
+/// The outcome of `replay_launches`.
+struct replay_report
+{
+    /// The number of launches replayed.
+    std::uint64_t launches = 0u;
+    /// The number of replayed launches that failed.
+    std::uint64_t failures = 0u;
+    /// The number of recorded launches that failed, which don't get replayed.
+    std::uint64_t skipped = 0u;
+    /// The number of replayed launches without a recorded exit, whose stubs exit right away.
+    /** They shorten the replayed lifetimes, so a high count means the exits need to be recorded. */
+    std::uint64_t unmatched = 0u;
+    /// The time the replay took in nanoseconds.
+    std::uint64_t elapsed = 0u;
+    /// The durations of the launches in nanoseconds.
+    histogram_snapshot launch_latency;
+    /// The time from the exit of a child until the parent got notified of it in nanoseconds.
+    histogram_snapshot reaper_lag;
+    /// The phases of the launches, as traced by the launcher.
+    launch_statistics phases;
+};
+
+namespace detail
+{
+
+// What a replay stub writes to stdout right before it exits.
+struct replay_exit
+{
+    std::uint64_t index;
+    std::uint64_t time;
+};
+
+// Adds `count` entries of `bytes` in total, including their terminators.
+inline void add_padding(std::vector<std::string> & entries, std::size_t count, std::size_t bytes, const char * prefix)
+{
+    for (std::size_t i = 0u; i < count; i++)
+    {
+        std::string entry = prefix;
+        if (*prefix != '\0')
+            entry += std::to_string(i) + '=';
+        // spread the bytes evenly, the first entries get the remainder.
+        const std::size_t size = bytes / count + (i < bytes % count ? 1u : 0u);
+        if (size > entry.size() + 1u)
+            entry.append(size - entry.size() - 1u, 'x');
+        entries.push_back(std::move(entry));
+    }
+}
+
+struct launch_replayer
+{
+    const std::vector<launch_record> & records;
+    const filesystem::path & stub;
+    const replay_options & options;
+
+    net::io_context ctx;
+    net::steady_timer timer{ctx};
+    net::readable_pipe exits{ctx};
+    net::writable_pipe exits_sink{ctx};
+
+    default_process_launcher launcher;
+    launch_histograms phases;
+    latency_histogram latency;
+    replay_report report;
+
+    // the indices of the replayed records, in the order they started.
+    std::vector<std::size_t> order;
+    std::size_t next = 0u;
+    std::uint64_t first_start = 0u;
+    std::chrono::steady_clock::time_point begin;
+
+    std::list<basic_process<net::io_context::executor_type>> running;
+    // the CLOCK_MONOTONIC times per replayed launch.
+    std::vector<std::uint64_t> exited, reaped;
+    char buffer[sizeof(replay_exit) * 64u];
+    std::string pending;
+
+    launch_replayer(const std::vector<launch_record> & records, const filesystem::path & stub,
+                    const replay_options & options)
+        : records(records), stub(stub), options(options)
+    {
+    }
+
+    replay_report run(error_code & ec)
+    {
+        net::connect_pipe(exits, exits_sink, ec);
+        if (ec)
+            return report;
+
+        for (std::size_t i = 0u; i < records.size(); i++)
+            if (records[i].error == 0)
+                order.push_back(i);
+        report.skipped = records.size() - order.size();
+        report.unmatched = static_cast<std::uint64_t>(std::count_if(
+                order.begin(), order.end(), [this](std::size_t i) {return records[i].exit_time == 0u;}));
+        std::stable_sort(order.begin(), order.end(),
+                         [this](std::size_t l, std::size_t r) {return records[l].start < records[r].start;});
+        if (!order.empty())
+            first_start = records[order.front()].start;
+        exited.assign(order.size(), 0u);
+        reaped.assign(order.size(), 0u);
+
+        launcher.tracer = &phases;
+        const auto t0 = monotonic_now();
+        begin = std::chrono::steady_clock::now();
+        read_();
+        schedule_();
+        ctx.run();
+
+        latency_histogram lag;
+        for (std::size_t i = 0u; i < order.size(); i++)
+            if (exited[i] != 0u && reaped[i] != 0u)
+                lag.record(reaped[i] > exited[i] ? reaped[i] - exited[i] : 0u);
+
+        report.elapsed = monotonic_now() - t0;
+        report.launch_latency = latency.snapshot();
+        report.reaper_lag = lag.snapshot();
+        report.phases = phases.snapshot();
+        return report;
+    }
+
+    std::uint64_t scale_(std::uint64_t value) const
+    {
+        return options.speed > 0. ? static_cast<std::uint64_t>(static_cast<double>(value) / options.speed) : 0u;
+    }
+
+    void schedule_()
+    {
+        if (next == order.size())
+        {
+            // the children hold the only other ends, so the read ends once they all exited.
+            error_code ec;
+            exits_sink.close(ec);
+            return;
+        }
+
+        const auto due = begin + std::chrono::nanoseconds(scale_(records[order[next]].start - first_start));
+        if (options.speed > 0. && due > std::chrono::steady_clock::now())
+        {
+            timer.expires_at(due);
+            timer.async_wait([this](error_code ec) {if (!ec) schedule_();});
+            return;
+        }
+        launch_(next++);
+        // let the reaping interleave with the launches.
+        net::post(ctx, [this] {schedule_();});
+    }
+
+    void launch_(std::size_t idx)
+    {
+        const auto & rec = records[order[idx]];
+        const std::uint64_t lifetime = rec.exit_time > rec.start ? rec.exit_time - rec.start : 0u;
+        const auto t0 = monotonic_now();
+
+        std::vector<std::string> args = options.stub_args;
+        args.push_back(std::to_string(t0 + (options.scale_lifetimes ? scale_(lifetime) : lifetime)));
+        args.push_back(std::to_string(idx));
+
+        std::size_t used = std::strlen(stub.c_str()) + 1u;
+        for (auto & arg : args)
+            used += arg.size() + 1u;
+        const std::size_t padding = rec.argc > args.size() + 1u ? rec.argc - args.size() - 1u : 0u;
+        add_padding(args, padding, rec.argv_bytes > used ? rec.argv_bytes - used : 0u, "");
+
+        std::vector<std::string> env;
+        add_padding(env, rec.envc, rec.env_bytes, "REPLAY_PADDING_");
+
+        error_code ec;
+        // a fresh copy, the launcher keeps the state of the last launch.
+        auto l = launcher;
+        auto proc = l(ctx, ec, stub, args, process_environment{env}, process_stdio{nullptr, exits_sink, {}});
+        latency.record(monotonic_now() - t0);
+        if (ec)
+        {
+            report.failures++;
+            return;
+        }
+        report.launches++;
+
+        running.push_front(std::move(proc));
+        auto itr = running.begin();
+        itr->async_wait(
+            [this, itr, idx](error_code, int)
+            {
+                reaped[idx] = monotonic_now();
+                running.erase(itr);
+            });
+    }
+
+    void read_()
+    {
+        exits.async_read_some(
+            net::buffer(buffer),
+            [this](error_code ec, std::size_t n)
+            {
+                pending.append(buffer, n);
+                std::size_t pos = 0u;
+                for (; pending.size() - pos >= sizeof(replay_exit); pos += sizeof(replay_exit))
+                {
+                    replay_exit msg;
+                    std::memcpy(&msg, pending.data() + pos, sizeof(msg));
+                    if (msg.index < exited.size())
+                        exited[msg.index] = msg.time;
+                }
+                pending.erase(0u, pos);
+                if (!ec)
+                    read_();
+            });
+    }
+};
+
+}
+
+/// Re-issue the recorded launches against a stub executable, measuring the launch latency and the reaper lag.
+/** The launches happen at the recorded pace, scaled by `options.speed`, with the recorded number & size
+ * of the arguments and environment variables. Each stub lives as long as the recorded process,
+ * or exits right away if its exit wasn't recorded, which gets counted in `replay_report::unmatched`.
+ * The initializers aren't replayed.
+ *
+ * The stub gets invoked with the `options.stub_args`, followed by the CLOCK_MONOTONIC time to exit at,
+ * the index of the launch and padding. It needs to implement `replay_stub_main`, which reports its exit
+ * time on stdout, so the delay until the parent reaped the child can be measured.
+ */
+inline replay_report replay_launches(const std::vector<launch_record> & records,
+                                     const filesystem::path & stub,
+                                     const replay_options & options,
+                                     error_code & ec)
+{
+    detail::launch_replayer replayer{records, stub, options};
+    return replayer.run(ec);
+}
+
+/// Re-issue the recorded launches against a stub executable, measuring the launch latency and the reaper lag.
+inline replay_report replay_launches(const std::vector<launch_record> & records,
+                                     const filesystem::path & stub,
+                                     const replay_options & options = {})
+{
+    error_code ec;
+    auto res = replay_launches(records, stub, options, ec);
+    if (ec)
+        v2::detail::throw_error(ec, "replay_launches");
+    return res;
+}
+
+/// The main function of a replay stub, with `argv[1]` being the first argument after the `stub_args`.
+/** It sleeps until the CLOCK_MONOTONIC time in `argv[1]`, then writes the time it exits at and the index
+ * in `argv[2]` to stdout. Further arguments are padding.
+ *
+ * @par Example
+ * @code {.cpp}
+ * int main(int argc, char * argv[])
+ * {
+ *   return posix::replay_stub_main(argc, argv);
+ * }
+ * @endcode
+ */
+inline int replay_stub_main(int argc, char * argv[])
+{
+    if (argc < 3)
+        return EXIT_FAILURE;
+
+    const std::uint64_t deadline = std::strtoull(argv[1], nullptr, 10);
+    for (auto now = detail::monotonic_now(); now < deadline; now = detail::monotonic_now())
+    {
+        struct timespec ts;
+        ts.tv_sec  = static_cast<time_t>((deadline - now) / 1000000000u);
+        ts.tv_nsec = static_cast<long>((deadline - now) % 1000000000u);
+        ::nanosleep(&ts, nullptr);
+    }
+
+    detail::replay_exit msg{std::strtoull(argv[2], nullptr, 10), detail::monotonic_now()};
+    return ::write(STDOUT_FILENO, &msg, sizeof(msg)) == sizeof(msg) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_POSIX_LAUNCH_RECORD_HPP
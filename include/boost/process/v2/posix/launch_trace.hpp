@@ -0,0 +1,243 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_LAUNCH_TRACE_HPP
+#define BOOST_PROCESS_V2_POSIX_LAUNCH_TRACE_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <time.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+// CLOCK_MONOTONIC in nanoseconds. This is async-signal-safe and system-wide,
+// so the timestamps taken in a forked child are comparable with the parent's.
+inline std::uint64_t monotonic_now()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+}
+
+/// The phases of a launch, as reported by the launch_timestamps.
+enum class launch_phase : unsigned
+{
+    /// Running the `on_setup` handlers of the initializers.
+    setup,
+    /// The `fork` call in the parent.
+    fork,
+    /// Running the `on_exec_setup` handlers in the child.
+    exec_setup,
+    /// Closing all file descriptors not on the whitelist in the child.
+    close_fds,
+    /// From the child calling `execve`, until the parent noticed it succeeded.
+    exec,
+    /// The parent waiting for the child to exec, i.e. everything after fork.
+    handshake,
+    /// The entire launch.
+    total
+};
+
+/// The number of phases in `launch_phase`.
+constexpr static std::size_t launch_phase_count = 7u;
+
+/// The CLOCK_MONOTONIC timestamps of a launch in nanoseconds.
+/** A timestamp is zero if the launch didn't get that far, or the launcher can't record it. */
+struct launch_timestamps
+{
+    /// Before the `on_setup` handlers ran.
+    std::uint64_t start;
+    /// After the `on_setup` handlers ran, i.e. right before forking.
+    std::uint64_t setup_done;
+    /// When fork returned in the parent.
+    std::uint64_t forked;
+    /// When fork returned in the child.
+    std::uint64_t child_start;
+    /// After the `on_exec_setup` handlers ran in the child.
+    std::uint64_t exec_setup_done;
+    /// After the file descriptors got closed, i.e. right before `execve`.
+    std::uint64_t exec_start;
+    /// When the launch completed in the parent.
+    std::uint64_t done;
+
+    /// The duration of the phase, or zero if it wasn't recorded.
+    std::uint64_t duration(launch_phase phase) const
+    {
+        switch (phase)
+        {
+            case launch_phase::setup:      return span_(start,           setup_done);
+            case launch_phase::fork:       return span_(setup_done,      forked);
+            case launch_phase::exec_setup: return span_(child_start,     exec_setup_done);
+            case launch_phase::close_fds:  return span_(exec_setup_done, exec_start);
+            case launch_phase::exec:       return span_(exec_start,      done);
+            case launch_phase::handshake:  return span_(forked,          done);
+            case launch_phase::total:      return span_(start,           done);
+        }
+        return 0u;
+    }
+
+  private:
+    static std::uint64_t span_(std::uint64_t from, std::uint64_t to)
+    {
+        return (from == 0u || to < from) ? 0u : to - from;
+    }
+};
+
+/// A hook installed on a launcher that gets the timestamps of every launch.
+/** It is invoked in the parent after the launch completed or failed & must not throw. */
+struct launch_tracer
+{
+    virtual void on_launch(const launch_timestamps & timestamps, const error_code & ec) noexcept = 0;
+  protected:
+    ~launch_tracer() = default;
+};
+
+/// A copy of the content of a latency_histogram.
+struct histogram_snapshot
+{
+    struct bucket
+    {
+        /// The range of values in the bucket, i.e. [lower, upper].
+        std::uint64_t lower;
+        std::uint64_t upper;
+        std::uint64_t count;
+    };
+
+    std::uint64_t count = 0u;
+    std::uint64_t sum   = 0u;
+    std::uint64_t min   = 0u;
+    std::uint64_t max   = 0u;
+    /// The non-empty buckets, in ascending order.
+    std::vector<bucket> buckets;
+
+    /// The mean of all recorded values.
+    double mean() const {return count == 0u ? 0. : static_cast<double>(sum) / static_cast<double>(count);}
+    /// The upper bound of the bucket containing the given percentile, e.g. 99. for the p99.
+    BOOST_PROCESS_V2_DECL std::uint64_t percentile(double p) const;
+};
+
+/// A histogram with logarithmic buckets that can be recorded into without locking.
+/** Each power of two is split into 16 linear sub buckets, so a value is off by at most 6.25%.
+ * Values of 2^40 (i.e. 18 minutes in nanoseconds) and above are counted in the last bucket.
+ *
+ * Recording uses relaxed atomics, so a snapshot taken while recording
+ * can be off by the values recorded concurrently.
+ */
+struct latency_histogram
+{
+    constexpr static unsigned sub_bucket_bits = 4u;
+    constexpr static unsigned max_exponent = 40u;
+    constexpr static std::size_t bucket_count = (max_exponent - sub_bucket_bits + 1u) << sub_bucket_bits;
+
+    latency_histogram() = default;
+    latency_histogram(const latency_histogram & ) = delete;
+    latency_histogram& operator=(const latency_histogram & ) = delete;
+
+    /// Record a single value.
+    void record(std::uint64_t value) noexcept
+    {
+        buckets_[bucket_index(value)].fetch_add(1u, std::memory_order_relaxed);
+        count_.fetch_add(1u, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        auto mn = min_.load(std::memory_order_relaxed);
+        while (value < mn && !min_.compare_exchange_weak(mn, value, std::memory_order_relaxed))
+            ;
+        auto mx = max_.load(std::memory_order_relaxed);
+        while (value > mx && !max_.compare_exchange_weak(mx, value, std::memory_order_relaxed))
+            ;
+    }
+
+    /// Copy the current content.
+    BOOST_PROCESS_V2_DECL histogram_snapshot snapshot() const;
+    /// Clear all values.
+    BOOST_PROCESS_V2_DECL void reset() noexcept;
+
+    /// The bucket a value is counted in.
+    static std::size_t bucket_index(std::uint64_t value) noexcept
+    {
+        constexpr std::uint64_t sub_buckets = std::uint64_t(1u) << sub_bucket_bits;
+        if (value < sub_buckets)
+            return static_cast<std::size_t>(value);
+        unsigned exp = 63u - static_cast<unsigned>(__builtin_clzll(value));
+        if (exp >= max_exponent)
+            return bucket_count - 1u;
+        const auto sub = (value >> (exp - sub_bucket_bits)) & (sub_buckets - 1u);
+        return static_cast<std::size_t>(((exp - sub_bucket_bits + 1u) << sub_bucket_bits) + sub);
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets_{};
+    std::atomic<std::uint64_t> count_{0u};
+    std::atomic<std::uint64_t> sum_{0u};
+    std::atomic<std::uint64_t> min_{UINT64_MAX};
+    std::atomic<std::uint64_t> max_{0u};
+};
+
+/// A copy of the content of launch_histograms.
+struct launch_statistics
+{
+    /// The number of failed launches, their phases are recorded as well.
+    std::uint64_t failures = 0u;
+    std::array<histogram_snapshot, launch_phase_count> phases;
+
+    const histogram_snapshot & operator[](launch_phase phase) const
+    {
+        return phases[static_cast<std::size_t>(phase)];
+    }
+};
+
+/// A launch_tracer, that collects the durations of each phase in a latency_histogram.
+/** It can be shared by launchers on multiple threads.
+ *
+ * @par Example
+ * @code {.cpp}
+ * posix::launch_histograms stats;
+ * posix::default_launcher launcher;
+ * launcher.tracer = &stats;
+ * auto proc = launcher(ctx, "/bin/true", {});
+ *
+ * auto snap = stats.snapshot();
+ * std::cout << "p99 fork: " << snap[posix::launch_phase::fork].percentile(99.) << "ns" << std::endl;
+ * @endcode
+ */
+struct launch_histograms final : launch_tracer
+{
+    /// Record the phases of a launch.
+    BOOST_PROCESS_V2_DECL void on_launch(const launch_timestamps & timestamps, const error_code & ec) noexcept override;
+
+    /// The histogram of a single phase.
+    const latency_histogram & operator[](launch_phase phase) const
+    {
+        return histograms_[static_cast<std::size_t>(phase)];
+    }
+
+    /// Copy the current content of all histograms.
+    BOOST_PROCESS_V2_DECL launch_statistics snapshot() const;
+    /// Clear all histograms.
+    BOOST_PROCESS_V2_DECL void reset() noexcept;
+
+  private:
+    std::array<latency_histogram, launch_phase_count> histograms_;
+    std::atomic<std::uint64_t> failures_{0u};
+};
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_POSIX_LAUNCH_TRACE_HPP
@@ -93,10 +93,13 @@ struct pdfork_launcher : default_launcher
                 BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
                 return basic_process<Executor>{exec};
             }
+            trace_begin_();
             ec = detail::on_setup(*this, executable, argv, inits ...);
+            trace_mark_(&launch_timestamps::setup_done);
             if (ec)
             {
                 detail::on_error(*this, executable, argv, ec, inits...);
+                trace_end_(ec);
                 return basic_process<Executor>(exec);
             }
             fd_whitelist.push_back(pg.p[1]);
@@ -116,20 +119,24 @@ struct pdfork_launcher : default_launcher
                 detail::on_error(*this, executable, argv, ec, inits...);
 
                 BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
+                trace_end_(ec);
                 return basic_process<Executor>{exec};
             }
             else if (pid == 0)
             {
+                trace_mark_(&launch_timestamps::child_start);
 #if !defined(BOOST_PROCESS_V2_DISABLE_NOTIFY_FORK)
                 ctx.notify_fork(net::execution_context::fork_child);
 #endif
                 ::close(pg.p[0]);
 
                 ec = detail::on_exec_setup(*this, executable, argv, inits...);
+                trace_mark_(&launch_timestamps::exec_setup_done);
                 if (!ec)
                 {
                     close_all_fds(ec);
                 }                
+                trace_report_(pg.p[1]);
                 if (!ec)
                     ::execve(executable.c_str(), const_cast<char * const *>(argv), const_cast<char * const *>(env));
 
@@ -139,34 +146,25 @@ struct pdfork_launcher : default_launcher
                 ::exit(EXIT_FAILURE);
                 return basic_process<Executor>{exec};
             }
+            trace_mark_(&launch_timestamps::forked);
 #if !defined(BOOST_PROCESS_V2_DISABLE_NOTIFY_FORK)
             ctx.notify_fork(net::execution_context::fork_parent);
 #endif
             ::close(pg.p[1]);
             pg.p[1] = -1;
-            int child_error{0};
-            int count = -1;
-            while ((count = ::read(pg.p[0], &child_error, sizeof(child_error))) == -1)
-            {
-                int err = errno;
-                if ((err != EAGAIN) && (err != EINTR))
-                {
-                    BOOST_PROCESS_V2_ASSIGN_EC(ec, err, system_category());
-                    break;
-                }
-            }
-            if (count != 0)
-                BOOST_PROCESS_V2_ASSIGN_EC(ec, child_error, system_category());
+            read_error_pipe_(pg.p[0], ec);
 
             if (ec)
             {
                 detail::on_error(*this, executable, argv, ec, inits...);
                 do { ::waitpid(pid, nullptr, 0); } while (errno == EINTR);
+                trace_end_(ec);
                 return basic_process<Executor>{exec};
             }
         }
         basic_process<Executor> proc(exec, pid, fd);
         detail::on_success(*this, executable, argv, ec, inits...);
+        trace_end_(ec);
         return proc;
     }
 };
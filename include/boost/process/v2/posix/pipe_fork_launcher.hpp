@@ -102,10 +102,13 @@ struct pipe_fork_launcher : default_launcher
                 BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
                 return basic_process<Executor>{exec};
             }
+            trace_begin_();
             ec = detail::on_setup(*this, executable, argv, inits ...);
+            trace_mark_(&launch_timestamps::setup_done);
             if (ec)
             {
                 detail::on_error(*this, executable, argv, ec, inits...);
+                trace_end_(ec);
                 return basic_process<Executor>(exec);
             }
             fd_whitelist.push_back(pg.p[1]);
@@ -122,18 +125,22 @@ struct pipe_fork_launcher : default_launcher
                 detail::on_error(*this, executable, argv, ec, inits...);
 
                 BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
+                trace_end_(ec);
                 return basic_process<Executor>{exec};
             }
             else if (pid == 0)
             {
+                trace_mark_(&launch_timestamps::child_start);
                 ctx.notify_fork(net::execution_context::fork_child);
                 ::close(pg.p[0]);
 
                 ec = detail::on_exec_setup(*this, executable, argv, inits...);
+                trace_mark_(&launch_timestamps::exec_setup_done);
                 if (!ec)
                 {
                     close_all_fds(ec);
                 }                
+                trace_report_(pg.p[1]);
                 if (!ec)
                     ::execve(executable.c_str(), const_cast<char * const *>(argv), const_cast<char * const *>(env));
 
@@ -143,28 +150,18 @@ struct pipe_fork_launcher : default_launcher
                 ::exit(EXIT_FAILURE);
                 return basic_process<Executor>{exec};
             }
+            trace_mark_(&launch_timestamps::forked);
             ctx.notify_fork(net::execution_context::fork_parent);
             ::close(pg.p[1]);
             pg.p[1] = -1;
             ::close(pg_wait.p[1]);
             pg_wait.p[1] = -1;
-            int child_error{0};
-            int count = -1;
-            while ((count = ::read(pg.p[0], &child_error, sizeof(child_error))) == -1)
-            {
-                int err = errno;
-                if ((err != EAGAIN) && (err != EINTR))
-                {
-                    BOOST_PROCESS_V2_ASSIGN_EC(ec, err, system_category());
-                    break;
-                }
-            }
-            if (count != 0)
-                BOOST_PROCESS_V2_ASSIGN_EC(ec, child_error, system_category());
+            read_error_pipe_(pg.p[0], ec);
 
             if (ec)
             {
                 detail::on_error(*this, executable, argv, ec, inits...);
+                trace_end_(ec);
                 return basic_process<Executor>{exec};
             }
             std::swap(fd, pg_wait.p[0]);
@@ -172,6 +169,7 @@ struct pipe_fork_launcher : default_launcher
 
         basic_process<Executor> proc(exec, pid, fd);
         detail::on_success(*this, executable, argv, ec, inits...);
+        trace_end_(ec);
         return proc;
     }
 };
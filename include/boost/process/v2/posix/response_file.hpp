@@ -0,0 +1,146 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_RESPONSE_FILE_HPP
+#define BOOST_PROCESS_V2_POSIX_RESPONSE_FILE_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+#include <boost/process/v2/default_launcher.hpp>
+
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+// The space the strings and pointers of argv take up in the new process image.
+BOOST_PROCESS_V2_DECL std::size_t exec_args_size(const char * const * argv);
+
+// Checks if a single argument is too long to be passed to exec, regardless of the total size.
+BOOST_PROCESS_V2_DECL bool exec_arg_too_long(const char * const * argv);
+
+// Writes argv into a sealed memory fd, one argument per line, escaping whitespace, quotes & backslashes.
+BOOST_PROCESS_V2_DECL int write_response_file(const char * const * argv, error_code & ec);
+
+}
+
+/// An initializer that passes the arguments through a response file if they're too large for exec.
+/** If the arguments and environment exceed the `threshold`, all arguments but `argv[0]` are written
+ * into a sealed in-memory file, and the subprocess only gets `prefix` followed by a path to it,
+ * e.g. `@/proc/self/fd/3`. This avoids exec failing with `E2BIG` for tools that accept response files,
+ * like compilers & linkers.
+ *
+ * The arguments are separated by newlines and whitespace, quotes and backslashes are escaped
+ * with a backslash, as gcc, clang & GNU ld expect it.
+ *
+ * The environment counts towards the threshold, but never gets moved into the file, so this
+ * initializer needs to come after one that sets the environment.
+ *
+ * @code
+ * process p{ctx, "/usr/bin/ld", object_files, posix::response_file{}};
+ * @endcode
+ */
+struct response_file
+{
+    /// The size of arguments & environment in bytes above which the response file gets used.
+    std::size_t threshold = default_threshold();
+    /// The prefix of the response file argument, i.e. `@` for `@/proc/self/fd/3`.
+    std::string prefix = "@";
+
+    /// Half of ARG_MAX, so the response file gets used before exec would fail.
+    BOOST_PROCESS_V2_DECL static std::size_t default_threshold();
+
+    response_file() = default;
+    explicit response_file(std::size_t threshold, std::string prefix = "@")
+        : threshold(threshold), prefix(std::move(prefix))
+    {
+    }
+
+    response_file(const response_file & ) = delete;
+    response_file& operator=(const response_file & ) = delete;
+
+    ~response_file()
+    {
+        close_();
+    }
+
+    /// Check if the last launch used a response file.
+    bool used() const {return used_;}
+
+    error_code on_setup(posix::default_launcher & launcher, const filesystem::path &, const char * const * & cmd_line)
+    {
+        close_();
+        used_ = false;
+        if (cmd_line == nullptr || cmd_line[0] == nullptr || cmd_line[1] == nullptr)
+            return error_code{};
+
+        const auto size = detail::exec_args_size(cmd_line) + detail::exec_args_size(launcher.env);
+        if (size <= threshold && !detail::exec_arg_too_long(cmd_line))
+            return error_code{};
+
+        error_code ec;
+        fd_ = detail::write_response_file(cmd_line + 1, ec);
+        if (ec)
+            return ec;
+
+#if defined(__linux__)
+        arg_ = prefix + "/proc/self/fd/" + std::to_string(fd_);
+#else
+        arg_ = prefix + "/dev/fd/" + std::to_string(fd_);
+#endif
+        argv_[0] = cmd_line[0];
+        argv_[1] = arg_.c_str();
+        argv_[2] = nullptr;
+        cmd_line = argv_;
+
+        launcher.fd_whitelist.push_back(fd_);
+        used_ = true;
+        return error_code{};
+    }
+
+    /// Implementation of the initialization function.
+    error_code on_exec_setup(posix::default_launcher & /*launcher*/, const filesystem::path &, const char * const *)
+    {
+        // the file needs to survive the exec, so the subprocess can open it.
+        if (fd_ != -1 && ::fcntl(fd_, F_SETFD, 0) == -1)
+            return error_code(errno, system_category());
+        return error_code ();
+    }
+
+    void on_success(posix::default_launcher & /*launcher*/, const filesystem::path &, const char * const *)
+    {
+        close_();
+    }
+
+    void on_error(posix::default_launcher & /*launcher*/, const filesystem::path &, const char * const *, const error_code &)
+    {
+        close_();
+    }
+
+  private:
+    void close_()
+    {
+        if (fd_ != -1)
+            ::close(fd_);
+        fd_ = -1;
+    }
+
+    int fd_ = -1;
+    bool used_ = false;
+    std::string arg_;
+    const char * argv_[3] = {nullptr, nullptr, nullptr};
+};
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_POSIX_RESPONSE_FILE_HPP
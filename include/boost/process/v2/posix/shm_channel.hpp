@@ -0,0 +1,573 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_SHM_CHANNEL_HPP
+#define BOOST_PROCESS_V2_POSIX_SHM_CHANNEL_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/detail/complete_immediately.hpp>
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/default_launcher.hpp>
+#include <boost/process/v2/posix/detail/memory_fd.hpp>
+#include <boost/process/v2/posix/detail/shm_ring.hpp>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/buffer.hpp>
+#include <asio/compose.hpp>
+#include <asio/posix/basic_stream_descriptor.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/posix/basic_stream_descriptor.hpp>
+#endif
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+template<typename MutableBufferSequence>
+std::size_t shm_read_buffers(shm_endpoint & ep, const MutableBufferSequence & buffers)
+{
+    std::size_t total = 0u;
+    for (auto itr = net::buffer_sequence_begin(buffers); itr != net::buffer_sequence_end(buffers); itr++)
+    {
+        const net::mutable_buffer buf = *itr;
+        const auto n = ep.read_some(buf.data(), buf.size());
+        total += n;
+        if (n < buf.size())
+            break;
+    }
+    return total;
+}
+
+template<typename ConstBufferSequence>
+std::size_t shm_write_buffers(shm_endpoint & ep, const ConstBufferSequence & buffers)
+{
+    std::size_t total = 0u;
+    for (auto itr = net::buffer_sequence_begin(buffers); itr != net::buffer_sequence_end(buffers); itr++)
+    {
+        const net::const_buffer buf = *itr;
+        const auto n = ep.write_some(buf.data(), buf.size());
+        total += n;
+        if (n < buf.size())
+            break;
+    }
+    return total;
+}
+
+}
+
+/// A shared memory channel to a subprocess.
+/** The channel consists of two single-producer single-consumer ring buffers in a memfd
+ * that gets mapped by both processes, and eventfds used as doorbells.
+ * A transfer is a plain memcpy into the shared memory; a syscall only happens
+ * if the other side is waiting for data or space.
+ *
+ * The channel is passed to the child with `bind_shm_channel`, which puts its five
+ * descriptors at `target` to `target + 4`. The subprocess attaches to it with
+ * `shm_channel_client` from `<boost/process/v2/posix/shm_channel_client.hpp>`.
+ *
+ * @code {.cpp}
+ * asio::io_context ctx;
+ * posix::shm_channel ch{ctx};
+ * process proc(ctx, "./worker", {}, posix::bind_shm_channel(3, ch));
+ * asio::write(ch, asio::buffer(request));
+ * @endcode
+ *
+ * The channel is a stream and can be used with `asio::read`, `asio::write` etc.
+ * Reading yields `asio::error::eof` once the subprocess closed or shut down its output,
+ * writing yields `asio::error::broken_pipe` once it closed the channel.
+ *
+ * @note The subprocess closing its side is only visible through the shared memory,
+ * a subprocess that crashes without doing so will not cause an eof.
+ * Use `cancel` or `close` after the process exited in that case.
+ *
+ * @note This is only available on linux.
+ */
+template<typename Executor = net::any_io_executor>
+struct basic_shm_channel
+{
+    /// The executor of the channel
+    using executor_type = Executor;
+    /// Get the executor of the channel
+    executor_type get_executor() {return readable_.get_executor();}
+
+    /// The capacity of each direction used by default.
+    constexpr static std::size_t default_capacity = 1u << 20;
+
+    /// Rebinds the channel to another executor.
+    template <typename Executor1>
+    struct rebind_executor
+    {
+        /// The channel type when rebound to the specified executor.
+        typedef basic_shm_channel<Executor1> other;
+    };
+
+    /// Create a channel with the given capacity per direction, which gets rounded up to a power of two.
+    explicit basic_shm_channel(executor_type exec, std::size_t capacity = default_capacity)
+        : readable_(exec), writable_(std::move(exec))
+    {
+        error_code ec;
+        open_(capacity, ec);
+        if (ec)
+            ::BOOST_PROCESS_V2_NAMESPACE::detail::throw_error(ec, "shm_channel");
+    }
+
+    /// Create a channel with the given capacity per direction, which gets rounded up to a power of two.
+    template <typename ExecutionContext>
+    explicit basic_shm_channel(ExecutionContext & context, std::size_t capacity = default_capacity,
+                               typename std::enable_if<
+                                   std::is_convertible<ExecutionContext&,
+                                        net::execution_context&>::value, void *>::type = nullptr)
+        : basic_shm_channel(executor_type(context.get_executor()), capacity)
+    {
+    }
+
+    basic_shm_channel(const basic_shm_channel &) = delete;
+    basic_shm_channel& operator=(const basic_shm_channel &) = delete;
+
+    /// Move construct a channel.
+    basic_shm_channel(basic_shm_channel && lhs)
+        : endpoint_(lhs.endpoint_), readable_(std::move(lhs.readable_)), writable_(std::move(lhs.writable_))
+    {
+        lhs.endpoint_ = detail::shm_endpoint{};
+    }
+
+    /// Move assign a channel.
+    basic_shm_channel& operator=(basic_shm_channel && lhs)
+    {
+        if (this != &lhs)
+        {
+            close();
+            endpoint_ = lhs.endpoint_;
+            lhs.endpoint_ = detail::shm_endpoint{};
+            readable_ = std::move(lhs.readable_);
+            writable_ = std::move(lhs.writable_);
+        }
+        return *this;
+    }
+
+    /// Close the channel if open.
+    ~basic_shm_channel()
+    {
+        close();
+    }
+
+    /// Check if the channel is open.
+    bool is_open() const {return endpoint_.header != nullptr;}
+
+    /// The size of the ring buffer of each direction.
+    std::size_t capacity() const {return endpoint_.capacity();}
+
+    /// The descriptors that get passed to the subprocess, indexed by `posix::detail::shm_channel_fd`.
+    const int * native_handles() const {return endpoint_.fds;}
+
+    /// Close our side of the channel, so the subprocess gets an eof, and release all resources.
+    /** Pending asynchronous operations get cancelled. */
+    void close()
+    {
+        if (endpoint_.header != nullptr)
+            endpoint_.close_side();
+        endpoint_.unmap();
+        error_code ec;
+        readable_.close(ec);
+        writable_.close(ec);
+        for (auto idx : {detail::shm_memory_fd, detail::shm_child_readable_fd, detail::shm_child_writable_fd})
+            if (endpoint_.fds[idx] != -1)
+                ::close(endpoint_.fds[idx]);
+        endpoint_ = detail::shm_endpoint{};
+    }
+
+    /// Signal the end of our output to the subprocess, while still being able to read.
+    void shutdown_write()
+    {
+        if (is_open())
+            endpoint_.shutdown_write();
+    }
+
+    /// Cancel all pending asynchronous operations.
+    void cancel()
+    {
+        readable_.cancel();
+        writable_.cancel();
+    }
+
+    /// Read some data from the channel.
+    /**
+     * This function blocks until at least one byte has been read.
+     * @throws system_error Thrown on failure. An error code of
+     * asio::error::eof indicates that the subprocess closed its side.
+     */
+    template <typename MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers)
+    {
+        error_code ec;
+        auto n = read_some(buffers, ec);
+        if (ec)
+            ::BOOST_PROCESS_V2_NAMESPACE::detail::throw_error(ec, "read_some");
+        return n;
+    }
+
+    /// Read some data from the channel.
+    /**
+     * This function blocks until at least one byte has been read.
+     * @returns The number of bytes read. Returns 0 if an error occurred.
+     */
+    template <typename MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers, error_code & ec)
+    {
+        if (!is_open())
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            return 0u;
+        }
+        if (net::buffer_size(buffers) == 0u)
+            return 0u;
+        for (;;)
+        {
+            auto n = detail::shm_read_buffers(endpoint_, buffers);
+            if (n > 0u)
+                return n;
+            if (endpoint_.input_closed())
+            {
+                n = detail::shm_read_buffers(endpoint_, buffers);
+                if (n == 0u)
+                    BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::eof);
+                return n;
+            }
+            if (endpoint_.prepare_read_wait() && !endpoint_.wait_for(endpoint_.own_readable(), ec))
+                return 0u;
+        }
+    }
+
+    /// Write some data to the channel.
+    /**
+     * This function blocks until at least one byte has been written.
+     * @throws system_error Thrown on failure. An error code of
+     * asio::error::broken_pipe indicates that the subprocess closed its side.
+     */
+    template <typename ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers)
+    {
+        error_code ec;
+        auto n = write_some(buffers, ec);
+        if (ec)
+            ::BOOST_PROCESS_V2_NAMESPACE::detail::throw_error(ec, "write_some");
+        return n;
+    }
+
+    /// Write some data to the channel.
+    /**
+     * This function blocks until at least one byte has been written.
+     * @returns The number of bytes written. Returns 0 if an error occurred.
+     */
+    template <typename ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers, error_code & ec)
+    {
+        if (!is_open())
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            return 0u;
+        }
+        if (net::buffer_size(buffers) == 0u)
+            return 0u;
+        for (;;)
+        {
+            if (endpoint_.output_closed())
+            {
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::broken_pipe);
+                return 0u;
+            }
+            const auto n = detail::shm_write_buffers(endpoint_, buffers);
+            if (n > 0u)
+                return n;
+            if (endpoint_.prepare_write_wait() && !endpoint_.wait_for(endpoint_.own_writable(), ec))
+                return 0u;
+        }
+    }
+
+  private:
+    template<typename Executor1>
+    friend struct basic_shm_channel;
+
+    detail::shm_endpoint endpoint_;
+    // our own doorbells, i.e. the subprocess rings them.
+    net::posix::basic_stream_descriptor<Executor> readable_;
+    net::posix::basic_stream_descriptor<Executor> writable_;
+    std::uint64_t read_count_{0u};
+    std::uint64_t write_count_{0u};
+
+    void open_(std::size_t capacity, error_code & ec)
+    {
+        std::size_t cap = 4096u;
+        while (cap < capacity)
+            cap <<= 1;
+
+        auto & fds = endpoint_.fds;
+        fds[detail::shm_memory_fd] = detail::create_shared_memory_fd(detail::shm_endpoint::mapping_size(cap), ec);
+        if (ec)
+            return;
+        for (int i = detail::shm_child_readable_fd; i < detail::shm_fd_count; i++)
+        {
+            fds[i] = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (fds[i] == -1)
+            {
+                BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+                break;
+            }
+        }
+
+        if (!ec && endpoint_.map(detail::shm_endpoint::mapping_size(cap), false, ec))
+        {
+            endpoint_.init(cap);
+            readable_.assign(fds[detail::shm_parent_readable_fd], ec);
+            if (!ec)
+                writable_.assign(fds[detail::shm_parent_writable_fd], ec);
+        }
+        if (ec)
+        {
+            endpoint_.unmap();
+            for (auto & fd : fds)
+                if (fd != -1)
+                    ::close(fd);
+            readable_.release();
+            writable_.release();
+            endpoint_ = detail::shm_endpoint{};
+        }
+    }
+
+    template<typename Buffers>
+    struct async_read_op_
+    {
+        detail::shm_endpoint & endpoint;
+        net::posix::basic_stream_descriptor<Executor> & doorbell;
+        std::uint64_t & count;
+        Buffers buffers;
+
+        template<typename Self>
+        void operator()(Self && self)
+        {
+            self.reset_cancellation_state(net::enable_total_cancellation());
+            error_code ec;
+            std::size_t n = 0u;
+            if (endpoint.header == nullptr)
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            else if (!try_read(ec, n))
+                return doorbell.async_read_some(net::buffer(&count, sizeof(count)), std::move(self));
+
+            v2::detail::complete_immediately(std::move(self), doorbell.get_executor(), ec, n);
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec, std::size_t = 0u)
+        {
+            std::size_t n = 0u;
+            if (!ec && endpoint.header == nullptr)
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            if (!ec && !try_read(ec, n))
+                return doorbell.async_read_some(net::buffer(&count, sizeof(count)), std::move(self));
+            std::move(self).complete(ec, n);
+        }
+
+        // returns false if we need to wait for the doorbell.
+        bool try_read(error_code & ec, std::size_t & n)
+        {
+            if (net::buffer_size(buffers) == 0u)
+                return true;
+            do
+            {
+                n = detail::shm_read_buffers(endpoint, buffers);
+                if (n > 0u)
+                    return true;
+                if (endpoint.input_closed())
+                {
+                    n = detail::shm_read_buffers(endpoint, buffers);
+                    if (n == 0u)
+                        BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::eof);
+                    return true;
+                }
+            }
+            while (!endpoint.prepare_read_wait());
+            return false;
+        }
+    };
+
+    template<typename Buffers>
+    struct async_write_op_
+    {
+        detail::shm_endpoint & endpoint;
+        net::posix::basic_stream_descriptor<Executor> & doorbell;
+        std::uint64_t & count;
+        Buffers buffers;
+
+        template<typename Self>
+        void operator()(Self && self)
+        {
+            self.reset_cancellation_state(net::enable_total_cancellation());
+            error_code ec;
+            std::size_t n = 0u;
+            if (endpoint.header == nullptr)
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            else if (!try_write(ec, n))
+                return doorbell.async_read_some(net::buffer(&count, sizeof(count)), std::move(self));
+
+            v2::detail::complete_immediately(std::move(self), doorbell.get_executor(), ec, n);
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec, std::size_t = 0u)
+        {
+            std::size_t n = 0u;
+            if (!ec && endpoint.header == nullptr)
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            if (!ec && !try_write(ec, n))
+                return doorbell.async_read_some(net::buffer(&count, sizeof(count)), std::move(self));
+            std::move(self).complete(ec, n);
+        }
+
+        // returns false if we need to wait for the doorbell.
+        bool try_write(error_code & ec, std::size_t & n)
+        {
+            if (net::buffer_size(buffers) == 0u)
+                return true;
+            do
+            {
+                if (endpoint.output_closed())
+                {
+                    BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::broken_pipe);
+                    return true;
+                }
+                n = detail::shm_write_buffers(endpoint, buffers);
+                if (n > 0u)
+                    return true;
+            }
+            while (!endpoint.prepare_write_wait());
+            return false;
+        }
+    };
+
+  public:
+    /// Start an asynchronous read.
+    /**
+     * Completes once at least one byte has been read, with asio::error::eof
+     * if the subprocess closed its side.
+     *
+     * The buffers must remain valid until the completion handler is called.
+     */
+    template <typename MutableBufferSequence,
+              BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void (error_code, std::size_t))
+              ReadToken = net::default_completion_token_t<executor_type>>
+    auto async_read_some(const MutableBufferSequence & buffers,
+                         ReadToken && token = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<ReadToken, void (error_code, std::size_t)>(
+                std::declval<async_read_op_<MutableBufferSequence>>(), token, readable_))
+    {
+        return net::async_compose<ReadToken, void (error_code, std::size_t)>(
+                async_read_op_<MutableBufferSequence>{endpoint_, readable_, read_count_, buffers},
+                token, readable_);
+    }
+
+    /// Start an asynchronous write.
+    /**
+     * Completes once at least one byte has been written, with asio::error::broken_pipe
+     * if the subprocess closed its side.
+     *
+     * The buffers must remain valid until the completion handler is called.
+     */
+    template <typename ConstBufferSequence,
+              BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void (error_code, std::size_t))
+              WriteToken = net::default_completion_token_t<executor_type>>
+    auto async_write_some(const ConstBufferSequence & buffers,
+                          WriteToken && token = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<WriteToken, void (error_code, std::size_t)>(
+                std::declval<async_write_op_<ConstBufferSequence>>(), token, writable_))
+    {
+        return net::async_compose<WriteToken, void (error_code, std::size_t)>(
+                async_write_op_<ConstBufferSequence>{endpoint_, writable_, write_count_, buffers},
+                token, writable_);
+    }
+};
+
+/// A shared memory channel with the default executor.
+typedef basic_shm_channel<> shm_channel;
+
+/// Initializer passing a shared memory channel to a subprocess.
+/** The descriptors of the channel are passed as `target` to `target + 4`.
+ *
+ * @code
+ * posix::shm_channel ch{ctx};
+ * process p{ctx, "worker", {}, posix::bind_shm_channel(3, ch)};
+ * @endcode
+ */
+struct bind_shm_channel
+{
+    int target;
+    int fds[detail::shm_fd_count];
+
+    template<typename Executor>
+    bind_shm_channel(int target, const basic_shm_channel<Executor> & channel) : target(target)
+    {
+        std::copy(channel.native_handles(), channel.native_handles() + detail::shm_fd_count, fds);
+    }
+
+    error_code on_setup(posix::default_launcher & launcher, const filesystem::path &, const char * const *)
+    {
+        if (fds[detail::shm_memory_fd] == -1)
+            return net::error::bad_descriptor;
+        for (int i = 0; i < detail::shm_fd_count; i++)
+            launcher.fd_whitelist.push_back(target + i);
+        return {};
+    }
+
+    /// Implementation of the initialization function.
+    error_code on_exec_setup(posix::default_launcher & /*launcher*/, const filesystem::path &, const char * const *)
+    {
+        // move sources out of the way, so a dup2 doesn't overwrite one that's still needed.
+        // this works on a copy, as the vfork launcher shares our memory with the parent.
+        int src[detail::shm_fd_count];
+        std::copy(fds, fds + detail::shm_fd_count, src);
+        for (int i = 0; i < detail::shm_fd_count; i++)
+        {
+            if (src[i] >= target && src[i] < target + detail::shm_fd_count && src[i] != target + i)
+            {
+                src[i] = ::fcntl(src[i], F_DUPFD_CLOEXEC, target + detail::shm_fd_count);
+                if (src[i] == -1)
+                    return error_code(errno, system_category());
+            }
+        }
+
+        for (int i = 0; i < detail::shm_fd_count; i++)
+        {
+            if (src[i] == target + i)
+            {
+                if (::fcntl(src[i], F_SETFD, 0) == -1)
+                    return error_code(errno, system_category());
+            }
+            else if (::dup2(src[i], target + i) == -1)
+                return error_code(errno, system_category());
+        }
+        return error_code ();
+    }
+};
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_POSIX_SHM_CHANNEL_HPP
@@ -0,0 +1,204 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_POSIX_SHM_CHANNEL_CLIENT_HPP
+#define BOOST_PROCESS_V2_POSIX_SHM_CHANNEL_CLIENT_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/posix/detail/shm_ring.hpp>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+/// The subprocess side of a `shm_channel`.
+/** This class is header-only and doesn't need the compiled part of the library
+ * or an io_context, so it can be used in lightweight worker processes.
+ *
+ * @code {.cpp}
+ * // the parent used posix::bind_shm_channel(3, ch)
+ * posix::shm_channel_client cl{3};
+ * char buf[4096];
+ * error_code ec;
+ * while (auto n = cl.read_some(buf, sizeof(buf), ec))
+ *   cl.write(buf, n);
+ * cl.close();
+ * @endcode
+ *
+ * Reading yields `asio::error::eof` once the parent closed or shut down its output,
+ * writing yields `asio::error::broken_pipe` once it closed the channel.
+ */
+struct shm_channel_client
+{
+    /// Attach to the channel passed at `first_fd` to `first_fd + 4`.
+    explicit shm_channel_client(int first_fd = 3)
+    {
+        error_code ec;
+        attach_(first_fd, ec);
+        if (ec)
+            throw system_error(ec, "shm_channel_client");
+    }
+
+    /// Attach to the channel passed at `first_fd` to `first_fd + 4`.
+    shm_channel_client(int first_fd, error_code & ec)
+    {
+        attach_(first_fd, ec);
+    }
+
+    shm_channel_client(const shm_channel_client &) = delete;
+    shm_channel_client& operator=(const shm_channel_client &) = delete;
+
+    /// Move construct a client.
+    shm_channel_client(shm_channel_client && lhs) : endpoint_(lhs.endpoint_)
+    {
+        lhs.endpoint_ = detail::shm_endpoint{};
+    }
+
+    /// Move assign a client.
+    shm_channel_client& operator=(shm_channel_client && lhs)
+    {
+        if (this != &lhs)
+        {
+            close();
+            endpoint_ = lhs.endpoint_;
+            lhs.endpoint_ = detail::shm_endpoint{};
+        }
+        return *this;
+    }
+
+    /// Close the client if open.
+    ~shm_channel_client()
+    {
+        close();
+    }
+
+    /// Check if the client is attached.
+    bool is_open() const {return endpoint_.header != nullptr;}
+
+    /// The size of the ring buffer of each direction.
+    std::size_t capacity() const {return endpoint_.capacity();}
+
+    /// Close our side of the channel, so the parent gets an eof, and release all resources.
+    void close()
+    {
+        if (endpoint_.header != nullptr)
+            endpoint_.close_side();
+        endpoint_.unmap();
+        for (auto & fd : endpoint_.fds)
+            if (fd != -1)
+                ::close(fd);
+        endpoint_ = detail::shm_endpoint{};
+    }
+
+    /// Signal the end of our output to the parent, while still being able to read.
+    void shutdown_write()
+    {
+        if (is_open())
+            endpoint_.shutdown_write();
+    }
+
+    /// Read at least one byte, blocking if no data is available. Returns 0 on error.
+    std::size_t read_some(void * data, std::size_t size, error_code & ec)
+    {
+        if (!is_open())
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            return 0u;
+        }
+        return endpoint_.read_blocking(data, size, ec);
+    }
+
+    /// Throwing @overload std::size_t read_some(void * data, std::size_t size, error_code & ec)
+    std::size_t read_some(void * data, std::size_t size)
+    {
+        error_code ec;
+        auto n = read_some(data, size, ec);
+        if (ec)
+            throw system_error(ec, "read_some");
+        return n;
+    }
+
+    /// Write at least one byte, blocking if the ring is full. Returns 0 on error.
+    std::size_t write_some(const void * data, std::size_t size, error_code & ec)
+    {
+        if (!is_open())
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+            return 0u;
+        }
+        return endpoint_.write_blocking(data, size, ec);
+    }
+
+    /// Throwing @overload std::size_t write_some(const void * data, std::size_t size, error_code & ec)
+    std::size_t write_some(const void * data, std::size_t size)
+    {
+        error_code ec;
+        auto n = write_some(data, size, ec);
+        if (ec)
+            throw system_error(ec, "write_some");
+        return n;
+    }
+
+    /// Read exactly `size` bytes, unless an error occurs. Returns the number of bytes read.
+    std::size_t read(void * data, std::size_t size, error_code & ec)
+    {
+        std::size_t total = 0u;
+        while (total < size && !ec)
+            total += read_some(static_cast<char*>(data) + total, size - total, ec);
+        return total;
+    }
+
+    /// Throwing @overload std::size_t read(void * data, std::size_t size, error_code & ec)
+    std::size_t read(void * data, std::size_t size)
+    {
+        error_code ec;
+        auto n = read(data, size, ec);
+        if (ec)
+            throw system_error(ec, "read");
+        return n;
+    }
+
+    /// Write all `size` bytes, unless an error occurs. Returns the number of bytes written.
+    std::size_t write(const void * data, std::size_t size, error_code & ec)
+    {
+        std::size_t total = 0u;
+        while (total < size && !ec)
+            total += write_some(static_cast<const char*>(data) + total, size - total, ec);
+        return total;
+    }
+
+    /// Throwing @overload std::size_t write(const void * data, std::size_t size, error_code & ec)
+    std::size_t write(const void * data, std::size_t size)
+    {
+        error_code ec;
+        auto n = write(data, size, ec);
+        if (ec)
+            throw system_error(ec, "write");
+        return n;
+    }
+
+  private:
+    detail::shm_endpoint endpoint_;
+
+    void attach_(int first_fd, error_code & ec)
+    {
+        endpoint_.side = 1;
+        for (int i = 0; i < detail::shm_fd_count; i++)
+            endpoint_.fds[i] = first_fd + i;
+        if (!endpoint_.attach(ec))
+            endpoint_ = detail::shm_endpoint{};
+    }
+};
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_POSIX_SHM_CHANNEL_CLIENT_HPP
@@ -79,10 +79,13 @@ struct vfork_launcher :  default_launcher
     {
         auto argv = this->build_argv_(executable, std::forward<Args>(args));
 
+        trace_begin_();
         ec = detail::on_setup(*this, executable, argv, inits ...);
+        trace_mark_(&launch_timestamps::setup_done);
         if (ec)
         {
             detail::on_error(*this, executable, argv, ec, inits...);
+            trace_end_(ec);
             return basic_process<Executor>(exec);
         }
 
@@ -100,13 +103,20 @@ struct vfork_launcher :  default_launcher
             detail::on_error(*this, executable, argv, ec, inits...);
 
             BOOST_PROCESS_V2_ASSIGN_EC(ec, errno, system_category());
+            trace_end_(ec);
             return basic_process<Executor>{exec};
         }
         else if (pid == 0)
         {
+            // the child shares the memory, so it records its timestamps directly
+            // and the parent is suspended until the exec, so the fork ends here.
+            trace_mark_(&launch_timestamps::child_start);
+            trace_.forked = trace_.child_start;
             ec = detail::on_exec_setup(*this, executable, argv, inits...);
+            trace_mark_(&launch_timestamps::exec_setup_done);
             if (!ec)
                 close_all_fds(ec);
+            trace_mark_(&launch_timestamps::exec_start);
             if (!ec)
                 ::execve(executable.c_str(), const_cast<char * const *>(argv), const_cast<char * const *>(env));
 
@@ -122,11 +132,13 @@ struct vfork_launcher :  default_launcher
         {
             detail::on_error(*this, executable, argv, ec, inits...);
             do { ::waitpid(pid, nullptr, 0); } while (errno == EINTR);
+            trace_end_(ec);
             return basic_process<Executor>{exec};
         }
 
         basic_process<Executor> proc(exec, pid);
         detail::on_success(*this, executable, argv, ec, inits...);
+        trace_end_(ec);
         return proc;
 
     }
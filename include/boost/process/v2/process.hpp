@@ -30,8 +30,18 @@
 #include <boost/core/exchange.hpp>
 #endif
 
+#if defined(BOOST_PROCESS_V2_POSIX)
+#include <sys/resource.h>
+#endif
+
 BOOST_PROCESS_V2_BEGIN_NAMESPACE
 
+#if defined(BOOST_PROCESS_V2_POSIX)
+/// Tag to make `basic_process::async_wait` also complete with the resource usage of the process.
+struct with_resource_usage_t {};
+constexpr static with_resource_usage_t with_resource_usage;
+#endif
+
 /// A class managing a subprocess
 /* A `basic_process` object manages a subprocess; it tracks the status and exit-code,
  * and will terminate the process on destruction if `detach` was not called.
@@ -82,6 +92,9 @@ struct basic_process
   basic_process(basic_process<Executor1>&& lhs)
           : process_handle_(std::move(lhs.process_handle_)),
             exit_status_{lhs.exit_status_}
+#if defined(BOOST_PROCESS_V2_POSIX)
+          , resource_usage_(lhs.resource_usage_)
+#endif
   {
   }
 
@@ -249,7 +262,11 @@ struct basic_process
   /// Unconditionally terminates the process and stores the exit code in exit_status.
   void terminate(error_code & ec)
   {
+#if defined(BOOST_PROCESS_V2_POSIX)
+    process_handle_.terminate(exit_status_, ec, &resource_usage_);
+#else
     process_handle_.terminate(exit_status_, ec);
+#endif
   }
 
   /// Throwing @overload wait(error_code & ec)
@@ -257,7 +274,7 @@ struct basic_process
   {
     error_code ec;
     if (running(ec))
-      process_handle_.wait(exit_status_, ec);
+      wait_(ec);
     if (ec)
       detail::throw_error(ec, "wait failed");
     return exit_code();
@@ -266,7 +283,7 @@ struct basic_process
   int wait(error_code & ec)
   {
     if (running(ec))
-        process_handle_.wait(exit_status_, ec);
+      wait_(ec);
     return exit_code();
   }
 
@@ -296,6 +313,17 @@ struct basic_process
   {
     return exit_status_;
   }
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+  /// The resource usage of the process, as reported by `wait4` when it was reaped.
+  /** This is only filled in once the process has exited, and is zero otherwise,
+   * e.g. if the process got reaped through another handle.
+   */
+  const struct rusage & resource_usage() const
+  {
+    return resource_usage_;
+  }
+#endif
   /// Checks if the current process is running. 
   /** If it has already completed the exit code will be stored internally 
    * and can be obtained by calling `exit_code.
@@ -306,7 +334,7 @@ struct basic_process
       return false;
     error_code ec;
     native_exit_code_type exit_code{};
-    auto r =  process_handle_.running(exit_code, ec);
+    auto r =  running_(exit_code, ec);
     if (!ec && !r)
       exit_status_ = exit_code;
     else
@@ -321,7 +349,7 @@ struct basic_process
     if (!process_is_running(exit_status_))
       return false;
     native_exit_code_type exit_code{};
-    auto r =  process_handle_.running(exit_code, ec);
+    auto r =  running_(exit_code, ec);
     if (!ec && !r)
       exit_status_ = exit_code;
     return r;
@@ -339,12 +367,39 @@ private:
 
   basic_process_handle<Executor> process_handle_;
   native_exit_code_type exit_status_{detail::still_active};
+#if defined(BOOST_PROCESS_V2_POSIX)
+  struct rusage resource_usage_{};
+
+  void wait_(error_code & ec)
+  {
+    process_handle_.wait(exit_status_, ec, &resource_usage_);
+  }
+
+  bool running_(native_exit_code_type & exit_code, error_code & ec)
+  {
+    return process_handle_.running(exit_code, ec, &resource_usage_);
+  }
+#else
+  void wait_(error_code & ec)
+  {
+    process_handle_.wait(exit_status_, ec);
+  }
+
+  bool running_(native_exit_code_type & exit_code, error_code & ec)
+  {
+    return process_handle_.running(exit_code, ec);
+  }
+#endif
 
   
+  template<bool WithUsage>
   struct async_wait_op_
   {
     basic_process_handle<Executor> & handle;
     native_exit_code_type & res;
+#if defined(BOOST_PROCESS_V2_POSIX)
+    struct rusage & usage;
+#endif
 
     template<typename Self>
     void operator()(Self && self)
@@ -353,45 +408,97 @@ private:
       {
         struct completer
         {
-            int code;
+            async_wait_op_ op;
             typename std::decay<Self>::type self;
             void operator()()
             {
-                self.complete(error_code{}, evaluate_exit_code(code));
+                op.complete_(self, error_code{});
             }
         };
 
         net::dispatch(
             net::get_associated_immediate_executor(handle, handle.get_executor()),
-            completer{static_cast<int>(res), std::move(self)});
+            completer{*this, std::move(self)});
       }
       else
-        handle.async_wait(res, std::move(self));
+        async_wait_(std::move(self));
     }
 
     template<typename Self>
     void operator()(Self && self, error_code ec)
     {
       if (!ec && process_is_running(res))
-        handle.async_wait(res, std::move(self));
+        async_wait_(std::move(self));
       else
-      {
-        std::move(self).complete(ec, evaluate_exit_code(res));
-      }
+        complete_(self, ec);
     }
+
+    template<typename Self>
+    void async_wait_(Self && self)
+    {
+#if defined(BOOST_PROCESS_V2_POSIX)
+      handle.async_wait(res, usage, std::move(self));
+#else
+      handle.async_wait(res, std::move(self));
+#endif
+    }
+
+    template<typename Self>
+    void complete_(Self & self, error_code ec)
+    {
+      complete_(self, ec, std::integral_constant<bool, WithUsage>{});
+    }
+
+    template<typename Self>
+    void complete_(Self & self, error_code ec, std::false_type)
+    {
+      std::move(self).complete(ec, evaluate_exit_code(res));
+    }
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+    template<typename Self>
+    void complete_(Self & self, error_code ec, std::true_type)
+    {
+      std::move(self).complete(ec, evaluate_exit_code(res), usage);
+    }
+#endif
   };
 
+  template<bool WithUsage>
+  async_wait_op_<WithUsage> make_async_wait_op_()
+  {
+#if defined(BOOST_PROCESS_V2_POSIX)
+    return async_wait_op_<WithUsage>{process_handle_, exit_status_, resource_usage_};
+#else
+    return async_wait_op_<WithUsage>{process_handle_, exit_status_};
+#endif
+  }
+
  public:
   /// Asynchronously wait for the process to exit and deliver the native exit-code in the completion handler.
   template <BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void (error_code, int))
   WaitHandler = net::default_completion_token_t<executor_type>>
   auto async_wait(WaitHandler && handler = net::default_completion_token_t<executor_type>())
     -> decltype(net::async_compose<WaitHandler, void (error_code, int)>(
-        async_wait_op_{process_handle_, exit_status_}, handler, process_handle_))
+        std::declval<async_wait_op_<false>>(), handler, process_handle_))
   {
     return net::async_compose<WaitHandler, void (error_code, int)>(
-        async_wait_op_{process_handle_, exit_status_}, handler, process_handle_);
+        make_async_wait_op_<false>(), handler, process_handle_);
   }
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+  /// Asynchronously wait for the process to exit and deliver the exit code and the resource usage.
+  template <BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void (error_code, int, struct rusage))
+  WaitHandler = net::default_completion_token_t<executor_type>>
+  auto async_wait(with_resource_usage_t,
+                  WaitHandler && handler = net::default_completion_token_t<executor_type>())
+    -> decltype(net::async_compose<WaitHandler, void (error_code, int, struct rusage)>(
+        std::declval<async_wait_op_<true>>(), handler, process_handle_))
+  {
+    return net::async_compose<WaitHandler, void (error_code, int, struct rusage)>(
+        make_async_wait_op_<true>(), handler, process_handle_);
+  }
+#endif
 };
 
 /// Process with the default executor.
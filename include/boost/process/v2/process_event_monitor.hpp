@@ -0,0 +1,433 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_PROCESS_EVENT_MONITOR_HPP
+#define BOOST_PROCESS_V2_PROCESS_EVENT_MONITOR_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/pid.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/posix/basic_stream_descriptor.hpp>
+#include <asio/steady_timer.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/posix/basic_stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+/// A change of a process on the system, see `process_event_monitor`.
+struct process_event
+{
+    enum kind_t
+    {
+        /// A new process, `parent` created `pid`.
+        fork,
+        /// The process `pid` executed a new program.
+        exec,
+        /// The process `pid` exited.
+        exit
+    } kind;
+    /// The process the event is about.
+    pid_type pid;
+    /// The parent of the process, as known when the event occurred.
+    pid_type parent;
+    /// The wait status of an exited process, -1 if unknown, i.e. when polling /proc.
+    int exit_status;
+};
+
+namespace detail
+{
+
+// The parent & children of every process on the system.
+struct process_tree
+{
+    process_tree() = default;
+    process_tree(const process_tree & ) = delete;
+    process_tree& operator=(const process_tree & ) = delete;
+    BOOST_PROCESS_V2_DECL ~process_tree();
+
+    // Add a process, replacing a previous one with the same pid.
+    BOOST_PROCESS_V2_DECL void add(pid_type pid, pid_type parent);
+    // Remove a process, its children get reparented to the parent the kernel gave them,
+    // read from /proc through a descriptor kept open for the lifetime of the tree.
+    BOOST_PROCESS_V2_DECL void remove(pid_type pid);
+    // Replace the tree with a scan of /proc, generating the events explaining the difference.
+    BOOST_PROCESS_V2_DECL void sync(const std::vector<std::pair<pid_type, pid_type>> & scan,
+                                    std::vector<process_event> & events);
+
+    BOOST_PROCESS_V2_DECL pid_type parent(pid_type pid) const;
+    BOOST_PROCESS_V2_DECL std::vector<pid_type> children(pid_type pid) const;
+    bool contains(pid_type pid) const {return nodes_.count(pid) != 0u;}
+    std::size_t size() const {return nodes_.size();}
+    void clear() {nodes_.clear();}
+
+  private:
+    struct node
+    {
+        pid_type parent = -1;
+        std::vector<pid_type> children;
+    };
+    void unlink_(pid_type pid, pid_type parent);
+    std::unordered_map<pid_type, node> nodes_;
+    int proc_fd_ = -1;
+};
+
+// Opens a non-blocking netlink socket & subscribes to the proc connector, without waiting for the kernel to confirm.
+BOOST_PROCESS_V2_DECL int open_proc_connector(error_code & ec);
+BOOST_PROCESS_V2_DECL void close_proc_connector(int fd);
+// Reads all pending events, ignoring threads. Fails with no_buffer_space if events were dropped.
+// Sets acknowledged when the kernel confirmed the subscription, or fails with its error, e.g. operation_not_permitted
+// without CAP_NET_ADMIN. Inside a pid or user namespace the subscription is ignored, so no acknowledgement arrives.
+BOOST_PROCESS_V2_DECL void read_proc_events(int fd, std::vector<process_event> & events,
+                                            bool & acknowledged, error_code & ec);
+// Lists all processes with their parents.
+BOOST_PROCESS_V2_DECL void scan_processes(std::vector<std::pair<pid_type, pid_type>> & scan, error_code & ec);
+
+}
+
+/// Tracks all processes of the system through the proc connector of linux.
+/** The monitor maintains a process tree, updated by the fork, exec & exit events the kernel sends,
+ * so the parent & children of a process can be looked up without scanning /proc.
+ *
+ * The proc connector requires `CAP_NET_ADMIN` in the initial namespaces; where it isn't available,
+ * the monitor falls back to scanning /proc at the polling interval, synthesizing fork & exit events
+ * from the differences. Exec events and processes that start & exit between two scans are missed then.
+ * The kernel confirms the subscription asynchronously, so the fallback might only start up to 250ms after `start`.
+ * If the kernel drops events because the socket buffer overflowed, the tree gets rebuilt the same way.
+ *
+ * When a process exits, its children are reparented as the kernel does, i.e. to init or a subreaper.
+ *
+ * @par Example
+ * @code {.cpp}
+ * asio::io_context ctx;
+ * process_event_monitor mon{ctx};
+ * mon.on_event(
+ *      [](const process_event & ev)
+ *      {
+ *          if (ev.kind == process_event::exec)
+ *              log_exec(ev.pid);
+ *      });
+ * mon.start();
+ * auto children = mon.child_pids(current_pid());
+ * @endcode
+ */
+template<typename Executor = net::any_io_executor>
+struct basic_process_event_monitor
+{
+    /// The executor of the monitor
+    using executor_type = Executor;
+    /// Get the executor of the monitor
+    executor_type get_executor() {return state_->timer.get_executor();}
+
+    /// The callback type for the events.
+    using callback_type = std::function<void(const process_event &)>;
+
+    /// Rebinds the monitor to another executor.
+    template <typename Executor1>
+    struct rebind_executor
+    {
+        /// The monitor type when rebound to the specified executor.
+        typedef basic_process_event_monitor<Executor1> other;
+    };
+
+    /// Create a monitor, polling /proc at `poll_interval` if the proc connector isn't available.
+    explicit basic_process_event_monitor(executor_type exec,
+                                         std::chrono::steady_clock::duration poll_interval = std::chrono::seconds(1))
+        : state_(std::make_shared<state>(std::move(exec), poll_interval))
+    {
+    }
+
+    /// Create a monitor, polling /proc at `poll_interval` if the proc connector isn't available.
+    template <typename ExecutionContext>
+    explicit basic_process_event_monitor(ExecutionContext & context,
+                                         std::chrono::steady_clock::duration poll_interval = std::chrono::seconds(1),
+                                         typename std::enable_if<
+                                             std::is_convertible<ExecutionContext&,
+                                                  net::execution_context&>::value, void *>::type = nullptr)
+        : basic_process_event_monitor(executor_type(context.get_executor()), poll_interval)
+    {
+    }
+
+    basic_process_event_monitor(basic_process_event_monitor && ) = default;
+    basic_process_event_monitor& operator=(basic_process_event_monitor && lhs)
+    {
+        stop();
+        state_ = std::move(lhs.state_);
+        return *this;
+    }
+
+    /// Stops the monitor.
+    ~basic_process_event_monitor()
+    {
+        stop();
+    }
+
+    /// Invoke a callback for every event.
+    void on_event(callback_type cb)
+    {
+        state_->on_event = std::move(cb);
+    }
+
+    /// Start monitoring, throws if neither the proc connector nor /proc can be read.
+    void start()
+    {
+        error_code ec;
+        start(ec);
+        if (ec)
+            detail::throw_error(ec, "process_event_monitor::start");
+    }
+
+    /// Start monitoring.
+    /** Subscribes to the proc connector, then builds the process tree from /proc.
+     * No events are reported for the initial tree. This doesn't wait for the kernel to confirm the subscription,
+     * so `is_polling` might change once the confirmation failed or didn't arrive in time.
+     */
+    void start(error_code & ec)
+    {
+        auto & st = *state_;
+        if (st.running)
+            return;
+
+        error_code ign;
+        const int fd = detail::open_proc_connector(ign);
+        st.polling = fd == -1;
+        st.acknowledged = false;
+        if (fd != -1)
+        {
+            st.socket.assign(fd, ec);
+            if (ec)
+            {
+                detail::close_proc_connector(fd);
+                return;
+            }
+        }
+
+        // the subscription comes first, so no event gets lost between the scan & the first read.
+        st.tree.clear();
+        detail::scan_processes(st.scan, ec);
+        if (ec)
+        {
+            close_(st);
+            return;
+        }
+        st.tree.sync(st.scan, st.events);
+        st.events.clear();
+
+        st.running = true;
+        if (st.polling)
+            schedule_poll_(state_, ++st.run);
+        else
+        {
+            schedule_ack_timeout_(state_, ++st.run);
+            schedule_read_(state_, st.run);
+        }
+    }
+
+    /// Stop monitoring, the monitor can be restarted later, which rebuilds the tree.
+    void stop()
+    {
+        if (!state_)
+            return;
+        auto & st = *state_;
+        st.running = false;
+        st.timer.cancel();
+        close_(st);
+    }
+
+    /// Check if the monitor is running.
+    bool running() const {return state_->running;}
+
+    /// Check if the monitor falls back to polling /proc, because the proc connector isn't available.
+    bool is_polling() const {return state_->polling;}
+
+    /// The children of a process, as known to the monitor.
+    std::vector<pid_type> child_pids(pid_type pid) const {return state_->tree.children(pid);}
+
+    /// The parent of a process, as known to the monitor, or -1 if the process is unknown.
+    pid_type parent_pid(pid_type pid) const {return state_->tree.parent(pid);}
+
+    /// Check if the process is known to the monitor.
+    bool contains(pid_type pid) const {return state_->tree.contains(pid);}
+
+    /// The number of known processes.
+    std::size_t size() const {return state_->tree.size();}
+
+  private:
+    struct state
+    {
+        state(executor_type exec, std::chrono::steady_clock::duration interval)
+            : socket(exec), timer(std::move(exec)), interval(interval)
+        {
+        }
+        ~state()
+        {
+            if (socket.is_open())
+                detail::close_proc_connector(socket.release());
+        }
+
+        net::posix::basic_stream_descriptor<Executor> socket;
+        net::basic_waitable_timer<std::chrono::steady_clock,
+                                  net::wait_traits<std::chrono::steady_clock>,
+                                  executor_type> timer;
+        std::chrono::steady_clock::duration interval;
+        bool running = false;
+        bool polling = false;
+        // the kernel confirmed the subscription to the proc connector.
+        bool acknowledged = false;
+        // identifies the current chain of waits, so a completion queued before a restart is ignored
+        std::size_t run = 0u;
+        detail::process_tree tree;
+        callback_type on_event;
+        std::vector<process_event> events;
+        std::vector<std::pair<pid_type, pid_type>> scan;
+    };
+
+    std::shared_ptr<state> state_;
+
+    static void close_(state & st)
+    {
+        if (st.socket.is_open())
+        {
+            st.socket.cancel();
+            detail::close_proc_connector(st.socket.release());
+        }
+    }
+
+    static void schedule_read_(const std::shared_ptr<state> & st, std::size_t run)
+    {
+        st->socket.async_wait(
+            net::posix::descriptor_base::wait_read,
+            [st, run](error_code ec)
+            {
+                if (ec || !st->running || st->run != run)
+                    return;
+                st->events.clear();
+                const bool acknowledged = st->acknowledged;
+                detail::read_proc_events(st->socket.native_handle(), st->events, st->acknowledged, ec);
+                if (st->acknowledged && !acknowledged)
+                    st->timer.cancel();
+                for (auto & ev : st->events)
+                {
+                    if (ev.kind == process_event::fork)
+                        st->tree.add(ev.pid, ev.parent);
+                    else if (ev.kind == process_event::exit)
+                    {
+                        ev.parent = st->tree.parent(ev.pid);
+                        st->tree.remove(ev.pid);
+                    }
+                    else
+                        ev.parent = st->tree.parent(ev.pid);
+                }
+                if (ec == net::error::no_buffer_space)
+                {
+                    // the kernel dropped events, so the tree needs to be rebuilt.
+                    if (!resync_(*st))
+                        return;
+                }
+                else if (ec)
+                {
+                    // the socket is broken, continue by polling.
+                    close_(*st);
+                    st->polling = true;
+                    if (!dispatch_(st, run))
+                        return;
+                    schedule_poll_(st, run);
+                    return;
+                }
+                if (!dispatch_(st, run))
+                    return;
+                schedule_read_(st, run);
+            });
+    }
+
+    // falls back to polling if the kernel ignored the subscription, e.g. inside a pid namespace.
+    static void schedule_ack_timeout_(const std::shared_ptr<state> & st, std::size_t run)
+    {
+        st->timer.expires_after(std::chrono::milliseconds(250));
+        st->timer.async_wait(
+            [st, run](error_code ec)
+            {
+                if (ec || !st->running || st->run != run || st->acknowledged)
+                    return;
+                close_(*st);
+                st->polling = true;
+                st->events.clear();
+                if (!resync_(*st) || !dispatch_(st, run))
+                    return;
+                schedule_poll_(st, run);
+            });
+    }
+
+    static void schedule_poll_(const std::shared_ptr<state> & st, std::size_t run)
+    {
+        st->timer.expires_after(st->interval);
+        st->timer.async_wait(
+            [st, run](error_code ec)
+            {
+                if (ec || !st->running || st->run != run)
+                    return;
+                st->events.clear();
+                if (!resync_(*st) || !dispatch_(st, run))
+                    return;
+                schedule_poll_(st, run);
+            });
+    }
+
+    // appends the events explaining the difference to a new scan, false if /proc couldn't be read.
+    static bool resync_(state & st)
+    {
+        error_code ec;
+        detail::scan_processes(st.scan, ec);
+        if (ec)
+        {
+            st.running = false;
+            close_(st);
+            return false;
+        }
+        st.tree.sync(st.scan, st.events);
+        return true;
+    }
+
+    // invokes the callback, returns false if it stopped or restarted the monitor.
+    static bool dispatch_(const std::shared_ptr<state> & st, std::size_t run)
+    {
+        if (!st->on_event)
+            return true;
+        // the callback may restart the monitor, which reuses the event buffer.
+        auto events = std::move(st->events);
+        for (auto & ev : events)
+        {
+            st->on_event(ev);
+            if (!st->running || st->run != run)
+                return false;
+        }
+        events.clear();
+        st->events = std::move(events);
+        return true;
+    }
+};
+
+/// A process_event_monitor with the default executor.
+typedef basic_process_event_monitor<> process_event_monitor;
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_PROCESS_EVENT_MONITOR_HPP
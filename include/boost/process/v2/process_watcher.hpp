@@ -0,0 +1,358 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_PROCESS_WATCHER_HPP
+#define BOOST_PROCESS_V2_PROCESS_WATCHER_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+
+#include <boost/process/v2/detail/complete_immediately.hpp>
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/exit_code.hpp>
+#include <boost/process/v2/pid.hpp>
+#include <boost/process/v2/posix/detail/pidfd_wait_set.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/compose.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/compose.hpp>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace detail
+{
+
+BOOST_PROCESS_V2_DECL int open_pidfd(pid_type pid, error_code & ec);
+BOOST_PROCESS_V2_DECL void send_signal_to_pidfd(int pidfd, int sig, error_code & ec);
+// Gets the wait status of an exited child without reaping it, or -1 if it isn't a child.
+BOOST_PROCESS_V2_DECL int peek_exit_status(int pidfd);
+
+}
+
+/// Watches arbitrary processes for their exit, children or not (linux only).
+/** Every watched process is referred to by a pidfd, which is registered in one epoll set,
+ * so thousands of processes take a single descriptor in the reactor. Signals are sent through
+ * the pidfd, so they can't hit another process reusing the pid.
+ *
+ * The exit code is only available for children of this process, which the watcher never reaps,
+ * so they still need to be waited for. For other processes it is -1.
+ *
+ * A process stops being watched once its exit got delivered to its waits. If it exited while nobody waited,
+ * it stays watched until the next wait, which completes right away.
+ *
+ * @par Example
+ * @code {.cpp}
+ * asio::io_context ctx;
+ * process_watcher watcher{ctx};
+ * for (auto pid : pids_of_interest)
+ *   watcher.async_wait(pid, [pid](error_code ec, int) {log_exit(pid);});
+ * ctx.run();
+ * @endcode
+ */
+template<typename Executor = net::any_io_executor>
+struct basic_process_watcher
+{
+    /// The executor of the watcher.
+    using executor_type = Executor;
+    /// Get the executor of the watcher.
+    executor_type get_executor() {return state_->set.get_executor();}
+
+    /// Rebinds the watcher to another executor.
+    template <typename Executor1>
+    struct rebind_executor
+    {
+        /// The watcher type when rebound to the specified executor.
+        typedef basic_process_watcher<Executor1> other;
+    };
+
+    /// Create a watcher.
+    explicit basic_process_watcher(executor_type exec)
+        : state_(std::make_shared<state>(std::move(exec)))
+    {
+    }
+
+    /// Create a watcher.
+    template <typename ExecutionContext>
+    explicit basic_process_watcher(ExecutionContext & context,
+                                   typename std::enable_if<
+                                       std::is_convertible<ExecutionContext&,
+                                            net::execution_context&>::value, void *>::type = nullptr)
+        : basic_process_watcher(executor_type(context.get_executor()))
+    {
+    }
+
+    basic_process_watcher(basic_process_watcher && ) = default;
+    basic_process_watcher& operator=(basic_process_watcher && lhs)
+    {
+        cancel();
+        state_ = std::move(lhs.state_);
+        return *this;
+    }
+
+    /// Cancels all pending waits.
+    ~basic_process_watcher()
+    {
+        cancel();
+    }
+
+    /// Start watching a process. Fails with `no_such_process` if it doesn't exist.
+    void watch(pid_type pid, error_code & ec)
+    {
+        watch_(*state_, pid, ec);
+    }
+
+    /// Throwing @overload void watch(pid_type pid, error_code & ec)
+    void watch(pid_type pid)
+    {
+        error_code ec;
+        watch_(*state_, pid, ec);
+        if (ec)
+            detail::throw_error(ec, "watch");
+    }
+
+    /// Stop watching a process, its pending waits complete with `operation_aborted`.
+    void unwatch(pid_type pid)
+    {
+        auto & st = *state_;
+        auto itr = st.entries.find(pid);
+        if (itr == st.entries.end())
+            return;
+        auto e = std::move(itr->second);
+        st.entries.erase(itr);
+        st.close_entry(e);
+        st.pending -= e.waiters.size();
+        for (auto & w : e.waiters)
+            w->complete(net::error::operation_aborted, -1);
+        // don't keep the executor busy with nobody waiting.
+        if (st.pending == 0u && st.armed)
+            st.cancel();
+    }
+
+    /// Check if a process is watched.
+    bool watching(pid_type pid) const {return state_->entries.count(pid) != 0u;}
+
+    /// Check if a watched process has exited.
+    bool exited(pid_type pid) const
+    {
+        auto itr = state_->entries.find(pid);
+        return itr != state_->entries.end() && itr->second.exited;
+    }
+
+    /// The number of watched processes.
+    std::size_t size() const {return state_->entries.size();}
+
+    /// Send a signal to a watched process.
+    /** Fails with `bad_descriptor` if the process isn't watched and `no_such_process` if it exited. */
+    void send_signal(pid_type pid, int sig, error_code & ec)
+    {
+        auto itr = state_->entries.find(pid);
+        if (itr == state_->entries.end())
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+        }
+        else if (itr->second.exited)
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, ESRCH, system_category());
+        }
+        else
+            detail::send_signal_to_pidfd(itr->second.pidfd, sig, ec);
+    }
+
+    /// Throwing @overload void send_signal(pid_type pid, int sig, error_code & ec)
+    void send_signal(pid_type pid, int sig)
+    {
+        error_code ec;
+        send_signal(pid, sig, ec);
+        if (ec)
+            detail::throw_error(ec, "send_signal");
+    }
+
+    /// Cancel all pending waits, which complete with `operation_aborted`. The processes stay watched.
+    void cancel()
+    {
+        if (!state_)
+            return;
+        auto & st = *state_;
+        std::vector<std::unique_ptr<posix::detail::pidfd_waiter>> waiters;
+        for (auto & e : st.entries)
+        {
+            for (auto & w : e.second.waiters)
+                waiters.push_back(std::move(w));
+            e.second.waiters.clear();
+        }
+        st.pending = 0u;
+        for (auto & w : waiters)
+            w->complete(net::error::operation_aborted, -1);
+        st.cancel();
+    }
+
+  private:
+    struct entry
+    {
+        // closed once the process exited.
+        int pidfd = -1;
+        bool exited = false;
+        int exit_code = -1;
+        std::vector<std::unique_ptr<posix::detail::pidfd_waiter>> waiters;
+    };
+
+    struct state : posix::detail::basic_pidfd_wait_set<Executor>
+    {
+        // the entries by pid, which is also the key in the epoll set.
+        std::unordered_map<pid_type, entry> entries;
+        // the number of pending waits.
+        std::size_t pending = 0u;
+
+        explicit state(executor_type exec) : posix::detail::basic_pidfd_wait_set<Executor>(std::move(exec)) {}
+
+        ~state()
+        {
+            for (auto & e : entries)
+                if (e.second.pidfd != -1)
+                    ::close(e.second.pidfd);
+        }
+
+        bool waiting() const {return pending != 0u;}
+
+        void close_entry(entry & e)
+        {
+            if (e.pidfd == -1)
+                return;
+            this->remove(e.pidfd);
+            ::close(e.pidfd);
+            e.pidfd = -1;
+        }
+
+        void on_exit(std::uint64_t key)
+        {
+            auto itr = entries.find(static_cast<pid_type>(key));
+            if (itr == entries.end() || itr->second.exited)
+                return;
+            auto & e = itr->second;
+            const auto status = detail::peek_exit_status(e.pidfd);
+            e.exited = true;
+            e.exit_code = status == -1 ? -1 : evaluate_exit_code(status);
+            close_entry(e);
+            // without waiters, the exit gets delivered by the next wait.
+            if (e.waiters.empty())
+                return;
+            const auto exit_code = e.exit_code;
+            auto waiters = std::move(e.waiters);
+            entries.erase(itr);
+            pending -= waiters.size();
+            for (auto & w : waiters)
+                w->complete(error_code{}, exit_code);
+        }
+
+        void on_error(error_code ec)
+        {
+            pending = 0u;
+            for (auto & e : entries)
+            {
+                auto waiters = std::move(e.second.waiters);
+                e.second.waiters.clear();
+                for (auto & w : waiters)
+                    w->complete(ec, -1);
+            }
+        }
+    };
+
+    static entry * watch_(state & st, pid_type pid, error_code & ec)
+    {
+        auto itr = st.entries.find(pid);
+        if (itr != st.entries.end())
+            return &itr->second;
+
+        const int fd = detail::open_pidfd(pid, ec);
+        if (ec)
+            return nullptr;
+        st.add(fd, static_cast<std::uint64_t>(pid), ec);
+        if (ec)
+        {
+            ::close(fd);
+            return nullptr;
+        }
+        auto & e = st.entries[pid];
+        e.pidfd = fd;
+        return &e;
+    }
+
+    struct wait_op_
+    {
+        std::shared_ptr<state> st;
+        pid_type pid;
+
+        template<typename Self>
+        void operator()(Self && self)
+        {
+            error_code ec;
+            auto e = watch_(*st, pid, ec);
+            int exit_code = -1;
+            if (e != nullptr && !e->exited)
+            {
+                auto s = st;
+                using self_type = typename std::decay<Self>::type;
+                e->waiters.emplace_back(new posix::detail::pidfd_waiter_impl<self_type, executor_type>(
+                        std::move(self), s->set.get_executor()));
+                s->pending++;
+                state::arm(s);
+                return;
+            }
+            else if (e != nullptr)
+            {
+                // the exit was noticed while nobody waited, this delivers it.
+                exit_code = e->exit_code;
+                st->entries.erase(pid);
+            }
+
+            detail::complete_immediately(std::move(self), st->set.get_executor(), ec, exit_code);
+        }
+
+        template<typename Self>
+        void operator()(Self && self, error_code ec, int exit_code)
+        {
+            self.complete(ec, exit_code);
+        }
+    };
+
+    std::shared_ptr<state> state_;
+
+  public:
+    /// Wait for a process to exit, watching it if it isn't yet.
+    /**
+     * @par Completion Signature
+     * `void(error_code, int)`, with the exit code of a child, or -1 for other processes.
+     */
+    template<BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, int))
+             WaitHandler = net::default_completion_token_t<executor_type>>
+    auto async_wait(pid_type pid,
+                    WaitHandler && handler = net::default_completion_token_t<executor_type>())
+        -> decltype(net::async_compose<WaitHandler, void(error_code, int)>(
+                wait_op_{nullptr, pid}, handler, std::declval<executor_type>()))
+    {
+        return net::async_compose<WaitHandler, void(error_code, int)>(
+                wait_op_{state_, pid}, handler, state_->set.get_executor());
+    }
+};
+
+/// A process_watcher with the default executor.
+typedef basic_process_watcher<> process_watcher;
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_PROCESS_WATCHER_HPP
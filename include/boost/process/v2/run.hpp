@@ -0,0 +1,127 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_RUN_HPP
+#define BOOST_PROCESS_V2_RUN_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/cstring_ref.hpp>
+#include <boost/process/v2/pid.hpp>
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+/// The outcome of `run`.
+struct run_result
+{
+    /// The exit code of the subprocess.
+    int exit_code = -1;
+    /// Everything the subprocess wrote to stdout.
+    std::string out;
+    /// Everything the subprocess wrote to stderr.
+    std::string err;
+};
+
+/// Runs processes synchronously, capturing their output without an io_context.
+/** The stdin, stdout & stderr pipes and, on linux, a pidfd of the subprocess get driven by a single `poll` loop,
+ * so the subprocess can't block on a full pipe, regardless of the order it writes them in.
+ * The argument storage is kept across runs, as is the capacity of the strings of a reused `run_result`.
+ *
+ * The subprocess inherits the environment & working directory, all other descriptors get closed.
+ * A runner is not thread-safe, but runners on different threads are independent.
+ */
+struct runner
+{
+    /// Run `exe` with `args`, writing `stdin_data` to its stdin, and wait until it exited & closed its output.
+    template<typename Args>
+    void run(const filesystem::path & exe, const Args & args, string_view stdin_data,
+             run_result & result, error_code & ec)
+    {
+        args_.clear();
+        for (auto && arg : args)
+        {
+            const string_view arg_ = arg;
+            args_.emplace_back(arg_.data(), arg_.size());
+        }
+        run_(exe, stdin_data, result, ec);
+    }
+
+    /// Run `exe` with `args`, writing `stdin_data` to its stdin, and wait until it exited & closed its output.
+    template<typename Args>
+    void run(const filesystem::path & exe, const Args & args, string_view stdin_data, run_result & result)
+    {
+        error_code ec;
+        run(exe, args, stdin_data, result, ec);
+        if (ec)
+            detail::throw_error(ec, "run");
+    }
+
+    /// Run `exe` with `args`, writing `stdin_data` to its stdin, and wait until it exited & closed its output.
+    void run(const filesystem::path & exe, std::initializer_list<string_view> args, string_view stdin_data,
+             run_result & result, error_code & ec)
+    {
+        run<std::initializer_list<string_view>>(exe, args, stdin_data, result, ec);
+    }
+
+    /// Run `exe` with `args`, writing `stdin_data` to its stdin, and wait until it exited & closed its output.
+    void run(const filesystem::path & exe, std::initializer_list<string_view> args, string_view stdin_data,
+             run_result & result)
+    {
+        run<std::initializer_list<string_view>>(exe, args, stdin_data, result);
+    }
+
+  private:
+    BOOST_PROCESS_V2_DECL void run_(const filesystem::path & exe, string_view stdin_data,
+                                    run_result & result, error_code & ec);
+
+    std::vector<std::string> args_;
+    std::vector<const char *> argv_;
+    // the reads from stdout & stderr go here first.
+    std::vector<char> buffer_;
+};
+
+/// Run a process synchronously, capturing its stdout & stderr.
+template<typename Args>
+run_result run(const filesystem::path & exe, const Args & args, string_view stdin_data, error_code & ec)
+{
+    run_result res;
+    runner().run(exe, args, stdin_data, res, ec);
+    return res;
+}
+
+/// Run a process synchronously, capturing its stdout & stderr.
+template<typename Args>
+run_result run(const filesystem::path & exe, const Args & args, string_view stdin_data = {})
+{
+    run_result res;
+    runner().run(exe, args, stdin_data, res);
+    return res;
+}
+
+/// Run a process synchronously, capturing its stdout & stderr.
+inline run_result run(const filesystem::path & exe, std::initializer_list<string_view> args,
+                      string_view stdin_data, error_code & ec)
+{
+    return run<std::initializer_list<string_view>>(exe, args, stdin_data, ec);
+}
+
+/// Run a process synchronously, capturing its stdout & stderr.
+inline run_result run(const filesystem::path & exe, std::initializer_list<string_view> args,
+                      string_view stdin_data = {})
+{
+    return run<std::initializer_list<string_view>>(exe, args, stdin_data);
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
+
+#endif //BOOST_PROCESS_V2_RUN_HPP
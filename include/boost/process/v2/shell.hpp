@@ -20,6 +20,12 @@ BOOST_PROCESS_V2_BEGIN_NAMESPACE
 extern BOOST_PROCESS_V2_DECL const error_category& get_shell_category();
 static const error_category& shell_category = get_shell_category();
 
+#if defined(BOOST_PROCESS_V2_POSIX)
+/// Tag type requesting the expansion of variables & a leading `~` from `shell`.
+struct shell_expand_t {};
+constexpr static shell_expand_t shell_expand;
+#endif
+
 /// Utility to parse commands 
 /** This utility class parses command lines into tokens
  * and allows users to executed based on textual inputs.
@@ -42,6 +48,9 @@ static const error_category& shell_category = get_shell_category();
  * 
  * @endcode
  * 
+ * On posix the input is split according to the shell's quoting rules,
+ * but nothing is expanded or globbed, unless `shell_expand` is passed.
+ * The arguments are stored in a single allocation.
  * 
  */
 struct shell
@@ -64,6 +73,21 @@ struct shell
     }
 
     shell(basic_cstring_ref<char_type> input) : input_(input) {parse_();}
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+    /// Parse the input and expand `$NAME`, `${NAME}` and a leading `~` or `~user`.
+    /** Command substitutions are rejected. Unlike a shell,
+     * the result of an expansion is not split into multiple arguments.
+     */
+    shell(basic_cstring_ref<char_type> input, shell_expand_t) : input_(input) {parse_(true);}
+
+    template<typename Char, typename Traits>
+    shell(basic_string_view<Char, Traits> input, shell_expand_t)
+        : buffer_(detail::conv_string<char_type>(input.data(), input.size()))
+    {
+        parse_(true);
+    }
+#endif
     shell(basic_string_view<
                     typename std::conditional<
                         std::is_same<char_type, char>::value,
@@ -123,7 +147,7 @@ struct shell
 
     friend struct make_cmd_shell_;
 
-    BOOST_PROCESS_V2_DECL void parse_();
+    BOOST_PROCESS_V2_DECL void parse_(bool expand = false);
     
     // storage in case we need a conversion
     std::basic_string<char_type> buffer_;
@@ -133,7 +157,7 @@ struct shell
     char_type  ** argv_ = nullptr;
 
 #if defined(BOOST_PROCESS_V2_POSIX)
-    void(*free_argv_)(int, char **);
+    void(*free_argv_)(int, char **) = nullptr;
 #endif
     
 };
@@ -15,12 +15,16 @@
 #include <boost/process/v2/default_launcher.hpp>
 #include <cstddef>
 #if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/buffer.hpp>
 #include <asio/connect_pipe.hpp>
 #else
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/connect_pipe.hpp>
 #endif
 
 #if defined(BOOST_PROCESS_V2_POSIX)
+#include <boost/process/v2/posix/detail/memory_fd.hpp>
+#include <cstdint>
 #include <fcntl.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -54,6 +58,24 @@ struct is_writable_pipe<asio::basic_writable_pipe<Executor>> : std::true_type
 {
 };
 
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+/// A region of a file to be used as the stdin of a subprocess.
+/** A region reaching the end of the file is passed as a read-only descriptor to the file,
+ * otherwise the kernel copies it into a sealed in-memory file.
+ */
+struct file_region
+{
+  /// The file to read from.
+  filesystem::path path;
+  /// The offset in bytes where the region starts.
+  std::uint64_t offset = 0u;
+  /// The length of the region in bytes, by default up to the end of the file.
+  std::uint64_t length = static_cast<std::uint64_t>(-1);
+};
+
+#endif
+
 namespace detail
 {
 
@@ -221,6 +243,29 @@ struct process_io_binding
   {
   }
 
+  template<typename ConstBuffer>
+  process_io_binding(const ConstBuffer & data,
+                     typename std::enable_if<std::is_convertible<ConstBuffer, net::const_buffer>::value
+                                             && Target == STDIN_FILENO>::type * = nullptr)
+  {
+    const net::const_buffer buf = data;
+    fd = posix::detail::open_memory_fd(buf.data(), buf.size(), ec);
+    if (ec)
+      detail::throw_error(ec, "open_memory_fd");
+    fd_needs_closing = true;
+  }
+
+  template<typename FileRegion>
+  process_io_binding(const FileRegion & region,
+                     typename std::enable_if<std::is_same<FileRegion, file_region>::value
+                                             && Target == STDIN_FILENO>::type * = nullptr)
+  {
+    fd = posix::detail::open_file_region(region.path, region.offset, region.length, ec);
+    if (ec)
+      detail::throw_error(ec, "open_file_region");
+    fd_needs_closing = true;
+  }
+
   template<typename ReadablePipe>
   process_io_binding(ReadablePipe & readable_pipe,
                      typename std::enable_if<is_readable_pipe<ReadablePipe>::value && Target != STDIN_FILENO>::type * = nullptr)
@@ -322,6 +367,8 @@ typedef process_io_binding<STDERR_FILENO> process_error_binding;
  *  - `native_handle` any native file handle (`HANDLE` on windows) or file descriptor (`int` on posix)
  *  - any io-object with a .native_handle() function that is compatible with the above. E.g. a asio::ip::tcp::socket
  *  - an asio::basic_writeable_pipe for stdin or asio::basic_readable_pipe for stderr/stdout. 
+ *  - (posix only) an asio::const_buffer for stdin, which gets copied into a sealed in-memory file.
+ *  - (posix only) a `file_region` for stdin, so the child reads (part of) a file without a pipe.
  * 
  * 
  */ 
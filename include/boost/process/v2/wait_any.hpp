@@ -0,0 +1,404 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROCESS_V2_WAIT_ANY_HPP
+#define BOOST_PROCESS_V2_WAIT_ANY_HPP
+
+#include <boost/process/v2/detail/config.hpp>
+#include <boost/process/v2/detail/complete_immediately.hpp>
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/process.hpp>
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#if !defined(BOOST_PROCESS_V2_WINDOWS)
+#if defined(BOOST_PROCESS_V2_STANDALONE)
+#include <asio/associated_allocator.hpp>
+#include <asio/compose.hpp>
+#include <asio/recycling_allocator.hpp>
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+#include <asio/posix/basic_stream_descriptor.hpp>
+#else
+#include <asio/signal_set.hpp>
+#endif
+#else
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/recycling_allocator.hpp>
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+#include <boost/asio/posix/basic_stream_descriptor.hpp>
+#else
+#include <boost/asio/signal_set.hpp>
+#endif
+#endif
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace detail
+{
+
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+// Waits for one of the handles to be signaled & returns its index.
+BOOST_PROCESS_V2_DECL std::size_t wait_for_any_handle(void * const * handles, std::size_t count, error_code & ec);
+#elif defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+// An epoll set of pidfds, that reports the index a pidfd was added with.
+BOOST_PROCESS_V2_DECL int open_wait_set(error_code & ec);
+BOOST_PROCESS_V2_DECL void close_wait_set(int set);
+BOOST_PROCESS_V2_DECL void add_to_wait_set(int set, int pidfd, std::size_t index, error_code & ec);
+// Returns the index of an exited process, or npos if none exited within the timeout.
+BOOST_PROCESS_V2_DECL std::size_t next_in_wait_set(int set, int timeout, error_code & ec);
+BOOST_PROCESS_V2_DECL void remove_from_wait_set(int set, int pidfd, error_code & ec);
+// Gets the indices of up to size exited processes without blocking, returns their number.
+BOOST_PROCESS_V2_DECL std::size_t drain_wait_set(int set, std::uint64_t * indices, std::size_t size, error_code & ec);
+#else
+// Blocks until one of the child processes exited, without reaping it, & returns its index.
+BOOST_PROCESS_V2_DECL std::size_t wait_for_any_pid(const pid_type * pids, std::size_t count, error_code & ec);
+#endif
+
+template<typename Range>
+using range_process_t = typename std::decay<decltype(*std::begin(std::declval<Range&>()))>::type;
+
+// Finds the first process that exited, ignoring those not open.
+// Returns true if one exited or an error occurred.
+template<typename Range>
+bool find_exited_(Range & procs, std::size_t & index, bool & any_open, error_code & ec)
+{
+    index = 0u;
+    for (auto & p : procs)
+    {
+        if (p.is_open())
+        {
+            any_open = true;
+            if (!p.running(ec))
+                return true;
+        }
+        index++;
+    }
+    return false;
+}
+
+template<typename Range>
+range_process_t<Range> & nth_process_(Range & procs, std::size_t index)
+{
+    return *std::next(std::begin(procs), static_cast<std::ptrdiff_t>(index));
+}
+
+}
+
+/// The result of `wait_any`.
+struct wait_any_result
+{
+    /// The position of the process in the range.
+    std::size_t index;
+    /// The exit code of the process.
+    int exit_code;
+};
+
+/// Wait for the first of many processes to exit.
+/** The range needs to contain `basic_process` objects, of which the exited one gets reaped.
+ * Processes that have already exited are reported right away, processes that are not open get ignored.
+ *
+ * On linux all pidfds get registered in a single epoll set, so the wait takes one syscall
+ * regardless of the number of processes. The BSDs & apple register the processes with a kqueue,
+ * other posix systems wait for any child with `waitid`. Windows waits on up to 64 process handles at once,
+ * more get waited for by the wait threads of the thread pool.
+ *
+ * The index is unspecified if an error occurred.
+ */
+template<typename Range>
+wait_any_result wait_any(Range & procs, error_code & ec)
+{
+    wait_any_result res{0u, -1};
+    bool any_open = false;
+    if (detail::find_exited_(procs, res.index, any_open, ec))
+    {
+        if (!ec)
+            res.exit_code = detail::nth_process_(procs, res.index).exit_code();
+        return res;
+    }
+    if (!any_open)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+        return res;
+    }
+
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+    std::vector<void*> handles;
+    std::vector<std::size_t> indices;
+    std::size_t idx = 0u;
+    for (auto & p : procs)
+    {
+        if (p.is_open())
+        {
+            handles.push_back(p.native_handle());
+            indices.push_back(idx);
+        }
+        idx++;
+    }
+    const auto n = detail::wait_for_any_handle(handles.data(), handles.size(), ec);
+    if (ec)
+        return res;
+    res.index = indices[n];
+#elif defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+    const int set = detail::open_wait_set(ec);
+    if (ec)
+        return res;
+    std::size_t idx = 0u;
+    for (auto & p : procs)
+    {
+        if (p.is_open())
+            detail::add_to_wait_set(set, p.handle().pidfd(), idx, ec);
+        if (ec)
+            break;
+        idx++;
+    }
+    if (!ec)
+        res.index = detail::next_in_wait_set(set, -1, ec);
+    detail::close_wait_set(set);
+    if (ec)
+        return res;
+#else
+    std::vector<pid_type> pids;
+    std::vector<std::size_t> indices;
+    std::size_t idx = 0u;
+    for (auto & p : procs)
+    {
+        if (p.is_open())
+        {
+            pids.push_back(p.id());
+            indices.push_back(idx);
+        }
+        idx++;
+    }
+    const auto n = detail::wait_for_any_pid(pids.data(), pids.size(), ec);
+    if (ec)
+        return res;
+    res.index = indices[n];
+#endif
+    res.exit_code = detail::nth_process_(procs, res.index).wait(ec);
+    return res;
+}
+
+/// Throwing @overload wait_any_result wait_any(Range & procs, error_code & ec)
+template<typename Range>
+wait_any_result wait_any(Range & procs)
+{
+    error_code ec;
+    auto res = wait_any(procs, ec);
+    if (ec)
+        detail::throw_error(ec, "wait_any");
+    return res;
+}
+
+/// Wait for all processes in the range to exit.
+/** The exit codes can be obtained from the processes afterwards. */
+template<typename Range>
+void wait_all(Range & procs, error_code & ec)
+{
+    // waiting in order is as good as it gets, since every wait only blocks until the slowest exited.
+    for (auto & p : procs)
+    {
+        if (!p.is_open())
+            continue;
+        p.wait(ec);
+        if (ec)
+            return;
+    }
+}
+
+/// Throwing @overload void wait_all(Range & procs, error_code & ec)
+template<typename Range>
+void wait_all(Range & procs)
+{
+    error_code ec;
+    wait_all(procs, ec);
+    if (ec)
+        detail::throw_error(ec, "wait_all");
+}
+
+#if !defined(BOOST_PROCESS_V2_WINDOWS)
+
+namespace detail
+{
+
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+template<typename Executor>
+using wait_any_set_t = net::posix::basic_stream_descriptor<Executor>;
+#else
+template<typename Executor>
+using wait_any_set_t = net::basic_signal_set<Executor>;
+#endif
+
+// Frees the set with the allocator it was allocated with.
+template<typename Executor, typename Allocator>
+struct wait_any_set_deleter
+{
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<wait_any_set_t<Executor>>;
+    allocator_type alloc;
+
+    void operator()(wait_any_set_t<Executor> * set)
+    {
+        using traits = std::allocator_traits<allocator_type>;
+        traits::destroy(alloc, set);
+        traits::deallocate(alloc, set, 1u);
+    }
+};
+
+template<typename Range, typename Executor, typename Allocator>
+struct async_wait_any_op_
+{
+    Range & procs;
+    // the signal set gets created before the first check, so no SIGCHLD gets missed.
+    std::unique_ptr<wait_any_set_t<Executor>, wait_any_set_deleter<Executor, Allocator>> set;
+
+    template<typename Self>
+    void operator()(Self && self)
+    {
+        self.reset_cancellation_state(net::enable_total_cancellation());
+        error_code ec;
+        std::size_t index = 0u;
+        int exit_code = -1;
+        bool any_open = false;
+        if (find_exited_(procs, index, any_open, ec))
+        {
+            if (!ec)
+                exit_code = nth_process_(procs, index).exit_code();
+        }
+        else if (!any_open)
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+        }
+        else
+        {
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+            const int fd = open_wait_set(ec);
+            if (!ec)
+            {
+                set->assign(fd, ec);
+                if (ec)
+                    close_wait_set(fd);
+            }
+            std::size_t idx = 0u;
+            for (auto & p : procs)
+            {
+                if (ec)
+                    break;
+                if (p.is_open())
+                    add_to_wait_set(fd, p.handle().pidfd(), idx, ec);
+                idx++;
+            }
+            if (!ec)
+            {
+                set->async_wait(net::posix::descriptor_base::wait_read, std::move(self));
+                return;
+            }
+#else
+            set->async_wait(std::move(self));
+            return;
+#endif
+        }
+
+        auto exec = set->get_executor();
+        // free the set before the upcall, so the handler can reuse the memory.
+        set.reset();
+        detail::complete_immediately(std::move(self), exec, ec, index, exit_code);
+    }
+
+    template<typename Self>
+    void operator()(Self && self, error_code ec, int = 0)
+    {
+        std::size_t index = 0u;
+        int exit_code = -1;
+        if (!ec)
+        {
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+            index = next_in_wait_set(set->native_handle(), 0, ec);
+            if (!ec && index == static_cast<std::size_t>(-1))
+            {
+                set->async_wait(net::posix::descriptor_base::wait_read, std::move(self));
+                return;
+            }
+#else
+            bool any_open = false;
+            if (!find_exited_(procs, index, any_open, ec))
+            {
+                set->async_wait(std::move(self));
+                return;
+            }
+#endif
+            if (!ec)
+                exit_code = nth_process_(procs, index).wait(ec);
+        }
+        set.reset();
+        std::move(self).complete(ec, index, exit_code);
+    }
+};
+
+template<typename Range>
+using range_executor_t = typename range_process_t<Range>::executor_type;
+
+template<typename Range>
+struct initiate_wait_any
+{
+    // The set gets allocated with the handler's allocator, which defaults to the recycling allocator,
+    // so that repeated waits reuse the memory of the previous one.
+    template<typename Handler>
+    void operator()(Handler && handler, Range * procs) const
+    {
+        using executor_type = range_executor_t<Range>;
+        using handler_type = typename std::decay<Handler>::type;
+        using allocator_type = typename net::associated_allocator<
+                handler_type, net::recycling_allocator<void>>::type;
+        using deleter_type = wait_any_set_deleter<executor_type, allocator_type>;
+        using traits = std::allocator_traits<typename deleter_type::allocator_type>;
+
+        typename deleter_type::allocator_type alloc{
+                net::get_associated_allocator(handler, net::recycling_allocator<void>())};
+        auto exec = std::begin(*procs)->get_executor();
+        auto p = traits::allocate(alloc, 1u);
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+        traits::construct(alloc, p, exec);
+#else
+        traits::construct(alloc, p, exec, SIGCHLD);
+#endif
+        std::unique_ptr<wait_any_set_t<executor_type>, deleter_type> set(p, deleter_type{alloc});
+
+        net::async_compose<handler_type, void(error_code, std::size_t, int)>(
+            async_wait_any_op_<Range, executor_type, allocator_type>{*procs, std::move(set)}, handler, exec);
+    }
+};
+
+}
+
+/// Asynchronously wait for the first of many processes to exit (posix only).
+/** The range needs to contain `basic_process` objects, must not be empty & needs to outlive the operation.
+ * The exited process gets reaped and its index & exit code passed to the handler.
+ *
+ * On linux all pidfds get registered in a single epoll set, that is waited on as one descriptor,
+ * so this doesn't need an operation per process. Other posix systems check all processes on every `SIGCHLD`.
+ * The set gets allocated with the associated allocator of the handler.
+ *
+ * Cancelling the operation does not affect the processes.
+ */
+template<typename Range,
+         BOOST_PROCESS_V2_COMPLETION_TOKEN_FOR(void(error_code, std::size_t, int))
+            WaitHandler = net::default_completion_token_t<detail::range_executor_t<Range>>>
+auto async_wait_any(Range & procs,
+                    WaitHandler && handler = net::default_completion_token_t<detail::range_executor_t<Range>>())
+  -> decltype(net::async_initiate<WaitHandler, void(error_code, std::size_t, int)>(
+        detail::initiate_wait_any<Range>{}, handler, &procs))
+{
+    return net::async_initiate<WaitHandler, void(error_code, std::size_t, int)>(
+        detail::initiate_wait_any<Range>{}, handler, &procs);
+}
+
+#endif
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif //BOOST_PROCESS_V2_WAIT_ANY_HPP
@@ -0,0 +1 @@
+#include <boost/process/v2/wait_any.hpp>
@@ -0,0 +1,415 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/cached_execute.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace
+{
+
+// The layout of a result file, followed by the key, stdout & stderr.
+struct entry_header
+{
+    char magic[8];
+    std::int32_t exit_code;
+    std::uint32_t reserved;
+    std::uint64_t key_size;
+    std::uint64_t out_size;
+    std::uint64_t err_size;
+};
+
+constexpr char entry_magic[8] = {'b', 'p', 'v', '2', 'e', 'x', 'e', '1'};
+constexpr char entry_suffix[] = ".entry";
+
+// FNV-1a, only used to name the files; the key itself gets compared on lookup.
+std::uint64_t fnv1a(const char * data, std::size_t size, std::uint64_t h = 14695981039346656037ull)
+{
+    for (std::size_t i = 0u; i < size; i++)
+    {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Checks the sizes in the header against the size of the body one by one, so corrupt ones can't overflow.
+bool sizes_match(const entry_header & hdr, std::uint64_t body_size)
+{
+    if (hdr.key_size > body_size)
+        return false;
+    body_size -= hdr.key_size;
+    if (hdr.out_size > body_size)
+        return false;
+    body_size -= hdr.out_size;
+    return hdr.err_size == body_size;
+}
+
+std::string entry_name(const std::string & key)
+{
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(fnv1a(key.data(), key.size())));
+    return std::string(buf) + entry_suffix;
+}
+
+void append_field(std::string & key, const char * data, std::size_t size)
+{
+    const auto sz = static_cast<std::uint64_t>(size);
+    key.append(reinterpret_cast<const char*>(&sz), sizeof(sz));
+    key.append(data, size);
+}
+
+void append_field(std::string & key, const std::string & value)
+{
+    append_field(key, value.data(), value.size());
+}
+
+void append_field(std::string & key, std::uint64_t value)
+{
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::uint64_t mtime_ns(const struct stat & st)
+{
+#if defined(__APPLE__)
+    const auto & ts = st.st_mtimespec;
+#else
+    const auto & ts = st.st_mtim;
+#endif
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+bool write_all(int fd, const char * data, std::size_t size, error_code & ec)
+{
+    while (size > 0u)
+    {
+        const auto n = ::write(fd, data, size);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// hashes the content of the executable through a read-only mapping.
+void append_content_hash(std::string & key, int fd, std::uint64_t size, error_code & ec)
+{
+    std::uint64_t h = fnv1a(nullptr, 0u);
+    if (size > 0u)
+    {
+        void * p = ::mmap(nullptr, static_cast<std::size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return;
+        }
+        h = fnv1a(static_cast<const char*>(p), static_cast<std::size_t>(size));
+        ::munmap(p, static_cast<std::size_t>(size));
+    }
+    append_field(key, h);
+}
+
+}
+
+namespace detail
+{
+
+std::string execution_key(const filesystem::path & exe,
+                          const std::vector<std::string> & args,
+                          const execution_inputs & inputs,
+                          error_code & ec)
+{
+    std::string key = "bpv2-execution-key-1";
+
+    const auto exe_ = filesystem::canonical(exe, ec);
+    if (ec)
+        return key;
+    const int fd = ::open(exe_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return key;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fd);
+        return key;
+    }
+
+    append_field(key, exe_.native());
+    if (inputs.hash_content)
+        append_content_hash(key, fd, static_cast<std::uint64_t>(st.st_size), ec);
+    else
+    {
+        append_field(key, static_cast<std::uint64_t>(st.st_dev));
+        append_field(key, static_cast<std::uint64_t>(st.st_ino));
+        append_field(key, static_cast<std::uint64_t>(st.st_size));
+        append_field(key, mtime_ns(st));
+    }
+    ::close(fd);
+    if (ec)
+        return key;
+
+    append_field(key, static_cast<std::uint64_t>(args.size()));
+    for (auto & arg : args)
+        append_field(key, arg);
+
+    append_field(key, static_cast<std::uint64_t>(inputs.env_keys.size()));
+    for (auto & name : inputs.env_keys)
+    {
+        append_field(key, name);
+        const char * value = ::getenv(name.c_str());
+        // distinguish unset from empty.
+        if (value == nullptr)
+            append_field(key, "\0", 1u);
+        else
+            append_field(key, value, std::strlen(value));
+    }
+
+    append_field(key, inputs.stdin_data);
+
+    const auto cwd = inputs.cwd.empty() ? filesystem::current_path(ec) : filesystem::canonical(inputs.cwd, ec);
+    append_field(key, cwd.native());
+    return key;
+}
+
+}
+
+execution_cache::execution_cache(const filesystem::path & directory, std::uint64_t max_size, error_code & ec)
+    : directory_(directory), max_size_(max_size)
+{
+    open_(ec);
+}
+
+void execution_cache::open_(error_code & ec)
+{
+    filesystem::create_directories(directory_, ec);
+    if (ec)
+        return;
+
+    struct found
+    {
+        std::string name;
+        std::uint64_t size;
+        std::uint64_t mtime;
+    };
+    std::vector<found> files;
+
+    for (filesystem::directory_iterator itr{directory_, ec}, end; !ec && itr != end; itr.increment(ec))
+    {
+        const auto name = itr->path().filename().native();
+        if (name.size() <= sizeof(entry_suffix) - 1u ||
+            name.compare(name.size() - (sizeof(entry_suffix) - 1u), std::string::npos, entry_suffix) != 0)
+            continue;
+
+        struct stat st;
+        if (::stat(itr->path().c_str(), &st) == -1 || !S_ISREG(st.st_mode))
+            continue;
+        files.push_back(found{name, static_cast<std::uint64_t>(st.st_size), mtime_ns(st)});
+    }
+    if (ec)
+        return;
+
+    // the modification time is the last use, so the LRU order survives the process.
+    std::sort(files.begin(), files.end(), [](const found & l, const found & r) {return l.mtime > r.mtime;});
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto & f : files)
+    {
+        lru_.push_back(f.name);
+        entries_[f.name] = entry{std::prev(lru_.end()), f.size};
+        stats_.size += f.size;
+    }
+    evict_();
+}
+
+void execution_cache::touch_(const std::string & name, std::uint64_t size)
+{
+    auto itr = entries_.find(name);
+    if (itr != entries_.end())
+    {
+        stats_.size -= itr->second.size;
+        lru_.splice(lru_.begin(), lru_, itr->second.lru);
+        itr->second.size = size;
+    }
+    else
+    {
+        lru_.push_front(name);
+        entries_[name] = entry{lru_.begin(), size};
+    }
+    stats_.size += size;
+}
+
+void execution_cache::remove_(const std::string & name)
+{
+    auto itr = entries_.find(name);
+    if (itr == entries_.end())
+        return;
+    stats_.size -= itr->second.size;
+    lru_.erase(itr->second.lru);
+    entries_.erase(itr);
+}
+
+void execution_cache::evict_()
+{
+    while (stats_.size > max_size_ && !lru_.empty())
+    {
+        const auto name = lru_.back();
+        ::unlink((directory_ / name).c_str());
+        remove_(name);
+        stats_.evictions++;
+    }
+}
+
+bool execution_cache::lookup(const std::string & key, execution_result & result)
+{
+    const auto name = entry_name(key);
+    const auto pth = directory_ / name;
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    const int fd = ::open(pth.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        // removed by another process
+        remove_(name);
+        stats_.misses++;
+        return false;
+    }
+
+    bool hit = false;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && static_cast<std::uint64_t>(st.st_size) >= sizeof(entry_header))
+    {
+        const auto size = static_cast<std::size_t>(st.st_size);
+        void * p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            const auto data = static_cast<const char*>(p);
+            entry_header hdr;
+            std::memcpy(&hdr, data, sizeof(hdr));
+            const auto body = data + sizeof(hdr);
+            if (std::memcmp(hdr.magic, entry_magic, sizeof(entry_magic)) == 0
+                && sizes_match(hdr, size - sizeof(hdr))
+                && hdr.key_size == key.size()
+                && std::memcmp(body, key.data(), key.size()) == 0)
+            {
+                result.exit_code = hdr.exit_code;
+                result.out.assign(body + hdr.key_size, static_cast<std::size_t>(hdr.out_size));
+                result.err.assign(body + hdr.key_size + hdr.out_size, static_cast<std::size_t>(hdr.err_size));
+                result.cached = true;
+                hit = true;
+            }
+            ::munmap(p, size);
+        }
+    }
+
+    if (hit)
+    {
+        // the modification time marks the last use for other processes.
+        ::futimens(fd, nullptr);
+        touch_(name, static_cast<std::uint64_t>(st.st_size));
+        stats_.hits++;
+    }
+    else
+        stats_.misses++;
+
+    ::close(fd);
+    return hit;
+}
+
+void execution_cache::store(const std::string & key, const execution_result & result, error_code & ec)
+{
+    const auto name = entry_name(key);
+    const auto pth = directory_ / name;
+    // unique, so concurrent stores of the same key, from any cache object or process, can't mix their files.
+    std::string tmp = pth.native() + ".tmp.XXXXXX";
+
+    entry_header hdr{};
+    std::memcpy(hdr.magic, entry_magic, sizeof(entry_magic));
+    hdr.exit_code = result.exit_code;
+    hdr.key_size = key.size();
+    hdr.out_size = result.out.size();
+    hdr.err_size = result.err.size();
+    const auto size = sizeof(hdr) + key.size() + result.out.size() + result.err.size();
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    const int fd = ::mkstemp(&tmp[0]);
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    // mkstemp creates the file only readable by the owner.
+    ::fchmod(fd, 0644);
+    const bool written = write_all(fd, reinterpret_cast<const char*>(&hdr), sizeof(hdr), ec)
+                      && write_all(fd, key.data(), key.size(), ec)
+                      && write_all(fd, result.out.data(), result.out.size(), ec)
+                      && write_all(fd, result.err.data(), result.err.size(), ec);
+    ::close(fd);
+
+    // readers only ever see complete files.
+    if (!written || ::rename(tmp.c_str(), pth.c_str()) == -1)
+    {
+        if (written)
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::unlink(tmp.c_str());
+        return;
+    }
+
+    touch_(name, static_cast<std::uint64_t>(size));
+    stats_.stores++;
+    evict_();
+}
+
+void execution_cache::clear(error_code & ec)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    while (!lru_.empty())
+    {
+        const auto name = lru_.back();
+        if (::unlink((directory_ / name).c_str()) == -1 && errno != ENOENT)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return;
+        }
+        remove_(name);
+    }
+}
+
+execution_cache_statistics execution_cache::statistics() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto res = stats_;
+    res.entries = entries_.size();
+    return res;
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
@@ -0,0 +1,117 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/child_monitor.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace detail
+{
+
+int open_proc_dir(error_code & ec)
+{
+    const int fd = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+    return fd;
+}
+
+void close_proc_dir(int fd)
+{
+    ::close(fd);
+}
+
+bool read_proc_stat(int proc_fd, pid_type pid, char * buf, std::size_t size,
+                    proc_stat & st, error_code & ec)
+{
+    char path[32];
+    ::snprintf(path, sizeof(path), "%d/stat", static_cast<int>(pid));
+    const int fd = ::openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return false;
+    }
+
+    ssize_t n;
+    do
+        n = ::read(fd, buf, size - 1u);
+    while (n == -1 && errno == EINTR);
+    if (n == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+    ::close(fd);
+    if (n <= 0)
+    {
+        if (!ec)
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, ESRCH, system_category());
+        return false;
+    }
+    buf[n] = '\0';
+
+    // the command name in parentheses may contain anything, so start after the last ')'
+    auto p = std::strrchr(buf, ')');
+    if (p == nullptr)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+        return false;
+    }
+    p++;
+
+    // field 3 (state) is the first after the name; utime & stime are 14 & 15, vsize & rss 23 & 24.
+    std::uint64_t fields[22];
+    for (int i = 0; i < 22; i++)
+    {
+        while (*p == ' ')
+            p++;
+        if (*p == '\0')
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+            return false;
+        }
+        char * end;
+        fields[i] = std::strtoull(p, &end, 10);
+        // skip non numeric fields like the state
+        while (*end != ' ' && *end != '\0')
+            end++;
+        p = end;
+    }
+
+    st.user_ticks     = fields[11];
+    st.system_ticks   = fields[12];
+    st.virtual_memory = fields[20];
+    st.resident_pages = fields[21];
+    return true;
+}
+
+std::uint64_t clock_ticks_per_second()
+{
+    const auto res = ::sysconf(_SC_CLK_TCK);
+    return res > 0 ? static_cast<std::uint64_t>(res) : 100u;
+}
+
+std::uint64_t page_size()
+{
+    const auto res = ::sysconf(_SC_PAGESIZE);
+    return res > 0 ? static_cast<std::uint64_t>(res) : 4096u;
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
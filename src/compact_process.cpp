@@ -0,0 +1,90 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/compact_process.hpp>
+
+#include <cerrno>
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+void compact_process::open_(pid_type pid, error_code & ec)
+{
+    const auto fd = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+    pid_ = pid;
+    pidfd_ = fd;
+}
+
+void compact_process::close_()
+{
+    if (pidfd_ != -1)
+        ::close(pidfd_);
+    pidfd_ = -1;
+    pid_ = -1;
+}
+
+void compact_process::signal_(int sig, error_code & ec)
+{
+    if (pidfd_ == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, net::error::bad_descriptor);
+    }
+    else if (::syscall(SYS_pidfd_send_signal, pidfd_, sig, nullptr, 0) == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+}
+
+bool compact_process::running(error_code & ec)
+{
+    if (!process_is_running(exit_status_) || pid_ <= 0)
+        return false;
+
+    int code = 0;
+    const int res = ::waitpid(pid_, &code, WNOHANG);
+    if (res == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+    }
+    else if (res == 0)
+        return true;
+    else
+        exit_status_ = code;
+    return false;
+}
+
+int compact_process::wait(error_code & ec)
+{
+    if (!running(ec) || ec)
+        return exit_code();
+
+    int code = 0;
+    while (::waitpid(pid_, &code, 0) == -1)
+    {
+        if (errno != EINTR)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return exit_code();
+        }
+    }
+    exit_status_ = code;
+    return exit_code();
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
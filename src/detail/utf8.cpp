@@ -10,6 +10,21 @@
 
 #if defined(BOOST_PROCESS_V2_WINDOWS)
 #include <windows.h>
+#else
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#endif
+
+// The ascii fast paths assume a 4 byte wchar_t, i.e. UCS-4.
+#if !defined(BOOST_PROCESS_V2_WINDOWS) && defined(__SIZEOF_WCHAR_T__) && (__SIZEOF_WCHAR_T__ == 4)
+# if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define BOOST_PROCESS_V2_UTF8_SSE2 1
+# elif defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define BOOST_PROCESS_V2_UTF8_NEON 1
+# endif
 #endif
 
 BOOST_PROCESS_V2_BEGIN_NAMESPACE
@@ -105,8 +120,176 @@ std::size_t convert_to_wide(const char *in, std::size_t size,  wchar_t * out,
     return static_cast<std::size_t>(res);
 }
 
+// the windows api cannot convert partially, so a buffer that's too small converts nothing.
+std::size_t convert_some_to_utf8(const wchar_t * in, std::size_t size, char * out,
+                                 std::size_t max_size, const wchar_t * & next, error_code & ec)
+{
+    next = in;
+    if (size == 0u)
+        return 0u;
+    const auto res = convert_to_utf8(in, size, out, max_size, ec);
+    if (!ec)
+        next = in + size;
+    return res;
+}
+
+std::size_t convert_some_to_wide(const char * in, std::size_t size, wchar_t * out,
+                                 std::size_t max_size, const char * & next, error_code & ec)
+{
+    next = in;
+    if (size == 0u)
+        return 0u;
+    const auto res = convert_to_wide(in, size, out, max_size, ec);
+    if (!ec)
+        next = in + size;
+    return res;
+}
+
 #else
 
+// The number of leading ascii characters.
+inline std::size_t ascii_length(const char * in, std::size_t n)
+{
+    std::size_t i = 0u;
+#if defined(BOOST_PROCESS_V2_UTF8_SSE2)
+    for (; i + 16u <= n; i += 16u)
+    {
+        const int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        if (mask != 0)
+            return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned int>(mask)));
+    }
+#elif defined(BOOST_PROCESS_V2_UTF8_NEON)
+    for (; i + 16u <= n; i += 16u)
+        if (vmaxvq_u8(vld1q_u8(reinterpret_cast<const std::uint8_t*>(in + i))) >= 0x80u)
+            break;
+#else
+    for (; i + 8u <= n; i += 8u)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, in + i, sizeof(word));
+        if ((word & 0x8080808080808080ull) != 0u)
+            break;
+    }
+#endif
+    while (i < n && static_cast<unsigned char>(in[i]) < 0x80u)
+        i++;
+    return i;
+}
+
+inline bool is_ascii(wchar_t c)
+{
+    return static_cast<std::uint32_t>(c) < 0x80u;
+}
+
+// The number of leading ascii characters.
+inline std::size_t ascii_length(const wchar_t * in, std::size_t n)
+{
+    std::size_t i = 0u;
+#if defined(BOOST_PROCESS_V2_UTF8_SSE2)
+    const __m128i high = _mm_set1_epi32(~0x7F);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8u <= n; i += 8u)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4u));
+        const __m128i hi = _mm_and_si128(_mm_or_si128(a, b), high);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(hi, zero)) != 0xFFFF)
+            break;
+    }
+#elif defined(BOOST_PROCESS_V2_UTF8_NEON)
+    for (; i + 8u <= n; i += 8u)
+    {
+        const uint32x4_t a = vld1q_u32(reinterpret_cast<const std::uint32_t*>(in + i));
+        const uint32x4_t b = vld1q_u32(reinterpret_cast<const std::uint32_t*>(in + i + 4u));
+        if (vmaxvq_u32(vorrq_u32(a, b)) >= 0x80u)
+            break;
+    }
+#endif
+    while (i < n && is_ascii(in[i]))
+        i++;
+    return i;
+}
+
+// Widen the leading ascii characters, returns how many were converted.
+inline std::size_t widen_ascii(const char * in, std::size_t n, wchar_t * out)
+{
+    std::size_t i = 0u;
+#if defined(BOOST_PROCESS_V2_UTF8_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16u <= n; i += 16u)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        if (_mm_movemask_epi8(v) != 0)
+            break;
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        const auto o = reinterpret_cast<__m128i*>(out + i);
+        _mm_storeu_si128(o,      _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(o + 1u, _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(o + 2u, _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(o + 3u, _mm_unpackhi_epi16(hi, zero));
+    }
+#elif defined(BOOST_PROCESS_V2_UTF8_NEON)
+    for (; i + 16u <= n; i += 16u)
+    {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t*>(in + i));
+        if (vmaxvq_u8(v) >= 0x80u)
+            break;
+        const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+        const auto o = reinterpret_cast<std::uint32_t*>(out + i);
+        vst1q_u32(o,       vmovl_u16(vget_low_u16(lo)));
+        vst1q_u32(o + 4u,  vmovl_u16(vget_high_u16(lo)));
+        vst1q_u32(o + 8u,  vmovl_u16(vget_low_u16(hi)));
+        vst1q_u32(o + 12u, vmovl_u16(vget_high_u16(hi)));
+    }
+#endif
+    for (; i < n && static_cast<unsigned char>(in[i]) < 0x80u; i++)
+        out[i] = static_cast<wchar_t>(in[i]);
+    return i;
+}
+
+// Narrow the leading ascii characters, returns how many were converted.
+inline std::size_t narrow_ascii(const wchar_t * in, std::size_t n, char * out)
+{
+    std::size_t i = 0u;
+#if defined(BOOST_PROCESS_V2_UTF8_SSE2)
+    const __m128i high = _mm_set1_epi32(~0x7F);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16u <= n; i += 16u)
+    {
+        const auto p = reinterpret_cast<const __m128i*>(in + i);
+        const __m128i a = _mm_loadu_si128(p);
+        const __m128i b = _mm_loadu_si128(p + 1u);
+        const __m128i c = _mm_loadu_si128(p + 2u);
+        const __m128i d = _mm_loadu_si128(p + 3u);
+        const __m128i hi = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), high);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(hi, zero)) != 0xFFFF)
+            break;
+        const __m128i ab = _mm_packs_epi32(a, b);
+        const __m128i cd = _mm_packs_epi32(c, d);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(ab, cd));
+    }
+#elif defined(BOOST_PROCESS_V2_UTF8_NEON)
+    for (; i + 16u <= n; i += 16u)
+    {
+        const auto p = reinterpret_cast<const std::uint32_t*>(in + i);
+        const uint32x4_t a = vld1q_u32(p);
+        const uint32x4_t b = vld1q_u32(p + 4u);
+        const uint32x4_t c = vld1q_u32(p + 8u);
+        const uint32x4_t d = vld1q_u32(p + 12u);
+        if (vmaxvq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d))) >= 0x80u)
+            break;
+        const uint16x8_t ab = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+        const uint16x8_t cd = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+        vst1q_u8(reinterpret_cast<std::uint8_t*>(out + i), vcombine_u8(vmovn_u16(ab), vmovn_u16(cd)));
+    }
+#endif
+    for (; i < n && is_ascii(in[i]); i++)
+        out[i] = static_cast<char>(in[i]);
+    return i;
+}
+
 
 template<std::size_t s>
 inline int get_cont_octet_out_count_impl(wchar_t word) {
@@ -205,7 +388,17 @@ std::size_t size_as_utf8(const wchar_t * in, std::size_t size, error_code &)
     std::size_t res = 0u;
     const auto from_end = in + size;
     for (auto from = in; from != from_end; from++)
+    {
+        if (is_ascii(*from))
+        {
+            const auto n = ascii_length(from, from_end - from);
+            res += n;
+            from += n;
+            if (from == from_end)
+                break;
+        }
         res += get_cont_octet_out_count(*from) + 1;
+    }
     return res;
 }
 
@@ -214,37 +407,53 @@ std::size_t size_as_wide(const  char   * in, std::size_t size, error_code &)
     const auto from = in;
     const auto from_end = from + size;
     const char * from_next = from;
+    std::size_t res = 0u;
     while (from_next < from_end)
     {
+        if (static_cast<unsigned char>(*from_next) < 0x80u)
+        {
+            const auto n = ascii_length(from_next, from_end - from_next);
+            res += n;
+            from_next += n;
+            continue;
+        }
         unsigned int octet_count = get_octet_count(*from_next);
         // The buffer may represent incomplete characters, so terminate early if one is found
         if (octet_count > static_cast<std::size_t>(from_end - from_next))
             break;
         from_next += octet_count;
+        res++;
     }
 
-    return from_next - from;
+    return res;
 }
 
-std::size_t convert_to_utf8(const wchar_t * in, std::size_t size,
-                            char   * out, std::size_t max_size, error_code & ec)
+std::size_t convert_some_to_utf8(const wchar_t * in, std::size_t size,
+                                 char   * out, std::size_t max_size,
+                                 const wchar_t * & from_next, error_code & ec)
 {
 
     const wchar_t * from = in;
     const wchar_t * from_end = from + size;
-    const wchar_t * & from_next = from;
     char * to = out;
     char * to_end = out + max_size;
-    char * & to_next = to;
+    char * to_next = to;
 
     const wchar_t * const octet1_modifier_table = get_octet1_modifier_table();
     wchar_t max_wchar = (std::numeric_limits<wchar_t>::max)();
     while (from != from_end && to != to_end) {
 
+        if (is_ascii(*from))
+        {
+            const auto n = narrow_ascii(from, (std::min)(from_end - from, to_end - to), to);
+            from += n;
+            to += n;
+            continue;
+        }
+
         // Check for invalid UCS-4 character
         if (*from  > max_wchar) {
             from_next = from;
-            to_next = to;
             BOOST_PROCESS_V2_ASSIGN_EC(ec, error::invalid_character, error::get_utf8_category());
             return 0u;
         }
@@ -274,7 +483,7 @@ std::size_t convert_to_utf8(const wchar_t * in, std::size_t size,
             from_next = from;
             to_next = to - (i + 1);
             BOOST_PROCESS_V2_ASSIGN_EC(ec, error::insufficient_buffer, error::get_utf8_category());
-            return 0u;
+            return to_next - out;
         }
         ++from;
     }
@@ -288,20 +497,27 @@ std::size_t convert_to_utf8(const wchar_t * in, std::size_t size,
     return to_next - out;
 }
 
+std::size_t convert_to_utf8(const wchar_t * in, std::size_t size,
+                            char   * out, std::size_t max_size, error_code & ec)
+{
+    const wchar_t * next;
+    return convert_some_to_utf8(in, size, out, max_size, next, ec);
+}
+
 inline bool invalid_leading_octet(unsigned char octet_1) {
     return (0x7f < octet_1 && octet_1 < 0xc0) ||
            (octet_1 > 0xfd);
 }
 
-std::size_t convert_to_wide(const  char   * in, std::size_t size,
-                            wchar_t * out, std::size_t max_size, error_code & ec)
+std::size_t convert_some_to_wide(const  char   * in, std::size_t size,
+                                 wchar_t * out, std::size_t max_size,
+                                 const char * & from_next, error_code & ec)
 {
     const char * from = in;
     const char * from_end = from + size;
-    const char * & from_next = from;
     wchar_t * to = out;
     wchar_t * to_end = out + max_size;
-    wchar_t * & to_next = to;
+    wchar_t * to_next = to;
 
     // Basic algorithm: The first octet determines how many
     // octets total make up the UCS-4 character. The remaining
@@ -314,6 +530,14 @@ std::size_t convert_to_wide(const  char   * in, std::size_t size,
     const wchar_t * const octet1_modifier_table = detail::get_octet1_modifier_table();
     while (from != from_end && to != to_end) {
 
+        if (static_cast<unsigned char>(*from) < 0x80u)
+        {
+            const auto n = widen_ascii(from, (std::min)(from_end - from, to_end - to), to);
+            from += n;
+            to += n;
+            continue;
+        }
+
         // Error checking on the first octet
         if (invalid_leading_octet(*from)) {
             from_next = from;
@@ -360,7 +584,7 @@ std::size_t convert_to_wide(const  char   * in, std::size_t size,
             from_next = from - (i + 1);
             to_next = to;
             BOOST_PROCESS_V2_ASSIGN_EC(ec, error::insufficient_buffer, error::get_utf8_category());
-            return 0u;
+            return to_next - out;
         }
         *to++ = ucs_result;
     }
@@ -373,6 +597,13 @@ std::size_t convert_to_wide(const  char   * in, std::size_t size,
     return to_next - out;
 }
 
+std::size_t convert_to_wide(const  char   * in, std::size_t size,
+                            wchar_t * out, std::size_t max_size, error_code & ec)
+{
+    const char * next;
+    return convert_some_to_wide(in, size, out, max_size, next, ec);
+}
+
 #endif
 
 }
@@ -13,6 +13,8 @@
 #include <boost/process/v2/default_launcher.hpp>
 #include <boost/process/v2/environment.hpp>
 
+#include <cstring>
+
 BOOST_PROCESS_V2_BEGIN_NAMESPACE
 
 #if defined(BOOST_PROCESS_V2_WINDOWS)
@@ -28,6 +30,31 @@ error_code process_environment::on_setup(windows::default_launcher & launcher, c
     return ec;
 };
 
+error_code environment::overlay::on_setup(windows::default_launcher & launcher, const filesystem::path &, const std::wstring &)
+{
+    if (deltas_.empty())
+      return error_code{};
+
+    block_.clear();
+    for (key_value_pair_view kv : current())
+    {
+      if (overrides_(kv.key()))
+        continue;
+      const auto nv = kv.native();
+      block_.insert(block_.end(), nv.begin(), nv.end());
+      block_.push_back(L'\0');
+    }
+
+    for (auto & d : deltas_)
+      if (!d.removed)
+        block_.insert(block_.end(), d.pair.c_str(), d.pair.c_str() + d.pair.size() + 1);
+
+    block_.push_back(L'\0');
+    launcher.creation_flags |= CREATE_UNICODE_ENVIRONMENT;
+    launcher.environment = block_.data();
+    return error_code{};
+};
+
 #else
 
 error_code process_environment::on_setup(posix::default_launcher & launcher, const filesystem::path &, const char * const *)
@@ -36,6 +63,30 @@ error_code process_environment::on_setup(posix::default_launcher & launcher, con
     return error_code{};
 };
 
+error_code environment::overlay::on_setup(posix::default_launcher & launcher, const filesystem::path &, const char * const *)
+{
+    if (deltas_.empty())
+      return error_code{};
+
+    // untouched entries point into the current environment, so only the changed ones are copied.
+    envp_.clear();
+    for (auto e = environment::detail::load_native_handle(); *e != nullptr; e++)
+    {
+      const char * eq = std::strchr(*e, '=');
+      const key_view k{string_view(*e, eq != nullptr ? static_cast<std::size_t>(eq - *e) : std::strlen(*e))};
+      if (!overrides_(k))
+        envp_.push_back(*e);
+    }
+
+    for (auto & d : deltas_)
+      if (!d.removed)
+        envp_.push_back(d.pair.c_str());
+
+    envp_.push_back(nullptr);
+    launcher.env = envp_.data();
+    return error_code{};
+};
+
 #endif
 
 
@@ -0,0 +1,242 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/detail/throw_error.hpp>
+#include <boost/process/v2/ext/snapshot.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace ext
+{
+
+namespace
+{
+
+// writes "<pid>/<name>" into buf, which must be large enough.
+void make_proc_path(char * buf, pid_type pid, const char * name)
+{
+    char digits[24];
+    int n = 0;
+    auto value = static_cast<unsigned long>(pid);
+    do
+    {
+        digits[n++] = static_cast<char>('0' + value % 10u);
+        value /= 10u;
+    }
+    while (value != 0u);
+
+    while (n > 0)
+        *buf++ = digits[--n];
+    *buf++ = '/';
+    std::strcpy(buf, name);
+}
+
+}
+
+snapshot::snapshot()
+{
+    error_code ec;
+    proc_fd_ = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd_ == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        detail::throw_error(ec, "snapshot");
+    }
+}
+
+snapshot::snapshot(error_code & ec)
+{
+    proc_fd_ = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd_ == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+}
+
+snapshot::snapshot(snapshot && lhs) noexcept
+    : proc_fd_(lhs.proc_fd_), records_(std::move(lhs.records_)), buffer_(std::move(lhs.buffer_)),
+      size_(lhs.size_), capacity_(lhs.capacity_)
+{
+    lhs.proc_fd_ = -1;
+    lhs.size_ = lhs.capacity_ = 0u;
+}
+
+snapshot& snapshot::operator=(snapshot && lhs) noexcept
+{
+    if (this != &lhs)
+    {
+        if (proc_fd_ != -1)
+            ::close(proc_fd_);
+        proc_fd_  = lhs.proc_fd_;
+        records_  = std::move(lhs.records_);
+        buffer_   = std::move(lhs.buffer_);
+        size_     = lhs.size_;
+        capacity_ = lhs.capacity_;
+        lhs.proc_fd_ = -1;
+        lhs.size_ = lhs.capacity_ = 0u;
+    }
+    return *this;
+}
+
+snapshot::~snapshot()
+{
+    if (proc_fd_ != -1)
+        ::close(proc_fd_);
+}
+
+void snapshot::reserve_(std::size_t extra)
+{
+    if (capacity_ - size_ >= extra)
+        return;
+    auto cap = capacity_ == 0u ? std::size_t(65536u) : capacity_;
+    while (cap - size_ < extra)
+        cap *= 2u;
+    std::unique_ptr<char[]> buf{new char[cap]};
+    if (size_ > 0u)
+        std::memcpy(buf.get(), buffer_.get(), size_);
+    buffer_ = std::move(buf);
+    capacity_ = cap;
+}
+
+// reads the whole file into the end of the buffer and null-terminates it, if it isn't already.
+std::size_t snapshot::read_file_(const char * path, error_code & ec)
+{
+    const int fd = ::openat(proc_fd_, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return 0u;
+    }
+
+    const auto start = size_;
+    while (true)
+    {
+        reserve_(4096u);
+        const auto n = ::read(fd, buffer_.get() + size_, capacity_ - size_);
+        if (n > 0)
+            size_ += static_cast<std::size_t>(n);
+        else if (n == 0)
+            break;
+        else if (errno != EINTR)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            break;
+        }
+    }
+    ::close(fd);
+
+    if (ec)
+    {
+        size_ = start;
+        return 0u;
+    }
+    if (size_ != start && buffer_[size_ - 1u] != '\0')
+    {
+        reserve_(1u);
+        buffer_[size_++] = '\0';
+    }
+    return size_ - start;
+}
+
+// reads the link target into the end of the buffer, including a null terminator.
+std::size_t snapshot::read_link_(const char * path, error_code & ec)
+{
+    reserve_(256u);
+    while (true)
+    {
+        const auto space = capacity_ - size_;
+        const auto n = ::readlinkat(proc_fd_, path, buffer_.get() + size_, space);
+        if (n == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return 0u;
+        }
+        const auto len = static_cast<std::size_t>(n);
+        if (len < space)
+        {
+            buffer_[size_ + len] = '\0';
+            size_ += len + 1u;
+            return len + 1u;
+        }
+        // possibly truncated
+        reserve_(space * 2u);
+    }
+}
+
+void snapshot::update(const pid_type * pids, std::size_t count, unsigned fields, error_code & ec)
+{
+    records_.clear();
+    size_ = 0u;
+    if (proc_fd_ == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EBADF, system_category());
+        return;
+    }
+    records_.reserve(count);
+
+    static const char * const names[4] = {"cmdline", "cwd", "exe", "environ"};
+    char path[64];
+    for (std::size_t i = 0u; i < count; i++)
+    {
+        record rec{};
+        rec.pid = pids[i];
+        for (unsigned f = 0u; f < 4u; f++)
+        {
+            rec.offset[f] = size_;
+            if ((fields & (1u << f)) == 0u)
+                continue;
+
+            error_code fec;
+            make_proc_path(path, pids[i], names[f]);
+            const bool is_link = (1u << f) == cwd || (1u << f) == exe;
+            rec.length[f] = is_link ? read_link_(path, fec) : read_file_(path, fec);
+            if (fec && !rec.error)
+                rec.error = fec;
+        }
+        records_.push_back(rec);
+    }
+}
+
+void snapshot::update(const pid_type * pids, std::size_t count, unsigned fields)
+{
+    error_code ec;
+    update(pids, count, fields, ec);
+    if (ec)
+        detail::throw_error(ec, "snapshot::update");
+}
+
+auto snapshot::operator[](std::size_t idx) const -> entry
+{
+    const auto & rec = records_[idx];
+    const auto data = buffer_.get();
+    // a link that wasn't read has no null terminator in the buffer.
+    auto link = [&](unsigned f)
+    {
+        return rec.length[f] == 0u ? cstring_ref() : cstring_ref(data + rec.offset[f]);
+    };
+    entry e;
+    e.pid   = rec.pid;
+    e.error = rec.error;
+    e.cmd   = string_list(data + rec.offset[0], rec.length[0]);
+    e.cwd   = link(1u);
+    e.exe   = link(2u);
+    e.env   = string_list(data + rec.offset[3], rec.length[3]);
+    return e;
+}
+
+} // namespace ext
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
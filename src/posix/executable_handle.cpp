@@ -0,0 +1,127 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/posix/executable_handle.hpp>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#if defined(__FreeBSD__) || defined(__DragonFly__) || defined(__NetBSD__) || defined(__GLIBC__)
+#define BOOST_PROCESS_V2_HAS_FEXECVE 1
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+void exec_descriptor(int fd, const char * path, const char * const * argv, const char * const * env)
+{
+    if (fd != -1)
+    {
+#if defined(__linux__) && defined(SYS_execveat)
+        // execveat also works with O_PATH descriptors, which fexecve only emulates through /proc.
+        ::syscall(SYS_execveat, fd, "", argv, env, AT_EMPTY_PATH);
+        if (errno != ENOSYS)
+            return;
+#elif defined(BOOST_PROCESS_V2_HAS_FEXECVE)
+        ::fexecve(fd, const_cast<char * const *>(argv), const_cast<char * const *>(env));
+        if (errno != ENOSYS)
+            return;
+#endif
+    }
+    ::execve(path, const_cast<char * const *>(argv), const_cast<char * const *>(env));
+}
+
+}
+
+void executable_handle::open_(const filesystem::path & exe, error_code & ec)
+{
+    int fd = ::open(exe.c_str(), O_RDONLY | O_CLOEXEC);
+#if defined(O_PATH)
+    // an executable without read permission can still be executed through an O_PATH descriptor.
+    if (fd == -1 && errno == EACCES)
+        fd = ::open(exe.c_str(), O_PATH | O_CLOEXEC);
+#endif
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fd);
+        return;
+    }
+    // same as execve, so the error shows up here instead of at every launch.
+    if (!S_ISREG(st.st_mode))
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EACCES, system_category());
+        ::close(fd);
+        return;
+    }
+
+    close_();
+    path_ = exe;
+    fd_ = fd;
+}
+
+void executable_handle::close_()
+{
+    if (fd_ != -1)
+        ::close(fd_);
+    fd_ = -1;
+}
+
+void executable_handle::prefetch(error_code & ec)
+{
+    if (fd_ == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EBADF, system_category());
+        return;
+    }
+#if defined(POSIX_FADV_WILLNEED)
+    // initiates an asynchronous readahead of the whole file.
+    const int res = ::posix_fadvise(fd_, 0, 0, POSIX_FADV_WILLNEED);
+    if (res != 0)
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, res, system_category());
+#elif defined(F_RDADVISE)
+    struct stat st;
+    if (::fstat(fd_, &st) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+    struct radvisory ra;
+    ra.ra_offset = 0;
+    ra.ra_count = static_cast<int>(st.st_size);
+    if (::fcntl(fd_, F_RDADVISE, &ra) == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+#endif
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
@@ -0,0 +1,165 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/posix/fork_regions.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(MADV_WIPEONFORK)
+#define MADV_WIPEONFORK 18
+#endif
+#if !defined(MADV_KEEPONFORK)
+#define MADV_KEEPONFORK 19
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace
+{
+
+template<typename Region>
+int advise_(const Region & r, bool exclude)
+{
+    int advice;
+    if (r.mode == fork_region_mode::wipe_on_fork)
+        advice = exclude ? MADV_WIPEONFORK : MADV_KEEPONFORK;
+    else
+        advice = exclude ? MADV_DONTFORK : MADV_DOFORK;
+    return ::madvise(reinterpret_cast<void*>(r.begin), r.end - r.begin, advice);
+}
+
+}
+
+fork_region_registry::~fork_region_registry()
+{
+    if (excluded_ == 0u)
+        return;
+    // the memory might be gone already, so errors are ignored.
+    for (auto & r : regions_)
+        advise_(r, false);
+}
+
+void fork_region_registry::add(void * addr, std::size_t size, fork_region_mode mode, error_code & ec)
+{
+    static const auto page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const auto first = reinterpret_cast<std::uintptr_t>(addr);
+    region r{addr, (first + page_size - 1u) & ~(page_size - 1u), (first + size) & ~(page_size - 1u), mode};
+    if (size == 0u || first + size < first || r.begin >= r.end)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto itr = std::lower_bound(regions_.begin(), regions_.end(), r.begin,
+                                [](const region & lhs, std::uintptr_t rhs) {return lhs.begin < rhs;});
+    const bool overlapping = (itr != regions_.end() && itr->begin < r.end)
+                          || (itr != regions_.begin() && std::prev(itr)->end > r.begin)
+                          || std::any_of(regions_.begin(), regions_.end(),
+                                         [&](const region & other) {return other.addr == addr;});
+    if (overlapping)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+        return;
+    }
+
+    if (excluded_ > 0u && advise_(r, true) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+    regions_.insert(itr, r);
+}
+
+void fork_region_registry::remove(void * addr)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto itr = std::find_if(regions_.begin(), regions_.end(),
+                            [&](const region & r) {return r.addr == addr;});
+    if (itr == regions_.end())
+        return;
+    if (excluded_ > 0u)
+        advise_(*itr, false);
+    regions_.erase(itr);
+}
+
+bool fork_region_registry::overlaps(const void * addr, std::size_t size) const
+{
+    const auto first = reinterpret_cast<std::uintptr_t>(addr);
+    const auto last = first + size;
+    std::lock_guard<std::mutex> lock{mutex_};
+    // the first region ending after addr is the only candidate, since they don't overlap.
+    auto itr = std::upper_bound(regions_.begin(), regions_.end(), first,
+                                [](std::uintptr_t lhs, const region & rhs) {return lhs < rhs.end;});
+    return itr != regions_.end() && itr->begin < last;
+}
+
+std::size_t fork_region_registry::size() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    return regions_.size();
+}
+
+std::size_t fork_region_registry::bytes() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    std::size_t res = 0u;
+    for (auto & r : regions_)
+        res += r.end - r.begin;
+    return res;
+}
+
+void fork_region_registry::exclude(error_code & ec)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (excluded_++ > 0u)
+        return;
+
+    for (auto itr = regions_.begin(); itr != regions_.end(); itr++)
+    {
+        if (advise_(*itr, true) == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            for (auto jtr = regions_.begin(); jtr != itr; jtr++)
+                advise_(*jtr, false);
+            excluded_ = 0u;
+            return;
+        }
+    }
+}
+
+void fork_region_registry::restore()
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (excluded_ == 0u || --excluded_ > 0u)
+        return;
+    for (auto & r : regions_)
+        advise_(r, false);
+}
+
+bool fork_region_registry::excluded() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    return excluded_ > 0u;
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
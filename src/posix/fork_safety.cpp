@@ -0,0 +1,152 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX) && defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+
+#include <boost/process/v2/posix/fork_safety.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <new>
+#include <string>
+
+#if !defined(BOOST_PROCESS_V2_STANDALONE)
+#include <boost/core/demangle.hpp>
+#endif
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// the interface to the interposers in fork_safety_interpose.cpp, which can't include the usual headers.
+extern "C"
+{
+
+// the report of the current launch, only ever set in a forked child.
+void * volatile boost_process_v2_fork_safety_child_ = nullptr;
+
+// resolves the functions of libc the interposers forward to, so the child needn't call dlsym.
+void boost_process_v2_fork_safety_resolve_();
+
+void boost_process_v2_fork_safety_note_(int kind, const char * call);
+
+}
+
+namespace
+{
+
+// the initializer currently running in the child.
+const char * current_initializer_ = nullptr;
+
+void default_handler_(const BOOST_PROCESS_V2_NAMESPACE::posix::fork_safety_report & report)
+{
+    if (!report.violated())
+        return;
+#if !defined(BOOST_PROCESS_V2_STANDALONE)
+    const std::string name = boost::core::demangle(report.offender);
+#else
+    const std::string name = report.offender;
+#endif
+    std::fprintf(stderr, "boost.process: %s called %s in on_exec_setup, which can deadlock after fork; "
+                         "the child got terminated.\n", name.c_str(), report.call);
+}
+
+std::atomic<BOOST_PROCESS_V2_NAMESPACE::posix::fork_safety_handler> handler_{&default_handler_};
+
+}
+
+void boost_process_v2_fork_safety_note_(int kind, const char * call)
+{
+    auto report = static_cast<BOOST_PROCESS_V2_NAMESPACE::posix::fork_safety_report*>(boost_process_v2_fork_safety_child_);
+    if (report == nullptr)
+        return;
+
+    // 0: allocation, 1: lock, 2: system call
+    if (kind == 2)
+    {
+        report->syscalls++;
+        return;
+    }
+    else if (kind == 1)
+        report->locks++;
+    else
+        report->allocations++;
+
+    if (current_initializer_ != nullptr)
+    {
+        report->offender = current_initializer_;
+        report->call = call;
+        // continuing might deadlock, the parent reports the violation.
+        ::_exit(127);
+    }
+}
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+fork_safety_handler set_fork_safety_handler(fork_safety_handler handler) noexcept
+{
+    return handler_.exchange(handler);
+}
+
+namespace detail
+{
+
+fork_safety_guard::fork_safety_guard() noexcept
+{
+    static const bool resolved = (boost_process_v2_fork_safety_resolve_(), true);
+    (void)resolved;
+
+    // shared, so the parent sees what the child recorded.
+    void * p = ::mmap(nullptr, sizeof(fork_safety_report), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    report_ = p == MAP_FAILED ? nullptr : new (p) fork_safety_report();
+}
+
+fork_safety_guard::~fork_safety_guard()
+{
+    if (report_ != nullptr)
+        ::munmap(report_, sizeof(fork_safety_report));
+}
+
+void fork_safety_guard::enter_child() noexcept
+{
+    current_initializer_ = nullptr;
+    boost_process_v2_fork_safety_child_ = report_;
+}
+
+void fork_safety_guard::finish(error_code & ec) noexcept
+{
+    if (report_ == nullptr)
+        return;
+    if (auto handler = handler_.load())
+        handler(*report_);
+    if (report_->violated() && !ec)
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EDEADLK, system_category());
+}
+
+fork_safety_scope::fork_safety_scope(const char * initializer) noexcept : previous_(current_initializer_)
+{
+    // vforked children share the memory of the parent, so only a forked child gets marked.
+    if (boost_process_v2_fork_safety_child_ != nullptr)
+        current_initializer_ = initializer;
+}
+
+fork_safety_scope::~fork_safety_scope()
+{
+    if (boost_process_v2_fork_safety_child_ != nullptr)
+        current_initializer_ = previous_;
+}
+
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
@@ -0,0 +1,505 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// The interposers of BOOST_PROCESS_V2_CHECK_FORK_SAFETY, replacing the libc functions in the whole program.
+// They don't use the boost headers, so nothing else gets compiled with the interposers in scope.
+
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY) && !defined(_WIN32)
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstddef>
+#include <cstring>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+// the exception specification of the declarations in glibc, which the definitions must repeat.
+#define BOOST_PROCESS_V2_LIBC_NOEXCEPT noexcept
+#else
+#define BOOST_PROCESS_V2_LIBC_NOEXCEPT
+#endif
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define BOOST_PROCESS_V2_SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#define BOOST_PROCESS_V2_SANITIZED 1
+#endif
+#endif
+
+// a sanitizer allocates before it's initialized, when code instrumented by it can't run yet.
+#if defined(__GLIBC__) && !defined(BOOST_PROCESS_V2_SANITIZED)
+#define BOOST_PROCESS_V2_INTERPOSE_ALLOCATOR 1
+#endif
+
+extern "C"
+{
+
+extern void * volatile boost_process_v2_fork_safety_child_;
+void boost_process_v2_fork_safety_note_(int kind, const char * call);
+
+}
+
+namespace
+{
+
+enum kind_ {allocation = 0, lock = 1, system_call = 2};
+
+inline void note_(kind_ k, const char * call)
+{
+    // cheap check first, this runs on every allocation of the program.
+    if (boost_process_v2_fork_safety_child_ != nullptr)
+        boost_process_v2_fork_safety_note_(k, call);
+}
+
+// the next definition of a function, i.e. the one in libc.
+// constexpr, so it's initialized before any code runs that could call the interposers.
+template<typename Function>
+struct next_
+{
+    constexpr next_(const char * name) : name(name) {}
+
+    const char * name;
+    std::atomic<Function> function{nullptr};
+
+    Function get()
+    {
+        auto f = function.load(std::memory_order_acquire);
+        if (f == nullptr)
+        {
+            f = reinterpret_cast<Function>(::dlsym(RTLD_NEXT, name));
+            function.store(f, std::memory_order_release);
+        }
+        return f;
+    }
+};
+
+next_<int (*)(pthread_mutex_t *)> pthread_mutex_lock_{"pthread_mutex_lock"};
+next_<int (*)(pthread_rwlock_t *)> pthread_rwlock_rdlock_{"pthread_rwlock_rdlock"};
+next_<int (*)(pthread_rwlock_t *)> pthread_rwlock_wrlock_{"pthread_rwlock_wrlock"};
+
+next_<int (*)(int)> close_{"close"};
+next_<int (*)(int)> dup_{"dup"};
+next_<int (*)(int, int)> dup2_{"dup2"};
+next_<int (*)(int, int, int)> dup3_{"dup3"};
+next_<int (*)(int, int, ...)> fcntl_{"fcntl"};
+next_<int (*)(const char *)> chdir_{"chdir"};
+next_<int (*)(int)> fchdir_{"fchdir"};
+next_<pid_t (*)()> setsid_{"setsid"};
+next_<int (*)(pid_t, pid_t)> setpgid_{"setpgid"};
+next_<int (*)(uid_t)> setuid_{"setuid"};
+next_<int (*)(gid_t)> setgid_{"setgid"};
+next_<int (*)(int, const sigset_t *, sigset_t *)> sigprocmask_{"sigprocmask"};
+next_<int (*)(int, const sigset_t *, sigset_t *)> pthread_sigmask_{"pthread_sigmask"};
+next_<int (*)(int, const struct sigaction *, struct sigaction *)> sigaction_{"sigaction"};
+next_<int (*)(const char *, char * const *, char * const *)> execve_{"execve"};
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define BOOST_PROCESS_V2_INTERPOSE_SYSCALL 1
+next_<long (*)(long, ...)> syscall_{"syscall"};
+#endif
+
+#if defined(BOOST_PROCESS_V2_INTERPOSE_ALLOCATOR)
+
+// The allocation functions resolve the next definition as well, so a replacement like jemalloc,
+// tcmalloc or the one of a sanitizer keeps working. dlsym can allocate itself, so until all of them
+// are resolved, allocations get served from a bump allocator that never reuses its memory.
+next_<void * (*)(std::size_t)> malloc_{"malloc"};
+next_<void (*)(void *)> free_{"free"};
+next_<void * (*)(std::size_t, std::size_t)> calloc_{"calloc"};
+next_<void * (*)(void *, std::size_t)> realloc_{"realloc"};
+next_<void * (*)(std::size_t, std::size_t)> memalign_{"memalign"};
+next_<void * (*)(std::size_t, std::size_t)> aligned_alloc_{"aligned_alloc"};
+next_<int (*)(void **, std::size_t, std::size_t)> posix_memalign_{"posix_memalign"};
+
+enum allocator_state_t_ {unresolved, resolving, resolved};
+std::atomic<int> allocator_state_{unresolved};
+
+// true once the allocator can be used, false while it's getting resolved, by this or another thread.
+bool allocator_ready_()
+{
+    if (allocator_state_.load(std::memory_order_acquire) == resolved)
+        return true;
+    int expected = unresolved;
+    if (!allocator_state_.compare_exchange_strong(expected, resolving, std::memory_order_acq_rel))
+        return false;
+    malloc_.get();
+    free_.get();
+    calloc_.get();
+    realloc_.get();
+    memalign_.get();
+    aligned_alloc_.get();
+    posix_memalign_.get();
+    allocator_state_.store(resolved, std::memory_order_release);
+    return true;
+}
+
+// every block is prefixed with its size, for realloc. The buffer is zero-initialized, so it serves calloc too.
+constexpr std::size_t bootstrap_alignment_ = alignof(std::max_align_t);
+alignas(std::max_align_t) char bootstrap_buffer_[16384];
+std::atomic<std::size_t> bootstrap_used_{0u};
+
+void * bootstrap_allocate_(std::size_t size)
+{
+    if (size > sizeof(bootstrap_buffer_))
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    const auto total = bootstrap_alignment_ + (size + bootstrap_alignment_ - 1u) / bootstrap_alignment_ * bootstrap_alignment_;
+    const auto offset = bootstrap_used_.fetch_add(total, std::memory_order_relaxed);
+    if (offset + total > sizeof(bootstrap_buffer_))
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    std::memcpy(bootstrap_buffer_ + offset, &size, sizeof(size));
+    return bootstrap_buffer_ + offset + bootstrap_alignment_;
+}
+
+bool from_bootstrap_(const void * ptr)
+{
+    const auto p = static_cast<const char *>(ptr);
+    return p >= bootstrap_buffer_ && p < bootstrap_buffer_ + sizeof(bootstrap_buffer_);
+}
+
+std::size_t bootstrap_size_(const void * ptr)
+{
+    std::size_t size;
+    std::memcpy(&size, static_cast<const char *>(ptr) - bootstrap_alignment_, sizeof(size));
+    return size;
+}
+
+// the alignment functions aren't used by dlsym, so the bootstrap buffer only serves the fundamental alignment.
+void * bootstrap_allocate_aligned_(std::size_t alignment, std::size_t size)
+{
+    if (alignment > bootstrap_alignment_)
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    return bootstrap_allocate_(size);
+}
+
+#endif
+
+}
+
+extern "C"
+{
+
+#if defined(BOOST_PROCESS_V2_INTERPOSE_ALLOCATOR)
+
+void * malloc(std::size_t size) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(allocation, "malloc");
+    if (!allocator_ready_())
+        return bootstrap_allocate_(size);
+    return malloc_.get()(size);
+}
+
+void free(void * ptr) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    if (ptr == nullptr)
+        return;
+    note_(allocation, "free");
+    // anything else was allocated after the allocator got resolved.
+    if (!from_bootstrap_(ptr) && allocator_ready_())
+        free_.get()(ptr);
+}
+
+void * calloc(std::size_t n, std::size_t size) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(allocation, "calloc");
+    if (!allocator_ready_())
+    {
+        if (size != 0u && n > static_cast<std::size_t>(-1) / size)
+        {
+            errno = ENOMEM;
+            return nullptr;
+        }
+        return bootstrap_allocate_(n * size);
+    }
+    return calloc_.get()(n, size);
+}
+
+void * realloc(void * ptr, std::size_t size) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(allocation, "realloc");
+    if (!allocator_ready_())
+    {
+        // only the bootstrap buffer was allocated from until now.
+        void * res = bootstrap_allocate_(size);
+        if (res != nullptr && ptr != nullptr)
+        {
+            const auto old = bootstrap_size_(ptr);
+            std::memcpy(res, ptr, old < size ? old : size);
+        }
+        return res;
+    }
+    if (ptr != nullptr && from_bootstrap_(ptr))
+    {
+        void * res = malloc_.get()(size);
+        if (res != nullptr)
+        {
+            const auto old = bootstrap_size_(ptr);
+            std::memcpy(res, ptr, old < size ? old : size);
+        }
+        return res;
+    }
+    return realloc_.get()(ptr, size);
+}
+
+void * memalign(std::size_t alignment, std::size_t size) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(allocation, "memalign");
+    if (!allocator_ready_())
+        return bootstrap_allocate_aligned_(alignment, size);
+    return memalign_.get()(alignment, size);
+}
+
+void * aligned_alloc(std::size_t alignment, std::size_t size) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(allocation, "aligned_alloc");
+    if (!allocator_ready_())
+        return bootstrap_allocate_aligned_(alignment, size);
+    return aligned_alloc_.get()(alignment, size);
+}
+
+int posix_memalign(void ** ptr, std::size_t alignment, std::size_t size) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(allocation, "posix_memalign");
+    if (allocator_ready_())
+        return posix_memalign_.get()(ptr, alignment, size);
+    if (alignment % sizeof(void*) != 0u || (alignment & (alignment - 1u)) != 0u)
+        return EINVAL;
+    void * p = bootstrap_allocate_aligned_(alignment, size);
+    if (p == nullptr)
+        return ENOMEM;
+    *ptr = p;
+    return 0;
+}
+
+#endif
+
+int pthread_mutex_lock(pthread_mutex_t * mutex) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(lock, "pthread_mutex_lock");
+    return pthread_mutex_lock_.get()(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t * rwlock) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(lock, "pthread_rwlock_rdlock");
+    return pthread_rwlock_rdlock_.get()(rwlock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t * rwlock) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(lock, "pthread_rwlock_wrlock");
+    return pthread_rwlock_wrlock_.get()(rwlock);
+}
+
+int close(int fd)
+{
+    note_(system_call, "close");
+    return close_.get()(fd);
+}
+
+int dup(int fd) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "dup");
+    return dup_.get()(fd);
+}
+
+int dup2(int fd, int fd2) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "dup2");
+    return dup2_.get()(fd, fd2);
+}
+
+int dup3(int fd, int fd2, int flags) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "dup3");
+    return dup3_.get()(fd, fd2, flags);
+}
+
+int fcntl(int fd, int cmd, ...)
+{
+    note_(system_call, "fcntl");
+    // the argument must be read with its type, a pointer for the locks & owners, none for the getters, else an int.
+    va_list args;
+    va_start(args, cmd);
+    int res;
+    switch (cmd)
+    {
+    case F_GETLK:
+    case F_SETLK:
+    case F_SETLKW:
+#if defined(F_OFD_GETLK)
+    case F_OFD_GETLK:
+    case F_OFD_SETLK:
+    case F_OFD_SETLKW:
+#endif
+#if defined(F_GETOWN_EX)
+    case F_GETOWN_EX:
+    case F_SETOWN_EX:
+#endif
+#if defined(F_GET_RW_HINT)
+    case F_GET_RW_HINT:
+    case F_SET_RW_HINT:
+    case F_GET_FILE_RW_HINT:
+    case F_SET_FILE_RW_HINT:
+#endif
+#if defined(F_GETPATH)
+    case F_GETPATH:
+#endif
+        res = fcntl_.get()(fd, cmd, va_arg(args, void *));
+        break;
+    case F_GETFD:
+    case F_GETFL:
+    case F_GETOWN:
+#if defined(F_GETSIG)
+    case F_GETSIG:
+#endif
+#if defined(F_GETLEASE)
+    case F_GETLEASE:
+#endif
+#if defined(F_GETPIPE_SZ)
+    case F_GETPIPE_SZ:
+#endif
+#if defined(F_GET_SEALS)
+    case F_GET_SEALS:
+#endif
+        res = fcntl_.get()(fd, cmd);
+        break;
+    default:
+        res = fcntl_.get()(fd, cmd, va_arg(args, int));
+        break;
+    }
+    va_end(args);
+    return res;
+}
+
+int chdir(const char * path) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "chdir");
+    return chdir_.get()(path);
+}
+
+int fchdir(int fd) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "fchdir");
+    return fchdir_.get()(fd);
+}
+
+pid_t setsid() BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "setsid");
+    return setsid_.get()();
+}
+
+int setpgid(pid_t pid, pid_t pgid) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "setpgid");
+    return setpgid_.get()(pid, pgid);
+}
+
+int setuid(uid_t uid) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "setuid");
+    return setuid_.get()(uid);
+}
+
+int setgid(gid_t gid) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "setgid");
+    return setgid_.get()(gid);
+}
+
+int sigprocmask(int how, const sigset_t * set, sigset_t * old) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "sigprocmask");
+    return sigprocmask_.get()(how, set, old);
+}
+
+int pthread_sigmask(int how, const sigset_t * set, sigset_t * old) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "pthread_sigmask");
+    return pthread_sigmask_.get()(how, set, old);
+}
+
+int sigaction(int sig, const struct sigaction * act, struct sigaction * old) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "sigaction");
+    return sigaction_.get()(sig, act, old);
+}
+
+int execve(const char * path, char * const * argv, char * const * envp) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "execve");
+    return execve_.get()(path, argv, envp);
+}
+
+#if defined(BOOST_PROCESS_V2_INTERPOSE_SYSCALL)
+
+long syscall(long number, ...) BOOST_PROCESS_V2_LIBC_NOEXCEPT
+{
+    note_(system_call, "syscall");
+    // The number of arguments depends on the system call, so like glibc's syscall this reads the maximum of six longs.
+    // Reading more variadic arguments than were passed is undefined in C++, so this relies on the ABIs it's enabled for:
+    // on aarch64 linux all seven are passed in registers, on x86-64 the sixth argument is read from the caller's frame,
+    // which is mapped. Either way the excess values are garbage the kernel ignores.
+    va_list args;
+    va_start(args, number);
+    long a[6];
+    for (auto & arg : a)
+        arg = va_arg(args, long);
+    va_end(args);
+    return syscall_.get()(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+#endif
+
+// called before forking, so the child never needs dlsym, which can allocate & lock.
+void boost_process_v2_fork_safety_resolve_()
+{
+    pthread_mutex_lock_.get();
+    pthread_rwlock_rdlock_.get();
+    pthread_rwlock_wrlock_.get();
+    close_.get();
+    dup_.get();
+    dup2_.get();
+    dup3_.get();
+    fcntl_.get();
+    chdir_.get();
+    fchdir_.get();
+    setsid_.get();
+    setpgid_.get();
+    setuid_.get();
+    setgid_.get();
+    sigprocmask_.get();
+    pthread_sigmask_.get();
+    sigaction_.get();
+    execve_.get();
+#if defined(BOOST_PROCESS_V2_INTERPOSE_SYSCALL)
+    syscall_.get();
+#endif
+#if defined(BOOST_PROCESS_V2_INTERPOSE_ALLOCATOR)
+    allocator_ready_();
+#endif
+}
+
+}
+
+#endif
@@ -0,0 +1,314 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/posix/jobserver.hpp>
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+namespace
+{
+
+bool parse_fd_(string_view & sv, int & fd)
+{
+    std::size_t n = 0u;
+    bool negative = false;
+    if (!sv.empty() && sv.front() == '-')
+    {
+        negative = true;
+        sv.remove_prefix(1u);
+    }
+    int value = 0;
+    while (n < sv.size() && sv[n] >= '0' && sv[n] <= '9' && value < 65536)
+        value = value * 10 + (sv[n++] - '0');
+    if (n == 0u)
+        return false;
+    sv.remove_prefix(n);
+    fd = negative ? -value : value;
+    return true;
+}
+
+bool parse_fds_(string_view sv, jobserver_auth & auth)
+{
+    int rfd, wfd;
+    if (!parse_fd_(sv, rfd) || sv.empty() || sv.front() != ',')
+        return false;
+    sv.remove_prefix(1u);
+    if (!parse_fd_(sv, wfd) || !sv.empty())
+        return false;
+    auth.read_fd  = rfd;
+    auth.write_fd = wfd;
+    auth.fifo.clear();
+    return true;
+}
+
+template<typename Function>
+void for_each_word_(string_view makeflags, Function func)
+{
+    while (!makeflags.empty())
+    {
+        const auto start = makeflags.find_first_not_of(" \t");
+        if (start == string_view::npos)
+            break;
+        makeflags.remove_prefix(start);
+        auto end = makeflags.find_first_of(" \t");
+        if (end == string_view::npos)
+            end = makeflags.size();
+        const auto word = makeflags.substr(0u, end);
+        // the variable overrides come after `--`.
+        if (word == "--")
+            break;
+        func(word);
+        makeflags.remove_prefix(end);
+    }
+}
+
+bool starts_with_(string_view sv, string_view prefix)
+{
+    return sv.size() >= prefix.size() && sv.substr(0u, prefix.size()) == prefix;
+}
+
+// gets a descriptor of the pipe with its own file description, so the flags aren't shared.
+int reopen_(int fd, int flags, error_code & ec)
+{
+    int res = -1;
+#if defined(__linux__)
+    const auto pth = "/proc/self/fd/" + std::to_string(fd);
+    res = ::open(pth.c_str(), flags | O_CLOEXEC);
+    if (res != -1)
+        return res;
+#endif
+    res = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (res == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return -1;
+    }
+    if ((flags & O_NONBLOCK) != 0)
+    {
+        const int fl = ::fcntl(res, F_GETFL);
+        if (fl == -1 || ::fcntl(res, F_SETFL, fl | O_NONBLOCK) == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            ::close(res);
+            return -1;
+        }
+    }
+    return res;
+}
+
+}
+
+bool parse_jobserver_auth(string_view makeflags, jobserver_auth & auth)
+{
+    bool found = false;
+    for_each_word_(makeflags,
+        [&](string_view word)
+        {
+            if (starts_with_(word, "--jobserver-auth=fifo:"))
+            {
+                word.remove_prefix(22u);
+                auth.read_fd = auth.write_fd = -1;
+                auth.fifo.assign(word.data(), word.size());
+                found = !auth.fifo.empty();
+            }
+            else if (starts_with_(word, "--jobserver-auth="))
+                found = parse_fds_(word.substr(17u), auth);
+            else if (starts_with_(word, "--jobserver-fds="))
+                found = parse_fds_(word.substr(16u), auth);
+        });
+    // make passes negative descriptors to sub-makes that aren't allowed to use the jobserver.
+    return found && (!auth.fifo.empty() || (auth.read_fd >= 0 && auth.write_fd >= 0));
+}
+
+void open_jobserver(const jobserver_auth & auth, int & read_fd, int & write_fd, error_code & ec)
+{
+    if (!auth.fifo.empty())
+    {
+        read_fd = ::open(auth.fifo.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (read_fd == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return;
+        }
+        write_fd = ::open(auth.fifo.c_str(), O_WRONLY | O_CLOEXEC);
+        if (write_fd == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            ::close(read_fd);
+            read_fd = -1;
+        }
+        return;
+    }
+
+    // make closes the pipe for recipes that aren't recursive, the numbers might be reused though.
+    if (::fcntl(auth.read_fd, F_GETFD) == -1 || ::fcntl(auth.write_fd, F_GETFD) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EBADF, system_category());
+        return;
+    }
+
+    read_fd = reopen_(auth.read_fd, O_RDONLY | O_NONBLOCK, ec);
+    if (ec)
+        return;
+    write_fd = ::fcntl(auth.write_fd, F_DUPFD_CLOEXEC, 0);
+    if (write_fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(read_fd);
+        read_fd = -1;
+    }
+}
+
+void create_jobserver(std::size_t tokens, int & read_fd, int & write_fd, error_code & ec)
+{
+    int fds[2];
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+    if (::pipe2(fds, O_CLOEXEC) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+#else
+    if (::pipe(fds) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+#if defined(F_SETPIPE_SZ)
+    // the default capacity is 64KiB, best effort since it's capped by /proc/sys/fs/pipe-max-size.
+    if (tokens > 65536u && tokens <= static_cast<std::size_t>(INT_MAX))
+        ::fcntl(fds[1], F_SETPIPE_SZ, static_cast<int>(tokens));
+#endif
+
+    // nobody reads the pipe yet, so the tokens are written non-blocking & must fit into it.
+    const int flags = ::fcntl(fds[1], F_GETFL);
+    if (flags == -1 || ::fcntl(fds[1], F_SETFL, flags | O_NONBLOCK) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return;
+    }
+
+    const std::string buf(tokens, '+');
+    std::size_t written = 0u;
+    while (written < buf.size())
+    {
+        const auto res = ::write(fds[1], buf.data() + written, buf.size() - written);
+        if (res == -1 && errno == EINTR)
+            continue;
+        if (res == -1)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+            else
+                BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            ::close(fds[0]);
+            ::close(fds[1]);
+            return;
+        }
+        written += static_cast<std::size_t>(res);
+    }
+
+    // make & other clients expect a blocking write end.
+    if (::fcntl(fds[1], F_SETFL, flags) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return;
+    }
+    read_fd  = fds[0];
+    write_fd = fds[1];
+}
+
+std::string jobserver_makeflags(string_view makeflags, std::size_t jobs, int read_fd, int write_fd)
+{
+    std::string res;
+    bool first = true;
+    for_each_word_(makeflags,
+        [&](string_view word)
+        {
+            const bool first_word = first;
+            first = false;
+            if (starts_with_(word, "--jobserver-auth=") || starts_with_(word, "--jobserver-fds=")
+                || (starts_with_(word, "-j") && word.find_first_not_of("0123456789", 2u) == string_view::npos))
+                return;
+            if (!res.empty())
+                res += ' ';
+            // the first word holds the single letter options, without the dash.
+            if (first_word && word.front() != '-')
+                res += '-';
+            res.append(word.data(), word.size());
+        });
+
+    const auto pos = makeflags.find(" -- ");
+    if (!res.empty())
+        res += ' ';
+    res += "-j" + std::to_string(jobs)
+         + " --jobserver-auth=" + std::to_string(read_fd) + ',' + std::to_string(write_fd);
+    if (pos != string_view::npos)
+    {
+        const auto overrides = makeflags.substr(pos);
+        res.append(overrides.data(), overrides.size());
+    }
+    return res;
+}
+
+bool take_jobserver_token(int fd, char & token, error_code & ec)
+{
+    while (true)
+    {
+        const auto res = ::read(fd, &token, 1u);
+        if (res == 1)
+            return true;
+        if (res == -1 && errno == EINTR)
+            continue;
+        if (res == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return false;
+        if (res == -1)
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        else // all writers are gone
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, EPIPE, system_category());
+        return false;
+    }
+}
+
+void put_jobserver_token(int fd, char token)
+{
+    while (::write(fd, &token, 1u) == -1 && errno == EINTR)
+        ;
+}
+
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
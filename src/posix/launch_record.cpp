@@ -0,0 +1,324 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/posix/launch_record.hpp>
+
+#include <cerrno>
+
+#if !defined(BOOST_PROCESS_V2_STANDALONE)
+#include <boost/core/demangle.hpp>
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace
+{
+
+// The file starts with the magic, followed by records, each starting with its kind.
+constexpr char record_magic[8] = {'b', 'p', 'v', '2', 'l', 'r', 'c', '1'};
+
+enum record_kind : char
+{
+    // u32 id, u32 size & the characters
+    string_entry = 's',
+    // u64 start, u64 duration, i64 pid, i32 error, u32 executable id, u32 argc, u32 argv bytes,
+    // u32 envc, u32 env bytes, u32 initializer count & their ids
+    launch_entry = 'l',
+    // u64 time, i64 pid, i32 exit code
+    exit_entry = 'x'
+};
+
+// flush once this much got buffered.
+constexpr std::size_t flush_threshold = 64u * 1024u;
+
+template<typename T>
+void append(std::string & buffer, T value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool write_all(int fd, const char * data, std::size_t size, error_code & ec)
+{
+    while (size > 0u)
+    {
+        const auto n = ::write(fd, data, size);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// reads the fields of a record, failing on the end of the data.
+struct record_reader
+{
+    const char * pos;
+    const char * end;
+
+    template<typename T>
+    bool read(T & value)
+    {
+        if (static_cast<std::size_t>(end - pos) < sizeof(T))
+            return false;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string & value, std::uint32_t size)
+    {
+        if (static_cast<std::size_t>(end - pos) < size)
+            return false;
+        value.assign(pos, size);
+        pos += size;
+        return true;
+    }
+};
+
+}
+
+launch_recorder::launch_recorder(const filesystem::path & file, error_code & ec)
+{
+    open_(file, ec);
+}
+
+launch_recorder::~launch_recorder()
+{
+    if (fd_ == -1)
+        return;
+    flush_();
+    ::close(fd_);
+}
+
+void launch_recorder::open_(const filesystem::path & file, error_code & ec)
+{
+    fd_ = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+    buffer_.append(record_magic, sizeof(record_magic));
+    flush_();
+    ec = error_;
+}
+
+std::uint32_t launch_recorder::intern_(const std::string & str)
+{
+    auto itr = strings_.find(str);
+    if (itr != strings_.end())
+        return itr->second;
+
+    const auto id = static_cast<std::uint32_t>(strings_.size());
+    strings_.emplace(str, id);
+    buffer_.push_back(string_entry);
+    append(buffer_, id);
+    append(buffer_, static_cast<std::uint32_t>(str.size()));
+    buffer_.append(str);
+    return id;
+}
+
+void launch_recorder::flush_()
+{
+    if (fd_ != -1 && !error_)
+        write_all(fd_, buffer_.data(), buffer_.size(), error_);
+    buffer_.clear();
+}
+
+void launch_recorder::record_launch(const detail::launch_sample & sample)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto exe = intern_(sample.executable);
+
+    std::vector<std::uint32_t> inits;
+    for (auto name = sample.initializers; *name != nullptr; name++)
+    {
+        auto itr = type_names_.find(*name);
+        if (itr == type_names_.end())
+        {
+#if !defined(BOOST_PROCESS_V2_STANDALONE)
+            const auto id = intern_(boost::core::demangle(*name));
+#else
+            const auto id = intern_(*name);
+#endif
+            itr = type_names_.emplace(*name, id).first;
+        }
+        inits.push_back(itr->second);
+    }
+
+    buffer_.push_back(launch_entry);
+    append(buffer_, sample.start);
+    append(buffer_, sample.duration);
+    append(buffer_, static_cast<std::int64_t>(sample.pid));
+    append(buffer_, static_cast<std::int32_t>(sample.error));
+    append(buffer_, exe);
+    append(buffer_, sample.argc);
+    append(buffer_, sample.argv_bytes);
+    append(buffer_, sample.envc);
+    append(buffer_, sample.env_bytes);
+    append(buffer_, static_cast<std::uint32_t>(inits.size()));
+    for (auto id : inits)
+        append(buffer_, id);
+
+    launches_++;
+    if (buffer_.size() >= flush_threshold)
+        flush_();
+}
+
+void launch_recorder::record_exit(pid_type pid, int exit_code)
+{
+    const auto time = now();
+    std::lock_guard<std::mutex> lock{mutex_};
+    buffer_.push_back(exit_entry);
+    append(buffer_, time);
+    append(buffer_, static_cast<std::int64_t>(pid));
+    append(buffer_, static_cast<std::int32_t>(exit_code));
+    if (buffer_.size() >= flush_threshold)
+        flush_();
+}
+
+void launch_recorder::flush(error_code & ec)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    flush_();
+    ec = error_;
+}
+
+std::uint64_t launch_recorder::launches() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    return launches_;
+}
+
+std::vector<launch_record> read_launch_records(const filesystem::path & file, error_code & ec)
+{
+    std::vector<launch_record> res;
+    const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return res;
+    }
+
+    std::string data;
+    char buf[65536];
+    for (;;)
+    {
+        const auto n = ::read(fd, buf, sizeof(buf));
+        if (n == 0)
+            break;
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            ::close(fd);
+            return res;
+        }
+        data.append(buf, static_cast<std::size_t>(n));
+    }
+    ::close(fd);
+
+    if (data.size() < sizeof(record_magic) || std::memcmp(data.data(), record_magic, sizeof(record_magic)) != 0)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+        return res;
+    }
+
+    std::vector<std::string> strings;
+    // the latest launch of a pid, that has no exit yet.
+    std::unordered_map<std::int64_t, std::size_t> alive;
+    const auto string_at = [&](std::uint32_t id) {return id < strings.size() ? strings[id] : std::string{};};
+
+    record_reader rd{data.data() + sizeof(record_magic), data.data() + data.size()};
+    char kind;
+    while (rd.read(kind))
+    {
+        if (kind == string_entry)
+        {
+            std::uint32_t id, size;
+            std::string str;
+            if (!rd.read(id) || !rd.read(size) || !rd.read(str, size))
+                break;
+            if (id >= strings.size())
+                strings.resize(id + 1u);
+            strings[id] = std::move(str);
+        }
+        else if (kind == launch_entry)
+        {
+            launch_record rec;
+            std::int64_t pid;
+            std::int32_t error;
+            std::uint32_t exe, count;
+            if (!rd.read(rec.start) || !rd.read(rec.duration) || !rd.read(pid) || !rd.read(error) || !rd.read(exe)
+                || !rd.read(rec.argc) || !rd.read(rec.argv_bytes) || !rd.read(rec.envc) || !rd.read(rec.env_bytes)
+                || !rd.read(count))
+                break;
+
+            bool complete = true;
+            for (std::uint32_t i = 0u; i < count && complete; i++)
+            {
+                std::uint32_t id;
+                complete = rd.read(id);
+                if (complete)
+                    rec.initializers.push_back(string_at(id));
+            }
+            if (!complete)
+                break;
+
+            rec.pid = static_cast<pid_type>(pid);
+            rec.error = error;
+            rec.executable = string_at(exe);
+            if (error == 0)
+                alive[pid] = res.size();
+            res.push_back(std::move(rec));
+        }
+        else if (kind == exit_entry)
+        {
+            std::uint64_t time;
+            std::int64_t pid;
+            std::int32_t exit_code;
+            if (!rd.read(time) || !rd.read(pid) || !rd.read(exit_code))
+                break;
+
+            auto itr = alive.find(pid);
+            if (itr != alive.end())
+            {
+                res[itr->second].exit_time = time;
+                res[itr->second].exit_code = exit_code;
+                alive.erase(itr);
+            }
+        }
+        else
+        {
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, EINVAL, system_category());
+            break;
+        }
+    }
+    return res;
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
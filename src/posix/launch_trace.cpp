@@ -0,0 +1,115 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/posix/launch_trace.hpp>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+std::uint64_t histogram_snapshot::percentile(double p) const
+{
+    if (count == 0u)
+        return 0u;
+    if (p <= 0.)
+        return min;
+    if (p >= 100.)
+        return max;
+
+    auto rank = static_cast<std::uint64_t>(p / 100. * static_cast<double>(count));
+    if (rank == 0u)
+        rank = 1u;
+    std::uint64_t seen = 0u;
+    for (auto & b : buckets)
+    {
+        seen += b.count;
+        if (seen >= rank)
+            return b.upper < max ? b.upper : max;
+    }
+    return max;
+}
+
+histogram_snapshot latency_histogram::snapshot() const
+{
+    histogram_snapshot res;
+    res.count = count_.load(std::memory_order_relaxed);
+    res.sum   = sum_.load(std::memory_order_relaxed);
+    res.max   = max_.load(std::memory_order_relaxed);
+    res.min   = res.count == 0u ? 0u : min_.load(std::memory_order_relaxed);
+
+    constexpr std::uint64_t sub_buckets = std::uint64_t(1u) << sub_bucket_bits;
+    for (std::size_t i = 0u; i < bucket_count; i++)
+    {
+        const auto n = buckets_[i].load(std::memory_order_relaxed);
+        if (n == 0u)
+            continue;
+
+        histogram_snapshot::bucket b;
+        b.count = n;
+        if (i < sub_buckets)
+            b.lower = b.upper = i;
+        else
+        {
+            const auto exp = static_cast<unsigned>(i >> sub_bucket_bits) + sub_bucket_bits - 1u;
+            const auto width = std::uint64_t(1u) << (exp - sub_bucket_bits);
+            b.lower = (sub_buckets + (i & (sub_buckets - 1u))) * width;
+            b.upper = i == bucket_count - 1u ? UINT64_MAX : b.lower + width - 1u;
+        }
+        res.buckets.push_back(b);
+    }
+    return res;
+}
+
+void latency_histogram::reset() noexcept
+{
+    for (auto & b : buckets_)
+        b.store(0u, std::memory_order_relaxed);
+    count_.store(0u, std::memory_order_relaxed);
+    sum_.store(0u, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0u, std::memory_order_relaxed);
+}
+
+void launch_histograms::on_launch(const launch_timestamps & timestamps, const error_code & ec) noexcept
+{
+    if (ec)
+        failures_.fetch_add(1u, std::memory_order_relaxed);
+
+    for (std::size_t i = 0u; i < launch_phase_count; i++)
+    {
+        const auto phase = static_cast<launch_phase>(i);
+        // unrecorded phases are zero, while a recorded one takes at least a nanosecond.
+        const auto d = timestamps.duration(phase);
+        if (d != 0u)
+            histograms_[i].record(d);
+    }
+}
+
+launch_statistics launch_histograms::snapshot() const
+{
+    launch_statistics res;
+    res.failures = failures_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0u; i < launch_phase_count; i++)
+        res.phases[i] = histograms_[i].snapshot();
+    return res;
+}
+
+void launch_histograms::reset() noexcept
+{
+    for (auto & h : histograms_)
+        h.reset();
+    failures_.store(0u, std::memory_order_relaxed);
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
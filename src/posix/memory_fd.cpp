@@ -0,0 +1,252 @@
+// Copyright (c) 2022 Klemens D. Morgenstern (klemens dot morgenstern at gmx dot net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/posix/detail/memory_fd.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// memfd_create & copy_file_range come with glibc 2.27
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING) && defined(F_ADD_SEALS)
+#define BOOST_PROCESS_V2_HAS_MEMFD 1
+#endif
+
+#if defined(__linux__) && defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define BOOST_PROCESS_V2_HAS_COPY_FILE_RANGE 1
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+namespace
+{
+
+int create_anonymous_file(bool & sealable, error_code & ec)
+{
+#if defined(BOOST_PROCESS_V2_HAS_MEMFD)
+    const int mfd = ::memfd_create("boost.process", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (mfd != -1)
+    {
+        sealable = true;
+        return mfd;
+    }
+    else if (errno != ENOSYS) // kernels before 3.17 use the fallback
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return -1;
+    }
+#endif
+    sealable = false;
+    const char * tmp = ::getenv("TMPDIR");
+    std::string pattern = (tmp != nullptr && *tmp != '\0') ? tmp : "/tmp";
+    pattern += "/boost-process-XXXXXX";
+
+    int fd = ::mkstemp(&pattern.front());
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return -1;
+    }
+    ::unlink(pattern.c_str());
+    if (::fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool write_all(int fd, const char * data, std::size_t size, error_code & ec)
+{
+    while (size > 0u)
+    {
+        const auto n = ::write(fd, data, size);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool copy_region(int in, std::uint64_t offset, std::uint64_t length, int out, error_code & ec)
+{
+#if defined(BOOST_PROCESS_V2_HAS_COPY_FILE_RANGE)
+    // let the kernel copy the data, falling back to read & write if the filesystem doesn't support it.
+    loff_t in_off = static_cast<loff_t>(offset);
+    while (length > 0u)
+    {
+        const auto n = ::copy_file_range(in, &in_off, out, nullptr, static_cast<std::size_t>(length), 0u);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            else if (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)
+                break;
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return false;
+        }
+        if (n == 0)
+            return true;
+        length -= static_cast<std::uint64_t>(n);
+    }
+    offset = static_cast<std::uint64_t>(in_off);
+#endif
+    char buffer[65536];
+    while (length > 0u)
+    {
+        const auto chunk = length < sizeof(buffer) ? static_cast<std::size_t>(length) : sizeof(buffer);
+        const auto n = ::pread(in, buffer, chunk, static_cast<off_t>(offset));
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return false;
+        }
+        if (n == 0)
+            break;
+        if (!write_all(out, buffer, static_cast<std::size_t>(n), ec))
+            return false;
+        offset += static_cast<std::uint64_t>(n);
+        length -= static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+int finish_memory_fd(int fd, bool sealable, error_code & ec)
+{
+#if defined(BOOST_PROCESS_V2_HAS_MEMFD)
+    if (sealable && ::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fd);
+        return -1;
+    }
+#else
+    (void)sealable;
+#endif
+    if (::lseek(fd, 0, SEEK_SET) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+}
+
+int open_memory_fd(const void * data, std::size_t size, error_code & ec)
+{
+    bool sealable = false;
+    const int fd = create_anonymous_file(sealable, ec);
+    if (fd == -1)
+        return -1;
+
+    if (!write_all(fd, static_cast<const char*>(data), size, ec))
+    {
+        ::close(fd);
+        return -1;
+    }
+    return finish_memory_fd(fd, sealable, ec);
+}
+
+int create_shared_memory_fd(std::size_t size, error_code & ec)
+{
+    bool sealable = false;
+    const int fd = create_anonymous_file(sealable, ec);
+    if (fd == -1)
+        return -1;
+
+    if (::ftruncate(fd, static_cast<off_t>(size)) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int open_file_region(const filesystem::path & pth,
+                     std::uint64_t offset, std::uint64_t length,
+                     error_code & ec)
+{
+    const int fd = ::open(pth.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return -1;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fd);
+        return -1;
+    }
+
+    const auto size = static_cast<std::uint64_t>(st.st_size);
+    // the region reaches the end of the file, so the child can read the file itself.
+    if (!S_ISREG(st.st_mode) || offset >= size || length >= size - offset)
+    {
+        if (offset != 0u && ::lseek(fd, static_cast<off_t>(offset), SEEK_SET) == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool sealable = false;
+    const int mfd = create_anonymous_file(sealable, ec);
+    if (mfd == -1)
+    {
+        ::close(fd);
+        return -1;
+    }
+    const bool copied = copy_region(fd, offset, length, mfd, ec);
+    ::close(fd);
+    if (!copied)
+    {
+        ::close(mfd);
+        return -1;
+    }
+    return finish_memory_fd(mfd, sealable, ec);
+}
+
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/posix/detail/memory_fd.hpp>
+#include <boost/process/v2/posix/response_file.hpp>
+
+#include <cstring>
+
+#include <unistd.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace posix
+{
+
+namespace detail
+{
+
+std::size_t exec_args_size(const char * const * argv)
+{
+    std::size_t size = 0u;
+    if (argv == nullptr)
+        return size;
+    for (; *argv != nullptr; argv++)
+        size += std::strlen(*argv) + 1u + sizeof(char*);
+    return size + sizeof(char*);
+}
+
+bool exec_arg_too_long(const char * const * argv)
+{
+#if defined(__linux__)
+    // linux limits every single string to MAX_ARG_STRLEN, i.e. 32 pages.
+    const auto max = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) * 32u;
+    for (; *argv != nullptr; argv++)
+        if (std::strlen(*argv) >= max)
+            return true;
+#else
+    (void)argv;
+#endif
+    return false;
+}
+
+int write_response_file(const char * const * argv, error_code & ec)
+{
+    std::string content;
+    for (; *argv != nullptr; argv++)
+    {
+        const char * arg = *argv;
+        if (*arg == '\0')
+            content += "\"\"";
+        for (; *arg != '\0'; arg++)
+        {
+            if (std::strchr(" \t\n\r\f\v'\"\\", *arg) != nullptr)
+                content += '\\';
+            content += *arg;
+        }
+        content += '\n';
+    }
+    return open_memory_fd(content.data(), content.size(), ec);
+}
+
+}
+
+std::size_t response_file::default_threshold()
+{
+    const auto arg_max = ::sysconf(_SC_ARG_MAX);
+    if (arg_max <= 0)
+        return 65536u;
+    return static_cast<std::size_t>(arg_max) / 2u;
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
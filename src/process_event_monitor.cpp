@@ -0,0 +1,320 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(__linux__)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/process_event_monitor.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace detail
+{
+
+namespace
+{
+
+// reads the parent from /proc/<pid>/stat, relative to proc_fd.
+pid_type read_parent_(int proc_fd, pid_type pid)
+{
+    char path[32];
+    ::snprintf(path, sizeof(path), "%d/stat", static_cast<int>(pid));
+    const int fd = ::openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+
+    char buf[512];
+    ssize_t n;
+    do
+        n = ::read(fd, buf, sizeof(buf) - 1u);
+    while (n == -1 && errno == EINTR);
+    ::close(fd);
+    if (n <= 0)
+        return -1;
+    buf[n] = '\0';
+
+    // the command name in parentheses may contain anything, so start after the last ')'
+    const char * p = std::strrchr(buf, ')');
+    if (p == nullptr || p[1] != ' ' || p[2] == '\0' || p[3] != ' ')
+        return -1;
+    return static_cast<pid_type>(std::strtol(p + 4, nullptr, 10));
+}
+
+bool send_mcast_op_(int fd, proc_cn_mcast_op op)
+{
+    union
+    {
+        nlmsghdr hdr;
+        char buf[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))];
+    } msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    msg.hdr.nlmsg_type = NLMSG_DONE;
+    msg.hdr.nlmsg_pid = 0u;
+
+    auto cn = static_cast<cn_msg*>(NLMSG_DATA(&msg.hdr));
+    cn->id.idx = CN_IDX_PROC;
+    cn->id.val = CN_VAL_PROC;
+    cn->len = sizeof(proc_cn_mcast_op);
+    std::memcpy(cn->data, &op, sizeof(op));
+
+    ssize_t n;
+    do
+        n = ::send(fd, &msg, msg.hdr.nlmsg_len, 0);
+    while (n == -1 && errno == EINTR);
+    return n != -1;
+}
+
+// invokes func for every proc_event in the datagram.
+template<typename Function>
+void for_each_proc_event_(const char * buf, ssize_t size, Function func)
+{
+    int len = static_cast<int>(size);
+    for (auto nh = reinterpret_cast<const nlmsghdr*>(buf); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
+    {
+        if (nh->nlmsg_type == NLMSG_NOOP || nh->nlmsg_type == NLMSG_ERROR)
+            continue;
+        if (nh->nlmsg_len < NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_event)))
+            continue;
+        auto cn = static_cast<const cn_msg*>(NLMSG_DATA(nh));
+        if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC)
+            continue;
+        proc_event ev;
+        std::memcpy(&ev, cn->data, sizeof(ev));
+        func(ev);
+    }
+}
+
+}
+
+process_tree::~process_tree()
+{
+    if (proc_fd_ != -1)
+        ::close(proc_fd_);
+}
+
+void process_tree::unlink_(pid_type pid, pid_type parent)
+{
+    auto itr = nodes_.find(parent);
+    if (itr == nodes_.end())
+        return;
+    auto & cs = itr->second.children;
+    cs.erase(std::remove(cs.begin(), cs.end(), pid), cs.end());
+}
+
+void process_tree::add(pid_type pid, pid_type parent)
+{
+    auto & n = nodes_[pid];
+    if (n.parent != -1)
+        unlink_(pid, n.parent);
+    n.parent = parent;
+    auto itr = nodes_.find(parent);
+    if (itr != nodes_.end())
+        itr->second.children.push_back(pid);
+}
+
+void process_tree::remove(pid_type pid)
+{
+    auto itr = nodes_.find(pid);
+    if (itr == nodes_.end())
+        return;
+    unlink_(pid, itr->second.parent);
+    auto orphans = std::move(itr->second.children);
+    nodes_.erase(itr);
+    if (orphans.empty())
+        return;
+
+    // the exit event is sent before the kernel reparents the children, so it might still be pending.
+    if (proc_fd_ == -1)
+        proc_fd_ = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    for (auto o : orphans)
+    {
+        auto parent = proc_fd_ != -1 ? read_parent_(proc_fd_, o) : -1;
+        if (parent == -1 || parent == pid)
+            parent = root_pid;
+        auto & n = nodes_[o];
+        n.parent = parent;
+        auto p = nodes_.find(parent);
+        if (p != nodes_.end())
+            p->second.children.push_back(o);
+    }
+}
+
+void process_tree::sync(const std::vector<std::pair<pid_type, pid_type>> & scan,
+                        std::vector<process_event> & events)
+{
+    std::unordered_map<pid_type, node> nodes;
+    nodes.reserve(scan.size());
+    for (auto & s : scan)
+        nodes[s.first].parent = s.second;
+
+    for (auto & n : nodes_)
+        if (nodes.count(n.first) == 0u)
+            events.push_back(process_event{process_event::exit, n.first, n.second.parent, -1});
+
+    for (auto & s : scan)
+    {
+        if (nodes_.count(s.first) == 0u)
+            events.push_back(process_event{process_event::fork, s.first, s.second, -1});
+        auto p = nodes.find(s.second);
+        if (p != nodes.end())
+            p->second.children.push_back(s.first);
+    }
+    nodes_ = std::move(nodes);
+}
+
+pid_type process_tree::parent(pid_type pid) const
+{
+    auto itr = nodes_.find(pid);
+    return itr != nodes_.end() ? itr->second.parent : -1;
+}
+
+std::vector<pid_type> process_tree::children(pid_type pid) const
+{
+    auto itr = nodes_.find(pid);
+    return itr != nodes_.end() ? itr->second.children : std::vector<pid_type>{};
+}
+
+int open_proc_connector(error_code & ec)
+{
+    const int fd = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return -1;
+    }
+
+    sockaddr_nl addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_pid = 0u;
+    addr.nl_groups = CN_IDX_PROC;
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1
+        || !send_mcast_op_(fd, PROC_CN_MCAST_LISTEN))
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        ::close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void close_proc_connector(int fd)
+{
+    // only counts as a listener if the subscription worked, but an extra ignore is harmless.
+    send_mcast_op_(fd, PROC_CN_MCAST_IGNORE);
+    ::close(fd);
+}
+
+void read_proc_events(int fd, std::vector<process_event> & events, bool & acknowledged, error_code & ec)
+{
+    alignas(nlmsghdr) char buf[8192];
+    bool overrun = false;
+    while (true)
+    {
+        const auto n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n == -1 && errno == ENOBUFS)
+        {
+            // events got dropped, but the socket can still be read.
+            overrun = true;
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return;
+        }
+
+        for_each_proc_event_(buf, n,
+            [&](const proc_event & ev)
+            {
+                switch (ev.what)
+                {
+                case proc_event::PROC_EVENT_NONE:
+                    // the acknowledgement of the subscription.
+                    if (ev.event_data.ack.err == 0u)
+                        acknowledged = true;
+                    else
+                        BOOST_PROCESS_V2_ASSIGN_EC(ec, static_cast<int>(ev.event_data.ack.err), system_category());
+                    break;
+                case proc_event::PROC_EVENT_FORK:
+                    // a new thread is reported as a fork too, with a different pid & tgid.
+                    if (ev.event_data.fork.child_pid == ev.event_data.fork.child_tgid)
+                        events.push_back(process_event{process_event::fork,
+                                                       ev.event_data.fork.child_tgid,
+                                                       ev.event_data.fork.parent_tgid, -1});
+                    break;
+                case proc_event::PROC_EVENT_EXEC:
+                    // any thread can exec, it becomes the thread group leader.
+                    events.push_back(process_event{process_event::exec,
+                                                   ev.event_data.exec.process_tgid, -1, -1});
+                    break;
+                case proc_event::PROC_EVENT_EXIT:
+                    if (ev.event_data.exit.process_pid == ev.event_data.exit.process_tgid)
+                        events.push_back(process_event{process_event::exit,
+                                                       ev.event_data.exit.process_tgid, -1,
+                                                       static_cast<int>(ev.event_data.exit.exit_code)});
+                    break;
+                default:
+                    break;
+                }
+            });
+        if (ec)
+            return;
+    }
+    if (overrun)
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, ENOBUFS, system_category());
+}
+
+void scan_processes(std::vector<std::pair<pid_type, pid_type>> & scan, error_code & ec)
+{
+    scan.clear();
+    DIR * dir = ::opendir("/proc");
+    if (dir == nullptr)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+    const int proc_fd = ::dirfd(dir);
+    while (auto ent = ::readdir(dir))
+    {
+        if (*ent->d_name < '0' || *ent->d_name > '9')
+            continue;
+        const auto pid = static_cast<pid_type>(std::atoi(ent->d_name));
+        // the process might have exited since.
+        const auto parent = read_parent_(proc_fd, pid);
+        if (parent != -1)
+            scan.emplace_back(pid, parent);
+    }
+    ::closedir(dir);
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
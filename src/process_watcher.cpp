@@ -0,0 +1,74 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/process_watcher.hpp>
+
+#include <cerrno>
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if !defined(P_PIDFD)
+#define P_PIDFD 3
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace detail
+{
+
+int open_pidfd(pid_type pid, error_code & ec)
+{
+    // pidfds are always close-on-exec.
+    const auto fd = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+    if (fd == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+    return fd;
+}
+
+void send_signal_to_pidfd(int pidfd, int sig, error_code & ec)
+{
+    if (::syscall(SYS_pidfd_send_signal, pidfd, sig, nullptr, 0) == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+}
+
+int peek_exit_status(int pidfd)
+{
+    siginfo_t info{};
+    int res;
+    do
+        res = ::waitid(static_cast<idtype_t>(P_PIDFD), static_cast<id_t>(pidfd), &info,
+                       WEXITED | WNOHANG | WNOWAIT);
+    while (res == -1 && errno == EINTR);
+    // ECHILD if it's not a child or already reaped, EINVAL if the kernel doesn't know P_PIDFD.
+    if (res == -1 || info.si_pid == 0)
+        return -1;
+
+    // rebuild the status waitpid would report.
+    switch (info.si_code)
+    {
+    case CLD_EXITED:
+        return (info.si_status & 0xff) << 8;
+    case CLD_KILLED:
+        return info.si_status & 0x7f;
+    case CLD_DUMPED:
+        return (info.si_status & 0x7f) | 0x80;
+    default:
+        return -1;
+    }
+}
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
@@ -0,0 +1,323 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/exit_code.hpp>
+#include <boost/process/v2/posix/detail/close_handles.hpp>
+#include <boost/process/v2/run.hpp>
+
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+#include <boost/process/v2/process_watcher.hpp>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace
+{
+
+// the size of the reads from stdout & stderr, a full pipe on linux.
+constexpr std::size_t read_size = 64u * 1024u;
+
+struct fd_guard
+{
+    int fd = -1;
+
+    fd_guard() = default;
+    fd_guard(const fd_guard & ) = delete;
+    fd_guard& operator=(const fd_guard & ) = delete;
+    ~fd_guard() {reset();}
+
+    void reset()
+    {
+        if (fd != -1)
+            ::close(fd);
+        fd = -1;
+    }
+};
+
+struct pipe_pair
+{
+    fd_guard read, write;
+
+    void open(error_code & ec)
+    {
+        int fds[2];
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+        if (::pipe2(fds, O_CLOEXEC) == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return;
+        }
+#else
+        if (::pipe(fds) == -1)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return;
+        }
+        ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+        read.fd = fds[0];
+        write.fd = fds[1];
+    }
+};
+
+// makes fd the target in the child, which must not close-on-exec.
+bool redirect(int fd, int target)
+{
+    if (fd == target)
+        return ::fcntl(fd, F_SETFD, 0) != -1;
+    return ::dup2(fd, target) != -1;
+}
+
+// Blocks SIGPIPE while writing stdin, so a subprocess not reading it yields EPIPE
+// instead of terminating the caller. A SIGPIPE raised by the writes gets discarded at the end,
+// unless one was pending already, which can't be told apart from it.
+// Apple suppresses it on the descriptor with F_SETNOSIGPIPE instead.
+struct sigpipe_guard
+{
+    sigset_t set, previous;
+    bool active = false;
+    bool pending_before = false;
+    bool raised = false;
+
+    void block()
+    {
+#if !defined(F_SETNOSIGPIPE)
+        sigemptyset(&set);
+        sigaddset(&set, SIGPIPE);
+        active = ::pthread_sigmask(SIG_BLOCK, &set, &previous) == 0;
+        sigset_t pending;
+        pending_before = active && sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1;
+#endif
+    }
+
+    ~sigpipe_guard()
+    {
+        if (!active)
+            return;
+#if !defined(F_SETNOSIGPIPE)
+        if (raised && !pending_before)
+        {
+            // a zero timeout, so this can't block if the signal went elsewhere.
+            const timespec zero{0, 0};
+            sigtimedwait(&set, nullptr, &zero);
+        }
+        ::pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+#endif
+    }
+};
+
+bool drain(int fd, std::vector<char> & buffer, std::string & target, error_code & ec)
+{
+    for (;;)
+    {
+        const auto n = ::read(fd, buffer.data(), buffer.size());
+        if (n > 0)
+        {
+            target.append(buffer.data(), static_cast<std::size_t>(n));
+            return true;
+        }
+        else if (n == 0)
+            return false;
+        else if (errno == EAGAIN)
+            return true;
+        else if (errno != EINTR)
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            return false;
+        }
+    }
+}
+
+}
+
+void runner::run_(const filesystem::path & exe, string_view stdin_data, run_result & result, error_code & ec)
+{
+    result.exit_code = -1;
+    result.out.clear();
+    result.err.clear();
+    if (buffer_.size() != read_size)
+        buffer_.resize(read_size);
+
+    argv_.clear();
+    argv_.push_back(exe.c_str());
+    for (auto && arg : args_)
+        argv_.push_back(arg.c_str());
+    argv_.push_back(nullptr);
+
+    pipe_pair in, out, err, error_pipe;
+    in.open(ec);
+    if (!ec)
+        out.open(ec);
+    if (!ec)
+        err.open(ec);
+    if (!ec)
+        error_pipe.open(ec);
+    if (ec)
+        return;
+
+    // allocated before the fork, the child mustn't.
+    std::vector<int> whitelist{STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO, error_pipe.write.fd};
+    std::sort(whitelist.begin(), whitelist.end());
+
+    const pid_type pid = ::fork();
+    if (pid == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return;
+    }
+    else if (pid == 0)
+    {
+        error_code ec_;
+        if (redirect(in.read.fd, STDIN_FILENO)
+            && redirect(out.write.fd, STDOUT_FILENO)
+            && redirect(err.write.fd, STDERR_FILENO))
+        {
+            posix::detail::close_all(whitelist, ec_);
+            if (!ec_)
+                ::execve(exe.c_str(), const_cast<char * const *>(argv_.data()), environ);
+        }
+        int error = errno;
+        while (::write(error_pipe.write.fd, &error, sizeof(error)) == -1 && errno == EINTR);
+        ::_exit(EXIT_FAILURE);
+    }
+
+    in.read.reset();
+    out.write.reset();
+    err.write.reset();
+    error_pipe.write.reset();
+
+    // the child closes the error pipe by exec'ing, or writes errno into it.
+    int child_error = 0;
+    ssize_t n;
+    do
+        n = ::read(error_pipe.read.fd, &child_error, sizeof(child_error));
+    while (n == -1 && errno == EINTR);
+
+    int status = 0;
+    if (n > 0)
+    {
+        BOOST_PROCESS_V2_ASSIGN_EC(ec, child_error, system_category());
+        while (::waitpid(pid, &status, 0) == -1 && errno == EINTR);
+        return;
+    }
+
+    sigpipe_guard sigpipe;
+    if (stdin_data.empty())
+        in.write.reset();
+    else
+    {
+        ::fcntl(in.write.fd, F_SETFL, ::fcntl(in.write.fd, F_GETFL) | O_NONBLOCK);
+#if defined(F_SETNOSIGPIPE)
+        ::fcntl(in.write.fd, F_SETNOSIGPIPE, 1);
+#endif
+        sigpipe.block();
+    }
+
+    enum {stdin_idx, stdout_idx, stderr_idx, pidfd_idx};
+    fd_guard pidfd;
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+    {
+        // without one, the child gets reaped after closing its output.
+        error_code ign;
+        pidfd.fd = detail::open_pidfd(pid, ign);
+    }
+#endif
+
+    pollfd fds[4] = {
+        {in.write.fd,  POLLOUT, 0},
+        {out.read.fd,  POLLIN,  0},
+        {err.read.fd,  POLLIN,  0},
+        {pidfd.fd,     POLLIN,  0}
+    };
+
+    std::size_t written = 0u;
+    bool reaped = false;
+    // poll ignores negative descriptors, so finished ones get set to -1.
+    while (fds[stdout_idx].fd != -1 || fds[stderr_idx].fd != -1)
+    {
+        if (::poll(fds, 4, -1) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            break;
+        }
+
+        if (fds[stdin_idx].revents != 0)
+        {
+            const auto w = ::write(fds[stdin_idx].fd, stdin_data.data() + written, stdin_data.size() - written);
+            if (w > 0)
+                written += static_cast<std::size_t>(w);
+            else if (w == -1 && errno == EPIPE)
+                sigpipe.raised = true;
+
+            // done or the subprocess closed its stdin.
+            if (written == stdin_data.size() || (w == -1 && errno != EAGAIN && errno != EINTR))
+            {
+                in.write.reset();
+                fds[stdin_idx].fd = -1;
+            }
+        }
+
+        for (int idx : {stdout_idx, stderr_idx})
+        {
+            if (fds[idx].revents == 0)
+                continue;
+            if (!drain(fds[idx].fd, buffer_, idx == stdout_idx ? result.out : result.err, ec))
+            {
+                (idx == stdout_idx ? out : err).read.reset();
+                fds[idx].fd = -1;
+            }
+        }
+        if (ec)
+            break;
+
+        // the subprocess exited, but its children might still hold the pipes.
+        if (fds[pidfd_idx].revents != 0)
+        {
+            while (::waitpid(pid, &status, 0) == -1 && errno == EINTR);
+            reaped = true;
+            pidfd.reset();
+            fds[pidfd_idx].fd = -1;
+            if (in.write.fd != -1)
+            {
+                in.write.reset();
+                fds[stdin_idx].fd = -1;
+            }
+        }
+    }
+
+    // close the pipes before waiting, so a failed run can't block on the subprocess writing.
+    in.write.reset();
+    out.read.reset();
+    err.read.reset();
+    if (!reaped)
+        while (::waitpid(pid, &status, 0) == -1 && errno == EINTR);
+
+    if (!ec)
+        result.exit_code = evaluate_exit_code(status);
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
+
+#endif
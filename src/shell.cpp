@@ -19,8 +19,13 @@
 #if defined(BOOST_PROCESS_V2_WINDOWS)
 #include <windows.h>
 #include <shellapi.h>
-#elif !defined(__OpenBSD__) && !defined(__ANDROID__)
-#include <wordexp.h>
+#else
+#include <boost/process/v2/environment.hpp>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <pwd.h>
+#include <unistd.h>
 #endif
 
 BOOST_PROCESS_V2_BEGIN_NAMESPACE
@@ -30,7 +35,20 @@ BOOST_PROCESS_V2_DECL const error_category& get_shell_category()
 {
     return system_category();
 }
-#elif !defined(__OpenBSD__) && !defined(__ANDROID__)
+#else
+
+namespace detail
+{
+
+// The values match the corresponding WRDE_* codes of glibc's wordexp, which was used before.
+enum shell_error
+{
+    shell_bad_char = 2,
+    shell_command_substitution = 4,
+    shell_syntax = 5
+};
+
+}
 
 struct shell_category_t final : public error_category
 {
@@ -44,18 +62,14 @@ struct shell_category_t final : public error_category
     {
         switch (value)
         {
-        case WRDE_BADCHAR:
+        case detail::shell_bad_char:
             return "Illegal occurrence of newline or one of |, &, ;, <, >, (, ), {, }.";
-        case WRDE_BADVAL:
-            return "An undefined shell variable was referenced, and the WRDE_UNDEF flag told us to consider this an error.";
-        case WRDE_CMDSUB:
-            return "Command substitution occurred, and the WRDE_NOCMD flag told us to consider this an error.";
-        case WRDE_NOSPACE:
-            return "Out of memory.";
-        case WRDE_SYNTAX:
-            return "Shell syntax error, such as unbalanced parentheses or unmatched quotes.";
+        case detail::shell_command_substitution:
+            return "Command substitution is not supported.";
+        case detail::shell_syntax:
+            return "Shell syntax error, such as unmatched quotes or a bad substitution.";
         default:
-            return "process.v2.wordexp error";
+            return "process.v2.shell error";
         }
     }
 };
@@ -66,18 +80,11 @@ BOOST_PROCESS_V2_DECL const error_category& get_shell_category()
     return instance;
 }
 
-#else
-
-const error_category& get_shell_category()
-{
-    return system_category();
-}
-
 #endif
 
 #if defined (BOOST_PROCESS_V2_WINDOWS)
 
-void shell::parse_()
+void shell::parse_(bool)
 {
     argv_ = ::CommandLineToArgvW(input_.c_str(), &argc_);
     if (argv_ == nullptr)
@@ -99,29 +106,259 @@ auto shell::args() const-> args_type
     return input_.c_str();
 }
 
-#elif !defined(__OpenBSD__) && !defined(__ANDROID__)
+#else
+
+namespace detail
+{
 
-void shell::parse_()
+// Splits a command line according to the posix shell quoting rules.
+// It runs twice: first without an arena to measure, then writing into the arena.
+struct shell_tokenizer
 {
-    wordexp_t we{};
-    auto cd = wordexp(input_.c_str(), &we, WRDE_NOCMD);
+    const char * pos;
+    const char * const end;
+    const bool expand;
 
-    if (cd != 0)
-        detail::throw_error(error_code(cd, get_shell_category()), "shell::parse");
-    else
+    char ** argv = nullptr;
+    char * out = nullptr;
+    std::size_t words = 0u;
+    std::size_t chars = 0u;
+    // the measured size, which the writing pass must not exceed if the environment changed in between
+    std::size_t max_words = static_cast<std::size_t>(-1);
+    std::size_t max_chars = static_cast<std::size_t>(-1);
+
+    shell_tokenizer(const char * begin, const char * end, bool expand)
+        : pos(begin), end(end), expand(expand)
+    {
+    }
+
+    void put(char c)
+    {
+        if (chars == max_chars)
+            return;
+        if (out != nullptr)
+            out[chars] = c;
+        chars++;
+    }
+
+    void put(const char * data, std::size_t size)
+    {
+        if (size > max_chars - chars)
+            size = max_chars - chars;
+        if (out != nullptr)
+            std::memcpy(out + chars, data, size);
+        chars += size;
+    }
+
+    static bool is_blank(char c) {return c == ' ' || c == '\t';}
+    static bool is_name_start(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+    static bool is_name(char c) {return is_name_start(c) || (c >= '0' && c <= '9');}
+    static bool is_special(char c) {return c != '\0' && std::strchr("\n|&;<>(){}", c) != nullptr;}
+
+    static const char * find_env(const char * name, std::size_t size)
+    {
+        for (auto e = environment::detail::load_native_handle(); e != nullptr && *e != nullptr; e++)
+            if (std::strncmp(*e, name, size) == 0 && (*e)[size] == '=')
+                return *e + size + 1;
+        return nullptr;
+    }
+
+    void put_env(const char * name, std::size_t size)
+    {
+        if (const auto value = find_env(name, size))
+            put(value, std::strlen(value));
+    }
+
+    // `~` or `~user` at the start of a word, left as is if the user is unknown.
+    void tilde()
+    {
+        auto p = pos + 1;
+        while (p != end && (is_name(*p) || *p == '.' || *p == '-'))
+            p++;
+        if (p != end && *p != '/' && !is_blank(*p))
+            return put(*pos++);
+
+        const auto name = pos + 1;
+        const auto size = static_cast<std::size_t>(p - name);
+        if (size == 0u)
+        {
+            put_env("HOME", 4u);
+            pos = p;
+            return;
+        }
+
+        char user[256];
+        char buf[4096];
+        passwd pwd, *result = nullptr;
+        if (size < sizeof(user))
+        {
+            std::memcpy(user, name, size);
+            user[size] = '\0';
+            ::getpwnam_r(user, &pwd, buf, sizeof(buf), &result);
+        }
+        if (result == nullptr)
+            return put(*pos++);
+        put(result->pw_dir, std::strlen(result->pw_dir));
+        pos = p;
+    }
+
+    // `pos` points to the `$`.
+    int dollar()
+    {
+        auto p = pos + 1;
+        if (p != end && *p == '(')
+            return shell_command_substitution;
+        if (p != end && *p == '{')
+        {
+            const auto name = ++p;
+            while (p != end && is_name(*p))
+                p++;
+            if (p == end || *p != '}' || p == name || !is_name_start(*name))
+                return shell_syntax;
+            put_env(name, static_cast<std::size_t>(p - name));
+            pos = p + 1;
+        }
+        else if (p != end && is_name_start(*p))
+        {
+            const auto name = p;
+            while (p != end && is_name(*p))
+                p++;
+            put_env(name, static_cast<std::size_t>(p - name));
+            pos = p;
+        }
+        else // not an expansion we support, e.g. $1 or $?
+            put(*pos++);
+        return 0;
+    }
+
+    int double_quoted()
+    {
+        pos++;
+        while (pos != end)
+        {
+            const char c = *pos;
+            if (c == '"')
+            {
+                pos++;
+                return 0;
+            }
+            else if (c == '\\' && pos + 1 != end && std::strchr("$`\"\\\n", pos[1]) != nullptr)
+            {
+                if (pos[1] != '\n')
+                    put(pos[1]);
+                pos += 2;
+            }
+            else if (expand && c == '$')
+            {
+                if (auto res = dollar())
+                    return res;
+            }
+            else if (expand && c == '`')
+                return shell_command_substitution;
+            else
+                put(*pos++);
+        }
+        return shell_syntax;
+    }
+
+    int word()
+    {
+        if (expand && *pos == '~')
+            tilde();
+
+        while (pos != end && !is_blank(*pos))
+        {
+            const char c = *pos;
+            if (is_special(c))
+                return shell_bad_char;
+            else if (c == '\\')
+            {
+                if (++pos == end)
+                    return shell_syntax;
+                if (*pos != '\n')
+                    put(*pos);
+                pos++;
+            }
+            else if (c == '\'')
+            {
+                const auto close = static_cast<const char*>(std::memchr(pos + 1, '\'', end - pos - 1));
+                if (close == nullptr)
+                    return shell_syntax;
+                put(pos + 1, static_cast<std::size_t>(close - pos - 1));
+                pos = close + 1;
+            }
+            else if (c == '"')
+            {
+                if (auto res = double_quoted())
+                    return res;
+            }
+            else if (expand && c == '$')
+            {
+                if (auto res = dollar())
+                    return res;
+            }
+            else if (expand && c == '`')
+                return shell_command_substitution;
+            else
+                put(*pos++);
+        }
+        return 0;
+    }
+
+    int run()
     {
-        argc_ = static_cast<int>(we.we_wordc);
-        argv_ = we.we_wordv;
+        while (true)
+        {
+            // blanks & line continuations between words
+            while (pos != end && (is_blank(*pos) || (*pos == '\\' && pos + 1 != end && pos[1] == '\n')))
+                pos += is_blank(*pos) ? 1 : 2;
+            if (pos == end)
+                return 0;
+
+            const auto start = chars;
+            if (auto res = word())
+                return res;
+            put('\0');
+            if (words != max_words)
+            {
+                if (argv != nullptr)
+                    argv[words] = out + (std::min)(start, max_chars - 1u);
+                words++;
+            }
+        }
     }
+};
+
+}
+
+void shell::parse_(bool expand)
+{
+    const auto begin = input_.c_str();
+    detail::shell_tokenizer measure{begin, begin + input_.size(), expand};
+    if (const auto res = measure.run())
+        detail::throw_error(error_code(res, get_shell_category()), "shell::parse");
+    if (measure.words == 0u)
+        return;
+
+    // the argv array and all the strings share one allocation, starting with the pointers for alignment.
+    const auto arena = static_cast<char**>(::operator new((measure.words + 1) * sizeof(char*) + measure.chars));
+    detail::shell_tokenizer write{begin, begin + input_.size(), expand};
+    write.argv = arena;
+    write.out = reinterpret_cast<char*>(arena + measure.words + 1);
+    write.max_words = measure.words;
+    write.max_chars = measure.chars;
+    write.run();
+    write.out[measure.chars - 1u] = '\0';
+    arena[write.words] = nullptr;
 
-    free_argv_ = +[](int argc, char ** argv)
+    argc_ = static_cast<int>(write.words);
+    argv_ = arena;
+    free_argv_ = +[](int, char ** argv)
     {
-        wordexp_t we{
-                .we_wordc = static_cast<std::size_t>(argc),
-                .we_wordv = argv,
-                .we_offs = 0
-        };
-        wordfree(&we);
+        ::operator delete(argv);
     };
 }
 
@@ -142,22 +379,6 @@ auto shell::args() const -> args_type
         return const_cast<const char**>(argv());
 }
 
-#else
-
-void shell::parse_()
-{
-    error_code ec;
-    BOOST_PROCESS_V2_ASSIGN_EC(ec, ENOTSUP, system_category());
-    throw system_error(ec, "shell::parse");
-}
-
-shell::~shell() = default;
-
-auto shell::args() const -> args_type
-{
-    return nullptr;
-}
-
 #endif
 
 BOOST_PROCESS_V2_END_NAMESPACE
@@ -0,0 +1,275 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/process/v2/detail/config.hpp>
+#include <boost/process/v2/detail/last_error.hpp>
+#include <boost/process/v2/wait_any.hpp>
+
+#include <algorithm>
+#include <cerrno>
+
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+#include <atomic>
+#include <vector>
+#include <windows.h>
+#elif defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#define BOOST_PROCESS_V2_WAIT_ANY_KQUEUE 1
+#include <vector>
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#include <unistd.h>
+#else
+#include <sys/wait.h>
+#include <time.h>
+#endif
+
+BOOST_PROCESS_V2_BEGIN_NAMESPACE
+
+namespace detail
+{
+
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+
+namespace
+{
+
+// The state shared by the registered waits of wait_for_any_handle.
+struct any_handle_wait
+{
+    HANDLE done;
+    std::atomic<std::size_t> index{static_cast<std::size_t>(-1)};
+};
+
+struct any_handle_registration
+{
+    any_handle_wait * wait;
+    std::size_t index;
+};
+
+VOID CALLBACK on_handle_signaled(PVOID param, BOOLEAN)
+{
+    auto reg = static_cast<any_handle_registration*>(param);
+    std::size_t none = static_cast<std::size_t>(-1);
+    if (reg->wait->index.compare_exchange_strong(none, reg->index))
+        ::SetEvent(reg->wait->done);
+}
+
+}
+
+std::size_t wait_for_any_handle(void * const * handles, std::size_t count, error_code & ec)
+{
+    if (count <= MAXIMUM_WAIT_OBJECTS)
+    {
+        const auto res = ::WaitForMultipleObjects(static_cast<DWORD>(count), handles, FALSE, INFINITE);
+        if (res == WAIT_FAILED)
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return res - WAIT_OBJECT_0;
+    }
+
+    // more handles than a single wait can take, so the wait threads of the thread pool,
+    // each taking up to 63 handles, wait for us & the first one signaled sets the event.
+    any_handle_wait state;
+    state.done = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (state.done == nullptr)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return 0u;
+    }
+
+    std::vector<any_handle_registration> regs(count);
+    std::vector<HANDLE> waits(count, nullptr);
+    for (std::size_t i = 0u; i < count; i++)
+    {
+        regs[i] = any_handle_registration{&state, i};
+        if (!::RegisterWaitForSingleObject(&waits[i], handles[i], &on_handle_signaled, &regs[i],
+                                           INFINITE, WT_EXECUTEONLYONCE))
+        {
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+            waits[i] = nullptr;
+            break;
+        }
+    }
+
+    if (!ec && ::WaitForSingleObject(state.done, INFINITE) == WAIT_FAILED)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+
+    // blocks until running callbacks are done, so the state can't be used afterwards.
+    for (auto w : waits)
+        if (w != nullptr)
+            ::UnregisterWaitEx(w, INVALID_HANDLE_VALUE);
+    ::CloseHandle(state.done);
+    return ec ? 0u : state.index.load();
+}
+
+#elif defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+
+int open_wait_set(error_code & ec)
+{
+    const int set = ::epoll_create1(EPOLL_CLOEXEC);
+    if (set == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+    return set;
+}
+
+void close_wait_set(int set)
+{
+    ::close(set);
+}
+
+void add_to_wait_set(int set, int pidfd, std::size_t index, error_code & ec)
+{
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = index;
+    if (::epoll_ctl(set, EPOLL_CTL_ADD, pidfd, &ev) == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+}
+
+std::size_t next_in_wait_set(int set, int timeout, error_code & ec)
+{
+    struct epoll_event ev{};
+    int n;
+    do
+        n = ::epoll_wait(set, &ev, 1, timeout);
+    while (n == -1 && errno == EINTR);
+
+    if (n == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+    if (n != 1)
+        return static_cast<std::size_t>(-1);
+    return static_cast<std::size_t>(ev.data.u64);
+}
+
+void remove_from_wait_set(int set, int pidfd, error_code & ec)
+{
+    if (::epoll_ctl(set, EPOLL_CTL_DEL, pidfd, nullptr) == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+}
+
+std::size_t drain_wait_set(int set, std::uint64_t * indices, std::size_t size, error_code & ec)
+{
+    struct epoll_event evs[64];
+    const auto max = static_cast<int>((std::min)(size, sizeof(evs) / sizeof(evs[0])));
+    int n;
+    do
+        n = ::epoll_wait(set, evs, max, 0);
+    while (n == -1 && errno == EINTR);
+
+    if (n == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return 0u;
+    }
+    for (int i = 0; i < n; i++)
+        indices[i] = evs[i].data.u64;
+    return static_cast<std::size_t>(n);
+}
+
+#elif defined(BOOST_PROCESS_V2_WAIT_ANY_KQUEUE)
+
+std::size_t wait_for_any_pid(const pid_type * pids, std::size_t count, error_code & ec)
+{
+    const int kq = ::kqueue();
+    if (kq == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return 0u;
+    }
+
+    const auto index_of = [&](std::uintptr_t pid)
+        {
+            return static_cast<std::size_t>(std::find(pids, pids + count, static_cast<pid_type>(pid)) - pids);
+        };
+
+    // registering fails with ESRCH for processes that exited in the meantime,
+    // which gets reported as an event, as does an exit that's already pending.
+    std::vector<struct kevent> changes(count), events(count);
+    for (std::size_t i = 0u; i < count; i++)
+        EV_SET(&changes[i], pids[i], EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, 0);
+
+    const struct timespec no_wait{0, 0};
+    int n;
+    do
+        n = ::kevent(kq, changes.data(), static_cast<int>(count), events.data(), static_cast<int>(count), &no_wait);
+    while (n == -1 && errno == EINTR);
+
+    std::size_t index = count;
+    for (int i = 0; i < n && index == count; i++)
+    {
+        if ((events[i].flags & EV_ERROR) == 0 || events[i].data == ESRCH)
+            index = index_of(events[i].ident);
+        else if (events[i].data != 0)
+            BOOST_PROCESS_V2_ASSIGN_EC(ec, static_cast<int>(events[i].data), system_category());
+    }
+    if (n == -1)
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+
+    while (!ec && index == count)
+    {
+        n = ::kevent(kq, nullptr, 0, events.data(), 1, nullptr);
+        if (n == -1 && errno != EINTR)
+            BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        else if (n == 1)
+            index = index_of(events[0].ident);
+    }
+    ::close(kq);
+    return ec ? 0u : index;
+}
+
+#else
+
+std::size_t wait_for_any_pid(const pid_type * pids, std::size_t count, error_code & ec)
+{
+    siginfo_t info{};
+    int res;
+    do
+        res = ::waitid(P_ALL, 0, &info, WEXITED | WNOWAIT);
+    while (res == -1 && errno == EINTR);
+    if (res == -1)
+    {
+        BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+        return 0u;
+    }
+
+    const auto itr = std::find(pids, pids + count, static_cast<pid_type>(info.si_pid));
+    if (itr != pids + count)
+        return static_cast<std::size_t>(itr - pids);
+
+    // another child is waitable & will stay so until its owner reaps it, so waiting for any child
+    // wouldn't block anymore. Without a descriptor per process, poll each one with a bounded sleep.
+    long sleep_ns = 1000000l;
+    for (;;)
+    {
+        for (std::size_t i = 0u; i < count; i++)
+        {
+            info = siginfo_t{};
+            do
+                res = ::waitid(P_PID, static_cast<id_t>(pids[i]), &info, WEXITED | WNOHANG | WNOWAIT);
+            while (res == -1 && errno == EINTR);
+            if (res == -1)
+            {
+                BOOST_PROCESS_V2_ASSIGN_LAST_ERROR(ec);
+                return 0u;
+            }
+            // WNOHANG leaves si_pid zero if the process is still running.
+            if (info.si_pid != 0)
+                return i;
+        }
+        timespec ts{0, sleep_ns};
+        ::nanosleep(&ts, nullptr);
+        if (sleep_ns < 50000000l)
+            sleep_ns *= 2;
+    }
+}
+
+#endif
+
+}
+
+BOOST_PROCESS_V2_END_NAMESPACE
@@ -252,6 +252,50 @@ BOOST_AUTO_TEST_CASE(large_data, *boost::unit_test::timeout(20))
     th.join();
 }
 
+BOOST_AUTO_TEST_CASE(large_data_bulk, *boost::unit_test::timeout(20))
+{
+    bp::pipe pipe;
+
+    bp::ipstream is(pipe, 4096);
+    bp::opstream os(std::move(pipe), 4096);
+
+    BOOST_CHECK_EQUAL(is.rdbuf()->buffer_size(), 4096u);
+    BOOST_CHECK_EQUAL(os.rdbuf()->buffer_size(), 4096u);
+
+    std::string in(1000000, '0');
+    int cnt = 0;
+    for (auto & c: in)
+        c = (cnt++ % 26) + 'A';
+
+    std::thread th([&]
+        {
+            // the small writes stay pending in the put area and must precede the bulk write
+            os << "head";
+            os.write(in.data(), in.size());
+            os << "tail" << std::endl;
+        });
+
+    std::string head(4, ' ');
+    BOOST_REQUIRE(is.read(&head.front(), head.size()));
+    BOOST_CHECK_EQUAL(head, "head");
+
+    std::string out(in.size(), ' ');
+    BOOST_REQUIRE(is.read(&out.front(), out.size()));
+    BOOST_CHECK_EQUAL(is.gcount(), static_cast<std::streamsize>(in.size()));
+    BOOST_CHECK(out == in);
+
+    std::string tail;
+    is >> tail;
+    BOOST_CHECK_EQUAL(tail, "tail");
+    th.join();
+}
+
+BOOST_AUTO_TEST_CASE(small_buffer_size, *boost::unit_test::timeout(2))
+{
+    bp::pipebuf buf(1);
+    BOOST_CHECK_EQUAL(buf.buffer_size(), static_cast<std::size_t>(bp::pipebuf::min_buffer_size));
+}
+
 BOOST_AUTO_TEST_CASE(closed, *boost::unit_test::timeout(2))
 {
     bp::opstream os;
@@ -28,7 +28,9 @@
 #include <system_error>
 
 
+#include <cstring>
 #include <string>
+#include <sys/mman.h>
 #include <sys/wait.h>
 #include <errno.h>
 
@@ -112,6 +114,39 @@ BOOST_AUTO_TEST_CASE(execve_throw_on_error, *boost::unit_test::timeout(2))
     }
 }
 
+BOOST_AUTO_TEST_CASE(exclude_fork_regions, *boost::unit_test::timeout(5))
+{
+    using boost::unit_test::framework::master_test_suite;
+
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    auto mem = static_cast<char*>(::mmap(nullptr, 4 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    BOOST_REQUIRE(mem != MAP_FAILED);
+    std::memset(mem, 'x', 4 * page);
+
+    boost::process::v2::posix::fork_region_registry registry;
+    registry.add(mem, 4 * page);
+
+    std::error_code ec;
+    bp::child c(
+        master_test_suite().argv[1],
+        "test", "--exit-code", "42",
+        bp::posix::exclude_fork_regions(registry),
+        ec
+    );
+    BOOST_CHECK(!ec);
+    c.wait();
+    BOOST_CHECK_EQUAL(c.exit_code(), 42);
+    BOOST_CHECK(!registry.excluded());
+
+    //a failed launch restores the regions as well.
+    bp::child c2("/does/not/exist", bp::posix::exclude_fork_regions(registry), ec);
+    BOOST_CHECK(ec);
+    BOOST_CHECK(!registry.excluded());
+
+    registry.remove(mem);
+    ::munmap(mem, 4 * page);
+}
+
 BOOST_AUTO_TEST_CASE(leak_test, *boost::unit_test::timeout(5))
 {
     using boost::unit_test::framework::master_test_suite;
@@ -0,0 +1,174 @@
+// Copyright (c) 2022 Klemens D. Morgenstern
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+
+// Disable autolinking for unit tests.
+#if !defined(BOOST_ALL_NO_LIB)
+#define BOOST_ALL_NO_LIB 1
+#endif // !defined(BOOST_ALL_NO_LIB)
+
+#define BOOST_TEST_IGNORE_SIGCHLD 1
+// asio's notify_fork collects the services into a new vector on every fork,
+// so launches only avoid the heap without it.
+#define BOOST_PROCESS_V2_DISABLE_NOTIFY_FORK 1
+
+// Test that header file is self-contained.
+#include <boost/process/v2/execute.hpp>
+#include <boost/process/v2/process.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace bpv = boost::process::v2;
+namespace asio = boost::asio;
+
+// Counts every heap allocation of the test.
+static std::atomic<std::size_t> allocations{0u};
+
+void * operator new(std::size_t size)
+{
+  allocations++;
+  if (void * p = std::malloc(size == 0u ? 1u : size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+template<typename T>
+struct counting_allocator
+{
+  using value_type = T;
+  std::size_t * count;
+
+  explicit counting_allocator(std::size_t * count) : count(count) {}
+  template<typename U>
+  counting_allocator(const counting_allocator<U> & lhs) : count(lhs.count) {}
+
+  T * allocate(std::size_t n)
+  {
+    ++*count;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T * p, std::size_t n)
+  {
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  bool operator==(const counting_allocator & rhs) const {return count == rhs.count;}
+  bool operator!=(const counting_allocator & rhs) const {return count != rhs.count;}
+};
+
+BOOST_AUTO_TEST_SUITE(with_target);
+
+BOOST_AUTO_TEST_CASE(execute_associated_allocator)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  std::size_t count = 0u;
+  int exit_code = -1;
+
+  struct handler
+  {
+    using allocator_type = counting_allocator<void>;
+    allocator_type get_allocator() const {return alloc;}
+
+    allocator_type alloc;
+    int & exit_code;
+
+    void operator()(bpv::error_code ec, int code)
+    {
+      BOOST_CHECK_MESSAGE(!ec, ec.message());
+      exit_code = code;
+    }
+  };
+
+  bpv::async_execute(bpv::process(ctx, pth, {"exit-code", "42"}), handler{counting_allocator<void>(&count), exit_code});
+  ctx.run();
+  BOOST_CHECK_EQUAL(exit_code, 42);
+  // the process itself is allocated with the handler's allocator.
+  BOOST_CHECK_GE(count, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(execute_steady_state)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const bpv::filesystem::path pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  // reused, so the argv storage of the launcher doesn't get reallocated.
+  bpv::default_process_launcher launcher;
+  const std::vector<bpv::string_view> args{"exit-code", "0"};
+
+  // the first few executions fill the recycling caches & the reactor's descriptor pool.
+  constexpr std::size_t warm_up = 4u, executions = 16u;
+  std::size_t idx = 0u, failed = 0u, before = 0u, after = 0u;
+
+  struct next_execute
+  {
+    asio::io_context & ctx;
+    bpv::default_process_launcher & launcher;
+    const bpv::filesystem::path & pth;
+    const std::vector<bpv::string_view> & args;
+    std::size_t & idx;
+    std::size_t & failed;
+    std::size_t & before;
+    std::size_t & after;
+
+    void operator()(bpv::error_code ec, int code)
+    {
+      if (ec || code != 0)
+        failed++;
+      (*this)();
+    }
+
+    void operator()()
+    {
+      if (idx == warm_up)
+        before = allocations.load();
+      if (idx == executions)
+      {
+        after = allocations.load();
+        return;
+      }
+      idx++;
+      bpv::error_code ec;
+      auto proc = launcher(ctx, ec, pth, args);
+      if (ec)
+        failed++;
+      else
+        bpv::async_execute(std::move(proc), *this);
+    }
+  };
+
+  // start from within the io_context, like a coroutine would.
+  asio::post(ctx, next_execute{ctx, launcher, pth, args, idx, failed, before, after});
+  ctx.run();
+
+  BOOST_CHECK_EQUAL(idx, executions);
+  BOOST_CHECK_EQUAL(failed, 0u);
+  // once warmed up, neither the launch nor the execution needs a heap allocation.
+  BOOST_CHECK_EQUAL(after, before);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
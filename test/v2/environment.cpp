@@ -175,3 +175,35 @@ BOOST_AUTO_TEST_CASE(wenvironment)
     BOOST_CHECK(bpe::key_value_pair(L"FOO", {L"X", L"YY", L"Z42"}) == cmp);
 #endif
 }
+
+BOOST_AUTO_TEST_CASE(indexed_view)
+{
+    bpe::indexed_view env;
+    BOOST_CHECK(!env.stale());
+    BOOST_CHECK_EQUAL(env.find("PATH"), bpe::get("PATH"));
+    BOOST_CHECK_EQUAL(bpe::find_executable("cmd", env), bpe::find_executable("cmd"));
+    BOOST_CHECK_EQUAL(bpe::home(env), bpe::home());
+    BOOST_CHECK(!env.contains("BP2_INDEXED_TEST"));
+
+    bpe::set("BP2_INDEXED_TEST", "42");
+    BOOST_CHECK(env.stale());
+    env.refresh();
+    BOOST_CHECK(!env.stale());
+    BOOST_CHECK_EQUAL(env.find("BP2_INDEXED_TEST"), "42");
+    bpe::unset("BP2_INDEXED_TEST");
+
+    std::vector<bpe::key_value_pair> custom_env = {"FOO=1", "BAR=2", "FOO=3"};
+    for (int i = 0; i < 100; i++)
+        custom_env.emplace_back(bpe::key("VAR" + std::to_string(i)), bpe::value(std::to_string(i)));
+
+    bpe::indexed_view cenv{custom_env};
+    BOOST_CHECK_EQUAL(cenv.size(), custom_env.size());
+    BOOST_CHECK_EQUAL(cenv.find("FOO"), "1");
+    BOOST_CHECK_EQUAL(cenv.find("BAR"), "2");
+    BOOST_CHECK_EQUAL(cenv.find("VAR77"), "77");
+    BOOST_CHECK(cenv.find("VAR100").empty());
+    BOOST_CHECK(!cenv.stale());
+#if defined(BOOST_PROCESS_V2_WINDOWS)
+    BOOST_CHECK_EQUAL(cenv.find(L"fOO"), "1");
+#endif
+}
@@ -8,6 +8,7 @@
 #include <boost/process/v2/ext/cwd.hpp>
 #include <boost/process/v2/ext/env.hpp>
 #include <boost/process/v2/ext/exe.hpp>
+#include <boost/process/v2/ext/snapshot.hpp>
 #include <boost/process/v2/pid.hpp>
 #include <boost/process/v2/process.hpp>
 #include <boost/process/v2/start_dir.hpp>
@@ -178,4 +179,59 @@ BOOST_AUTO_TEST_CASE(test_env_exe)
     }
 }
 
+#if defined(__linux__)
+
+BOOST_AUTO_TEST_CASE(test_snapshot)
+{
+    using boost::unit_test::framework::master_test_suite;
+    namespace bp2 = boost::process::v2;
+    const auto pth = bp2::filesystem::canonical(master_test_suite().argv[0]);
+
+    boost::asio::io_context ctx;
+    std::vector<std::string> args = {"sleep", "10000", "moar", "args", "  to test "};
+    bp2::process proc(ctx, pth, args,
+                      bp2::process_environment{"FOO=42", "BAR=FOO"},
+                      bp2::process_start_dir{"/"});
+
+    bp2::ext::snapshot snap;
+    const std::vector<bp2::pid_type> pids = {proc.id(), bp2::current_pid(), -1};
+    snap.update(pids);
+    BOOST_REQUIRE_EQUAL(snap.size(), 3u);
+
+    auto e = snap[0];
+    BOOST_CHECK(!e.error);
+    BOOST_CHECK_EQUAL(e.pid, proc.id());
+    BOOST_CHECK_EQUAL(e.exe, pth.string());
+    BOOST_CHECK_EQUAL(e.cwd, "/");
+    std::vector<std::string> cmd, env;
+    for (auto c : e.cmd)
+        cmd.emplace_back(c.c_str());
+    BOOST_REQUIRE_EQUAL(cmd.size(), args.size() + 1u);
+    BOOST_CHECK(std::equal(args.begin(), args.end(), cmd.begin() + 1));
+    for (auto kv : e.env)
+        env.emplace_back(kv.c_str());
+    BOOST_CHECK((env == std::vector<std::string>{"FOO=42", "BAR=FOO"}));
+
+    e = snap[1];
+    BOOST_CHECK(!e.error);
+    BOOST_CHECK_EQUAL(e.cwd, bp2::filesystem::current_path().string());
+    BOOST_CHECK_EQUAL(e.exe, bp2::ext::exe(bp2::current_pid()).string());
+
+    e = snap[2];
+    BOOST_CHECK(e.error);
+    BOOST_CHECK(e.cmd.empty());
+    BOOST_CHECK(e.exe.empty());
+
+    // only the requested fields
+    snap.update(pids.data(), 1u, bp2::ext::snapshot::exe);
+    BOOST_REQUIRE_EQUAL(snap.size(), 1u);
+    BOOST_CHECK((*snap.begin()).cmd.empty());
+    BOOST_CHECK_EQUAL((*snap.begin()).exe, pth.string());
+
+    proc.terminate();
+    proc.wait();
+}
+
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -22,12 +22,35 @@
 #include <boost/process/v2/execute.hpp>
 #include <boost/process/v2/stdio.hpp>
 #include <boost/process/v2/bind_launcher.hpp>
+#include <boost/process/v2/launch_scheduler.hpp>
+#include <boost/process/v2/wait_any.hpp>
 
 #if defined(BOOST_PROCESS_V2_WINDOWS)
 #include <boost/process/v2/windows/creation_flags.hpp>
 #include <boost/process/v2/windows/show_window.hpp>
 #endif
 
+#if defined(BOOST_PROCESS_V2_POSIX)
+#include <boost/process/v2/cached_execute.hpp>
+#include <boost/process/v2/posix/fork_safety.hpp>
+#include <boost/process/v2/posix/jobserver.hpp>
+#include <boost/process/v2/posix/launch_record.hpp>
+#include <boost/process/v2/posix/response_file.hpp>
+#include <boost/process/v2/run.hpp>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__)
+#include <boost/process/v2/child_monitor.hpp>
+#include <boost/process/v2/compact_process.hpp>
+#include <boost/process/v2/process_event_monitor.hpp>
+#include <boost/process/v2/process_watcher.hpp>
+#include <boost/process/v2/posix/fork_regions.hpp>
+#include <boost/process/v2/posix/shm_channel.hpp>
+#include <sys/mman.h>
+#endif
+
 #include <boost/test/unit_test.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/buffer.hpp>
@@ -42,7 +65,11 @@
 #include <boost/asio/write.hpp>
 #include <boost/asio/writable_pipe.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <iterator>
 #include <thread>
 
 namespace bpv = boost::process::v2;
@@ -118,6 +145,47 @@ BOOST_AUTO_TEST_CASE(exit_code_async)
     BOOST_CHECK_EQUAL(called, 7);
 }
 
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+BOOST_AUTO_TEST_CASE(resource_usage)
+{
+    using boost::unit_test::framework::master_test_suite;
+    const auto pth =  master_test_suite().argv[1];
+
+    boost::asio::io_context ctx;
+
+    // a loaded machine might give the spinning child little cpu time, but never none.
+    auto cpu_time_us = [](const struct rusage & usage)
+    {
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000l
+              + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    };
+
+    bpv::process proc(ctx, pth, {"spin", "100"});
+    BOOST_CHECK_EQUAL(proc.resource_usage().ru_maxrss, 0);
+    BOOST_CHECK_EQUAL(proc.wait(), 0);
+    const auto & ru = proc.resource_usage();
+    BOOST_CHECK_GT(ru.ru_maxrss, 0);
+    BOOST_CHECK_GT(cpu_time_us(ru), 0l);
+
+    bool called = false;
+    bpv::process proc2(ctx, pth, {"spin", "100"});
+    proc2.async_wait(bpv::with_resource_usage,
+                     [&](bpv::error_code ec, int code, struct rusage usage)
+                     {
+                        called = true;
+                        BOOST_CHECK_MESSAGE(!ec, ec.message());
+                        BOOST_CHECK_EQUAL(code, 0);
+                        BOOST_CHECK_GT(usage.ru_maxrss, 0);
+                        BOOST_CHECK_GT(cpu_time_us(usage), 0l);
+                     });
+    ctx.run();
+    BOOST_CHECK(called);
+    BOOST_CHECK_GT(proc2.resource_usage().ru_maxrss, 0);
+}
+
+#endif
+
 
 BOOST_AUTO_TEST_CASE(terminate)
 {
@@ -330,6 +398,1007 @@ BOOST_AUTO_TEST_CASE(echo_file)
   BOOST_CHECK_MESSAGE(proc.exit_code() == 0, proc.exit_code());
 }
 
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+BOOST_AUTO_TEST_CASE(echo_buffer)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+
+  asio::readable_pipe rp{ctx};
+  asio::writable_pipe wp{ctx};
+  asio::connect_pipe(rp, wp);
+
+  std::string test_data(100000, 'x');
+  for (std::size_t i = 0u; i < test_data.size(); i++)
+    test_data[i] = static_cast<char>('a' + (i % 26));
+
+  bpv::process proc(ctx, pth, {"echo"}, bpv::process_stdio{/*.in=*/asio::buffer(test_data), /*.out=*/wp, /*.err*/{}});
+  wp.close();
+
+  std::string out;
+  bpv::error_code ec;
+
+  auto sz = asio::read(rp, asio::dynamic_buffer(out),  ec);
+  while (ec == asio::error::interrupted)
+      sz += asio::read(rp, asio::dynamic_buffer(out),  ec);
+
+  BOOST_CHECK_EQUAL(sz, test_data.size());
+  BOOST_CHECK_MESSAGE((ec == asio::error::broken_pipe) || (ec == asio::error::eof), ec.message());
+  BOOST_CHECK(out == test_data);
+
+  proc.wait();
+  BOOST_CHECK_MESSAGE(proc.exit_code() == 0, proc.exit_code());
+}
+
+BOOST_AUTO_TEST_CASE(echo_file_region)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+
+  auto p = bpv::filesystem::temp_directory_path() / "asio-test-region.txt";
+  {
+    std::ofstream ofs{p.string()};
+    ofs << "header|some ~~ test ~~ data|trailer";
+    BOOST_CHECK(ofs);
+  }
+
+  auto run = [&](bpv::file_region region)
+  {
+    asio::readable_pipe rp{ctx};
+    asio::writable_pipe wp{ctx};
+    asio::connect_pipe(rp, wp);
+
+    bpv::process proc(ctx, pth, {"echo"}, bpv::process_stdio{/*.in=*/region, /*.out=*/wp, /*.err*/{}});
+    wp.close();
+
+    std::string out;
+    bpv::error_code ec;
+    asio::read(rp, asio::dynamic_buffer(out),  ec);
+    while (ec == asio::error::interrupted)
+      asio::read(rp, asio::dynamic_buffer(out),  ec);
+
+    proc.wait();
+    BOOST_CHECK_MESSAGE(proc.exit_code() == 0, proc.exit_code());
+    return out;
+  };
+
+  BOOST_CHECK_EQUAL(run(bpv::file_region{p, 7u, 20u}), "some ~~ test ~~ data");
+  BOOST_CHECK_EQUAL(run(bpv::file_region{p, 28u}), "trailer");
+  BOOST_CHECK_THROW(run(bpv::file_region{p / "not-a-file"}), bpv::system_error);
+}
+
+BOOST_AUTO_TEST_CASE(launch_trace)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  bpv::posix::launch_histograms stats;
+  bpv::posix::default_launcher launcher;
+  launcher.tracer = &stats;
+
+  for (int i = 0; i < 5; i++)
+  {
+    auto proc = launcher(ctx, pth, std::vector<std::string>{"exit-code", "0"});
+    BOOST_CHECK_EQUAL(proc.wait(), 0);
+  }
+  bpv::error_code ec;
+  launcher(ctx, ec, "/does/not/exist", std::vector<std::string>{});
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(ENOENT, bpv::system_category()));
+
+  auto snap = stats.snapshot();
+  BOOST_CHECK_EQUAL(snap.failures, 1u);
+  for (auto phase : {bpv::posix::launch_phase::fork, bpv::posix::launch_phase::handshake,
+                     bpv::posix::launch_phase::close_fds, bpv::posix::launch_phase::total})
+  {
+    auto & h = snap[phase];
+    BOOST_CHECK_EQUAL(h.count, 6u);
+    BOOST_CHECK_LE(h.min, h.percentile(50.));
+    BOOST_CHECK_LE(h.percentile(50.), h.max);
+    BOOST_CHECK(!h.buckets.empty());
+  }
+  // the handshake covers everything after the fork
+  BOOST_CHECK_GE(snap[bpv::posix::launch_phase::total].max, snap[bpv::posix::launch_phase::handshake].max);
+
+  stats.reset();
+  BOOST_CHECK_EQUAL(stats.snapshot()[bpv::posix::launch_phase::total].count, 0u);
+
+  // without a tracer the launcher records nothing.
+  launcher.tracer = nullptr;
+  launcher(ctx, pth, std::vector<std::string>{"exit-code", "0"}).wait();
+  BOOST_CHECK_EQUAL(stats.snapshot()[bpv::posix::launch_phase::total].count, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram_buckets)
+{
+  bpv::posix::latency_histogram h;
+  for (std::uint64_t v : {3u, 16u, 33u, 1000u, 1000u, 123456789u})
+    h.record(v);
+
+  auto snap = h.snapshot();
+  BOOST_CHECK_EQUAL(snap.count, 6u);
+  BOOST_CHECK_EQUAL(snap.min, 3u);
+  BOOST_CHECK_EQUAL(snap.max, 123456789u);
+  BOOST_CHECK_EQUAL(snap.sum, 3u + 16u + 33u + 2000u + 123456789u);
+  BOOST_REQUIRE_EQUAL(snap.buckets.size(), 5u);
+  // small values are exact, larger ones within 1/16th.
+  BOOST_CHECK_EQUAL(snap.buckets[0].lower, 3u);
+  BOOST_CHECK_EQUAL(snap.buckets[0].upper, 3u);
+  BOOST_CHECK_EQUAL(snap.buckets[2].lower, 32u);
+  BOOST_CHECK_EQUAL(snap.buckets[2].upper, 33u);
+  BOOST_CHECK_EQUAL(snap.buckets[3].count, 2u);
+  BOOST_CHECK_LE(snap.buckets[3].lower, 1000u);
+  BOOST_CHECK_GE(snap.buckets[3].upper, 1000u);
+  BOOST_CHECK_LT(snap.buckets[3].upper - snap.buckets[3].lower, 1000u / 16u);
+  BOOST_CHECK_EQUAL(snap.percentile(50.), snap.buckets[2].upper);
+  BOOST_CHECK_EQUAL(snap.percentile(100.), 123456789u);
+}
+
+BOOST_AUTO_TEST_CASE(executable_handle)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  bpv::posix::default_launcher launcher;
+
+  bpv::posix::executable_handle exe{pth};
+  BOOST_CHECK(exe.is_open());
+  BOOST_CHECK_EQUAL(exe.path(), pth);
+  exe.prefetch();
+  for (int i = 0; i < 3; i++)
+    BOOST_CHECK_EQUAL(launcher(ctx, exe, std::vector<std::string>{"exit-code", std::to_string(i)}).wait(), i);
+
+  // the descriptor keeps the executable alive.
+  const auto copy = bpv::filesystem::temp_directory_path() /
+                    ("boost-process-exe-handle-" + std::to_string(bpv::current_pid()));
+  bpv::filesystem::copy_file(pth, copy, bpv::filesystem::copy_options::overwrite_existing);
+  bpv::posix::executable_handle moved{copy};
+  bpv::filesystem::remove(copy);
+  BOOST_CHECK_EQUAL(launcher(ctx, moved, std::vector<std::string>{"exit-code", "42"}).wait(), 42);
+
+  bpv::error_code ec;
+  bpv::posix::executable_handle missing{"/does/not/exist", ec};
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(ENOENT, bpv::system_category()));
+  BOOST_CHECK(!missing.is_open());
+
+  bpv::posix::executable_cache cache;
+  auto & h = cache.get(pth);
+  BOOST_CHECK_EQUAL(&h, &cache.get(pth));
+  BOOST_CHECK_EQUAL(cache.size(), 1u);
+  BOOST_CHECK_EQUAL(launcher(ctx, h, std::vector<std::string>{"exit-code", "7"}).wait(), 7);
+  BOOST_CHECK_THROW(cache.get("/does/not/exist"), bpv::system_error);
+  BOOST_CHECK_EQUAL(cache.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(jobserver)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  bpv::posix::detail::jobserver_auth auth;
+  BOOST_CHECK(bpv::posix::detail::parse_jobserver_auth(" -j4 --jobserver-auth=3,4", auth));
+  BOOST_CHECK_EQUAL(auth.read_fd, 3);
+  BOOST_CHECK_EQUAL(auth.write_fd, 4);
+  BOOST_CHECK(bpv::posix::detail::parse_jobserver_auth("k -j --jobserver-fds=5,6", auth));
+  BOOST_CHECK_EQUAL(auth.read_fd, 5);
+  BOOST_CHECK(bpv::posix::detail::parse_jobserver_auth("--jobserver-auth=fifo:/tmp/GMfifo1", auth));
+  BOOST_CHECK_EQUAL(auth.fifo, "/tmp/GMfifo1");
+  BOOST_CHECK(!bpv::posix::detail::parse_jobserver_auth("-j --jobserver-auth=-2,-2", auth));
+  BOOST_CHECK(!bpv::posix::detail::parse_jobserver_auth("k -- X=--jobserver-auth=3,4", auth));
+  BOOST_CHECK_EQUAL(bpv::posix::detail::jobserver_makeflags("ks -j4 --jobserver-auth=3,4 -- X=1", 8, 5, 6),
+                    "-ks -j8 --jobserver-auth=5,6 -- X=1");
+
+  // more tokens than a pipe holds by default either fit after growing it or fail, but never block.
+  {
+    bpv::error_code ec;
+    int rfd = -1, wfd = -1;
+    bpv::posix::detail::create_jobserver(1u << 22, rfd, wfd, ec);
+    if (ec)
+      BOOST_CHECK_EQUAL(ec, bpv::error_code(EINVAL, bpv::system_category()));
+    else
+    {
+      BOOST_CHECK_EQUAL(::fcntl(wfd, F_GETFL) & O_NONBLOCK, 0);
+      ::close(rfd);
+      ::close(wfd);
+    }
+  }
+
+  asio::io_context ctx;
+  // the io_context stops whenever it runs out of work.
+  auto run = [&]
+  {
+    ctx.restart();
+    ctx.run_for(std::chrono::milliseconds(50));
+  };
+  auto acquire = [&](bpv::posix::jobserver & js, std::vector<bpv::posix::jobserver::token> & tokens)
+  {
+    js.async_acquire(
+        [&](bpv::error_code ec, bpv::posix::jobserver::token tk)
+        {
+          BOOST_CHECK_MESSAGE(!ec, ec.message());
+          tokens.push_back(std::move(tk));
+        });
+  };
+
+  // the test might be run by make.
+  ::unsetenv("MAKEFLAGS");
+  bpv::posix::jobserver server{ctx, 2u};
+  BOOST_CHECK(server.is_server());
+  const auto makeflags = bpv::posix::detail::jobserver_makeflags("", 2u, server.inherit().read_fd,
+                                                                 server.inherit().write_fd);
+  std::vector<bpv::posix::jobserver::token> tokens;
+  for (int i = 0; i < 3; i++)
+    acquire(server, tokens);
+  run();
+  BOOST_REQUIRE_EQUAL(tokens.size(), 2u);
+  BOOST_CHECK(tokens[0].implicit());
+  BOOST_CHECK(!tokens[1].implicit());
+
+  // the implicit token gets passed on to the waiting acquisition.
+  tokens[0].release();
+  run();
+  BOOST_REQUIRE_EQUAL(tokens.size(), 3u);
+  BOOST_CHECK(tokens[2]);
+
+  // a client connecting through MAKEFLAGS shares the tokens.
+  BOOST_REQUIRE_EQUAL(::setenv("MAKEFLAGS", makeflags.c_str(), 1), 0);
+  bpv::posix::jobserver client{ctx};
+  ::unsetenv("MAKEFLAGS");
+  BOOST_CHECK(client.is_shared());
+  BOOST_CHECK(!client.is_server());
+  std::vector<bpv::posix::jobserver::token> client_tokens;
+  acquire(client, client_tokens);
+  acquire(client, client_tokens);
+  run();
+  BOOST_REQUIRE_EQUAL(client_tokens.size(), 1u);
+  BOOST_CHECK(client_tokens[0].implicit());
+  tokens.clear();
+  run();
+  BOOST_CHECK_EQUAL(client_tokens.size(), 2u);
+  client_tokens.clear();
+
+  // the subprocess gets the pipe & MAKEFLAGS.
+  asio::readable_pipe rp{ctx};
+  asio::writable_pipe wp{ctx};
+  asio::connect_pipe(rp, wp);
+  bpv::process proc(ctx, pth, {"print-env", "MAKEFLAGS"},
+                    bpv::process_stdio{/*in*/{},/*out*/wp, /*err*/ nullptr}, server.inherit());
+  wp.close();
+  std::string out;
+  bpv::error_code ec;
+  asio::read(rp, asio::dynamic_buffer(out), ec);
+  BOOST_CHECK_EQUAL(proc.wait(), 0);
+  BOOST_CHECK_EQUAL(out, makeflags);
+
+  int exit_code = -1;
+  server.async_execute(pth, {"exit-code", "3"}, [&](bpv::error_code ec, int code)
+                       {
+                         BOOST_CHECK_MESSAGE(!ec, ec.message());
+                         exit_code = code;
+                       });
+  ctx.restart();
+  ctx.run_for(std::chrono::seconds(5));
+  BOOST_CHECK_EQUAL(exit_code, 3);
+
+  // without a jobserver, only the implicit token is available.
+  bpv::posix::jobserver serial{ctx};
+  BOOST_CHECK(!serial.is_shared());
+  std::vector<bpv::posix::jobserver::token> serial_tokens;
+  acquire(serial, serial_tokens);
+  acquire(serial, serial_tokens);
+  run();
+  BOOST_REQUIRE_EQUAL(serial_tokens.size(), 1u);
+  serial_tokens[0].release();
+  run();
+  BOOST_CHECK_EQUAL(serial_tokens.size(), 2u);
+
+  bpv::error_code cancelled;
+  serial.async_acquire([&](bpv::error_code ec, bpv::posix::jobserver::token) {cancelled = ec;});
+  serial.cancel();
+  run();
+  BOOST_CHECK_EQUAL(cancelled, asio::error::operation_aborted);
+}
+
+BOOST_AUTO_TEST_CASE(response_file)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+
+  auto run = [&](bpv::posix::response_file & rsp, std::initializer_list<bpv::string_view> args)
+  {
+    asio::readable_pipe rp{ctx};
+    asio::writable_pipe wp{ctx};
+    asio::connect_pipe(rp, wp);
+
+    bpv::process proc(ctx, pth, args, bpv::process_stdio{/*in*/{},/*out*/wp, /*err*/ nullptr}, rsp);
+    wp.close();
+
+    std::string out;
+    bpv::error_code ec;
+    asio::read(rp, asio::dynamic_buffer(out), ec);
+    BOOST_CHECK_EQUAL(proc.wait(), 0);
+    return out;
+  };
+
+  // the target prints the content of the response file it gets.
+  bpv::posix::response_file always{0u};
+  BOOST_CHECK_EQUAL(run(always, {"print-args", "foo bar", "", "back\\slash"}),
+                    "print-args\nfoo\\ bar\n\"\"\nback\\\\slash\n");
+  BOOST_CHECK(always.used());
+
+  bpv::posix::response_file large;
+  BOOST_CHECK_EQUAL(run(large, {"exit-code", "0"}), "");
+  BOOST_CHECK(!large.used());
+
+  // too long for a single argument on linux, which would fail with E2BIG.
+  const std::string huge(200000u, 'x');
+  BOOST_CHECK_EQUAL(run(large, {"print-args", huge}), "print-args\n" + huge + "\n");
+  BOOST_CHECK(large.used());
+}
+
+BOOST_AUTO_TEST_CASE(cached_execute)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  const auto dir = bpv::filesystem::temp_directory_path() / "boost-process-cached-execute";
+  bpv::filesystem::remove_all(dir);
+  bpv::execution_cache cache{dir, 1u << 20};
+
+  bpv::execution_inputs in;
+  in.stdin_data = "some input";
+  auto res = bpv::cached_execute(cache, pth, {"echo"}, in);
+  BOOST_CHECK(!res.cached);
+  BOOST_CHECK_EQUAL(res.exit_code, 0);
+  BOOST_CHECK_EQUAL(res.out, "some input");
+
+  res = bpv::cached_execute(cache, pth, {"echo"}, in);
+  BOOST_CHECK(res.cached);
+  BOOST_CHECK_EQUAL(res.exit_code, 0);
+  BOOST_CHECK_EQUAL(res.out, "some input");
+
+  // different stdin, different key.
+  in.stdin_data = "other input";
+  res = bpv::cached_execute(cache, pth, {"echo"}, in);
+  BOOST_CHECK(!res.cached);
+  BOOST_CHECK_EQUAL(res.out, "other input");
+
+  BOOST_CHECK_EQUAL(bpv::cached_execute(cache, pth, {"exit-code", "3"}).exit_code, 3);
+  res = bpv::cached_execute(cache, pth, {"exit-code", "3"});
+  BOOST_CHECK(res.cached);
+  BOOST_CHECK_EQUAL(res.exit_code, 3);
+
+  auto stats = cache.statistics();
+  BOOST_CHECK_EQUAL(stats.hits, 2u);
+  BOOST_CHECK_EQUAL(stats.misses, 3u);
+  BOOST_CHECK_EQUAL(stats.stores, 3u);
+  BOOST_CHECK_EQUAL(stats.entries, 3u);
+  BOOST_CHECK_GT(stats.size, 0u);
+
+  // the results survive the cache object.
+  bpv::execution_cache reopened{dir, 1u << 20};
+  BOOST_CHECK_EQUAL(reopened.statistics().entries, 3u);
+  BOOST_CHECK(bpv::cached_execute(reopened, pth, {"exit-code", "3"}).cached);
+
+  // the least recently used results get evicted. The entries were written within milliseconds,
+  // which a filesystem with coarse timestamps can't order, so make the "some input" result the oldest.
+  for (auto & entry : bpv::filesystem::directory_iterator(dir))
+  {
+    std::ifstream f{entry.path().string(), std::ios::binary};
+    const std::string content{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+    timespec times[2] = {{0, UTIME_OMIT}, {content.find("some input") != std::string::npos ? 1000 : 2000, 0}};
+    BOOST_CHECK_EQUAL(::utimensat(AT_FDCWD, entry.path().c_str(), times, 0), 0);
+  }
+  bpv::execution_cache small{dir, stats.size - 1u};
+  BOOST_CHECK_EQUAL(small.statistics().evictions, 1u);
+  BOOST_CHECK(bpv::cached_execute(small, pth, {"exit-code", "3"}).cached);
+  BOOST_CHECK(bpv::cached_execute(small, pth, {"echo"}, in).cached);
+  in.stdin_data = "some input";
+  BOOST_CHECK(!bpv::cached_execute(small, pth, {"echo"}, in).cached);
+
+  // killed by a signal, so the result isn't deterministic & doesn't get stored.
+  BOOST_CHECK(!bpv::cached_execute(small, pth, {"abort"}).cached);
+  BOOST_CHECK(!bpv::cached_execute(small, pth, {"abort"}).cached);
+
+  // corrupt the sizes of the remaining entries, so that their sum wraps around to the file size.
+  for (auto & entry : bpv::filesystem::directory_iterator(dir))
+  {
+    std::fstream f{entry.path().string(), std::ios::in | std::ios::out | std::ios::binary};
+    std::uint64_t sizes[3]; // key, out & err, after the magic & the exit code.
+    f.seekg(16);
+    f.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+    sizes[2] += sizes[1] + 4096u;
+    sizes[1] = static_cast<std::uint64_t>(-4096);
+    f.seekp(16);
+    f.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+  }
+  res = bpv::cached_execute(small, pth, {"echo"}, in);
+  BOOST_CHECK(!res.cached);
+  BOOST_CHECK_EQUAL(res.out, "some input");
+  BOOST_CHECK(bpv::cached_execute(small, pth, {"echo"}, in).cached);
+
+  bpv::error_code ec;
+  small.clear(ec);
+  BOOST_CHECK(!ec);
+  BOOST_CHECK_EQUAL(small.statistics().entries, 0u);
+  bpv::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(run)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  auto res = bpv::run(pth, {"echo"}, "some input");
+  BOOST_CHECK_EQUAL(res.exit_code, 0);
+  BOOST_CHECK_EQUAL(res.out, "some input");
+  BOOST_CHECK_EQUAL(res.err, "");
+
+  BOOST_CHECK_EQUAL(bpv::run(pth, {"exit-code", "42"}).exit_code, 42);
+
+  // far more than fits into the pipes, so the target blocks on stdout & stderr in turns.
+  std::string data(4u << 20, 'x');
+  for (std::size_t i = 0u; i < data.size(); i += 997u)
+    data[i] = static_cast<char>('a' + i % 26u);
+
+  bpv::runner rn;
+  res = {};
+  rn.run(pth, {"echo-both"}, data, res);
+  BOOST_CHECK_EQUAL(res.exit_code, 0);
+  BOOST_CHECK(res.out == data);
+  BOOST_CHECK(res.err == data);
+
+  // the target doesn't read stdin, which mustn't raise SIGPIPE.
+  rn.run(pth, {"exit-code", "3"}, data, res);
+  BOOST_CHECK_EQUAL(res.exit_code, 3);
+  BOOST_CHECK(res.out.empty());
+  sigset_t pending;
+  BOOST_CHECK_EQUAL(::sigpending(&pending), 0);
+  BOOST_CHECK(!::sigismember(&pending, SIGPIPE));
+
+  // a SIGPIPE that was pending before doesn't get discarded.
+  sigset_t set, previous;
+  sigemptyset(&set);
+  sigaddset(&set, SIGPIPE);
+  BOOST_REQUIRE_EQUAL(::pthread_sigmask(SIG_BLOCK, &set, &previous), 0);
+  ::raise(SIGPIPE);
+  rn.run(pth, {"exit-code", "3"}, data, res);
+  BOOST_CHECK_EQUAL(res.exit_code, 3);
+  BOOST_CHECK_EQUAL(::sigpending(&pending), 0);
+  BOOST_CHECK(::sigismember(&pending, SIGPIPE));
+  int sig;
+  ::sigwait(&set, &sig);
+  ::pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+  bpv::error_code ec;
+  res = bpv::run("/does/not/exist", {}, "", ec);
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(ENOENT, bpv::system_category()));
+}
+
+BOOST_AUTO_TEST_CASE(launch_record)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  const auto file = bpv::filesystem::temp_directory_path() /
+                    ("boost-process-launch-record-" + std::to_string(bpv::current_pid()) + ".bin");
+  asio::io_context ctx;
+  {
+    bpv::posix::launch_recorder recorder{file};
+    bpv::posix::recording_launcher<> launcher{recorder};
+    const std::vector<std::string> env{"FOO=bar"};
+
+    auto proc = launcher(ctx, pth, std::vector<std::string>{"sleep", "50"},
+                         bpv::process_environment{env});
+    proc.wait();
+    recorder.record_exit(proc);
+
+    bpv::error_code ec;
+    launcher(ctx, ec, "/send/more/cops", std::vector<std::string>{});
+    BOOST_CHECK(ec);
+
+    // the exit doesn't get recorded.
+    launcher(ctx, pth, std::vector<std::string>{"exit-code", "0"}).wait();
+    BOOST_CHECK_EQUAL(recorder.launches(), 3u);
+  }
+
+  auto records = bpv::posix::read_launch_records(file);
+  BOOST_REQUIRE_EQUAL(records.size(), 3u);
+  BOOST_CHECK_EQUAL(records[0].executable, pth);
+  BOOST_CHECK_EQUAL(records[0].argc, 3u);
+  BOOST_CHECK_EQUAL(records[0].argv_bytes, std::strlen(pth) + 1u + sizeof("sleep") + sizeof("50"));
+  BOOST_CHECK_EQUAL(records[0].envc, 1u);
+  BOOST_CHECK_EQUAL(records[0].env_bytes, sizeof("FOO=bar"));
+  BOOST_REQUIRE_EQUAL(records[0].initializers.size(), 1u);
+  BOOST_CHECK_NE(records[0].initializers[0].find("process_environment"), std::string::npos);
+  BOOST_CHECK_GT(records[0].pid, 0);
+  BOOST_CHECK_EQUAL(records[0].error, 0);
+  BOOST_CHECK_GE(records[0].exit_time - records[0].start, 50000000u);
+  BOOST_CHECK_NE(records[1].error, 0);
+  BOOST_CHECK_EQUAL(records[1].exit_time, 0u);
+  BOOST_CHECK_EQUAL(records[2].error, 0);
+  BOOST_CHECK_EQUAL(records[2].exit_time, 0u);
+
+  bpv::posix::replay_options opts;
+  opts.speed = 10.;
+  opts.stub_args = {"replay-stub"};
+  auto report = bpv::posix::replay_launches(records, pth, opts);
+  BOOST_CHECK_EQUAL(report.launches, 2u);
+  BOOST_CHECK_EQUAL(report.failures, 0u);
+  BOOST_CHECK_EQUAL(report.skipped, 1u);
+  BOOST_CHECK_EQUAL(report.unmatched, 1u);
+  BOOST_CHECK_EQUAL(report.launch_latency.count, 2u);
+  BOOST_CHECK_EQUAL(report.reaper_lag.count, 2u);
+  BOOST_CHECK_EQUAL(report.phases[bpv::posix::launch_phase::total].count, 2u);
+  // the stub lives a tenth of the recorded lifetime.
+  BOOST_CHECK_GE(report.elapsed, 5000000u);
+  bpv::filesystem::remove(file);
+}
+
+#if defined(BOOST_PROCESS_V2_CHECK_FORK_SAFETY)
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define BOOST_PROCESS_V2_TEST_SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#define BOOST_PROCESS_V2_TEST_SANITIZED 1
+#endif
+#endif
+
+// allocates in the child, which can deadlock if another thread held the allocator lock during the fork.
+struct allocating_initializer
+{
+  template<typename Launcher>
+  bpv::error_code on_exec_setup(Launcher &, const bpv::filesystem::path &, const char * const * (&))
+  {
+    void * volatile p = std::malloc(64);
+    std::free(p);
+    return bpv::error_code{};
+  }
+};
+
+// only makes async-signal-safe calls.
+struct dup_initializer
+{
+  template<typename Launcher>
+  bpv::error_code on_exec_setup(Launcher &, const bpv::filesystem::path &, const char * const * (&))
+  {
+    if (::dup2(STDERR_FILENO, STDERR_FILENO) == -1)
+      return bpv::error_code(errno, bpv::system_category());
+    return bpv::error_code{};
+  }
+};
+
+bpv::posix::fork_safety_report last_fork_safety_report;
+
+BOOST_AUTO_TEST_CASE(fork_safety)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  auto previous = bpv::posix::set_fork_safety_handler(
+      [](const bpv::posix::fork_safety_report & report)
+      {
+        last_fork_safety_report = report;
+      });
+
+  asio::io_context ctx;
+  bpv::error_code ec;
+  auto safe = bpv::default_process_launcher()(ctx, ec, pth, std::vector<std::string>{"exit-code", "0"}, dup_initializer{});
+  BOOST_REQUIRE_MESSAGE(!ec, ec.message());
+  BOOST_CHECK(!last_fork_safety_report.violated());
+  // at least the dup2 & the execve.
+  BOOST_CHECK_GE(last_fork_safety_report.syscalls, 2u);
+  BOOST_CHECK_EQUAL(safe.wait(), 0);
+
+  // the allocator isn't interposed in sanitized builds.
+#if !defined(BOOST_PROCESS_V2_TEST_SANITIZED)
+  bpv::default_process_launcher()(ctx, ec, pth, std::vector<std::string>{"exit-code", "0"},
+                                  dup_initializer{}, allocating_initializer{});
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(EDEADLK, bpv::system_category()));
+  BOOST_REQUIRE(last_fork_safety_report.violated());
+  BOOST_CHECK_EQUAL(last_fork_safety_report.call, std::string("malloc"));
+  BOOST_CHECK_NE(std::string(last_fork_safety_report.offender).find("allocating_initializer"), std::string::npos);
+  BOOST_CHECK_GE(last_fork_safety_report.allocations, 1u);
+#endif
+
+  bpv::posix::set_fork_safety_handler(previous);
+}
+
+#endif
+
+#endif
+
+#if defined(__linux__)
+
+// fails the launch in the child, unless the first byte of the region got wiped by the fork.
+struct fork_region_probe
+{
+  const char * mem;
+
+  template<typename Launcher>
+  bpv::error_code on_exec_setup(Launcher &, const bpv::filesystem::path &, const char * const * (&))
+  {
+    if (*mem == '\0')
+      return bpv::error_code{};
+    // the launcher reports errno.
+    errno = EFAULT;
+    return bpv::error_code(EFAULT, bpv::system_category());
+  }
+};
+
+BOOST_AUTO_TEST_CASE(fork_regions)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  const std::size_t size = 16384u * page;
+  auto mem = static_cast<char*>(::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  BOOST_REQUIRE(mem != MAP_FAILED);
+  std::memset(mem, 0xAB, size);
+
+  bpv::posix::fork_region_registry registry;
+  bpv::error_code ec;
+  registry.add(mem + 1, page, bpv::posix::fork_region_mode::wipe_on_fork, ec);
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(EINVAL, bpv::system_category()));
+  ec.clear();
+  registry.add(mem, page, bpv::posix::fork_region_mode::wipe_on_fork, ec);
+  BOOST_REQUIRE_MESSAGE(!ec, ec.message());
+  registry.add(mem, page, bpv::posix::fork_region_mode::wipe_on_fork, ec);
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(EINVAL, bpv::system_category()));
+  ec.clear();
+  BOOST_CHECK_EQUAL(registry.size(), 1u);
+  BOOST_CHECK_EQUAL(registry.bytes(), page);
+  BOOST_CHECK(registry.overlaps(mem + page - 1u, 1u));
+  BOOST_CHECK(!registry.overlaps(mem + page, 1u));
+
+  bpv::posix::default_launcher launcher;
+  launcher(ctx, ec, pth, std::vector<std::string>{"exit-code", "0"}, fork_region_probe{mem});
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(EFAULT, bpv::system_category()));
+
+  ec.clear();
+  auto proc = launcher(ctx, ec, pth, std::vector<std::string>{"exit-code", "3"},
+                       bpv::posix::exclude_fork_regions{registry}, fork_region_probe{mem});
+  BOOST_CHECK_MESSAGE(!ec, ec.message());
+  BOOST_CHECK_EQUAL(proc.wait(), 3);
+  BOOST_CHECK(!registry.excluded());
+  BOOST_CHECK_EQUAL(static_cast<unsigned char>(*mem), 0xABu);
+
+  // what the child reads must not be excluded.
+  std::strcpy(mem, "exit-code");
+  launcher(ctx, ec, pth, std::vector<bpv::cstring_ref>{mem, "0"}, bpv::posix::exclude_fork_regions{registry});
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(EFAULT, bpv::system_category()));
+  BOOST_CHECK(!registry.excluded());
+  registry.remove(mem);
+  BOOST_CHECK_EQUAL(registry.size(), 0u);
+
+  // the page tables of a large heap don't need to be copied.
+  bpv::posix::launch_histograms with, without;
+  launcher.tracer = &without;
+  for (int i = 0; i < 5; i++)
+    launcher(ctx, pth, std::vector<std::string>{"exit-code", "0"}).wait();
+  registry.add(mem, size);
+  launcher.tracer = &with;
+  for (int i = 0; i < 5; i++)
+    launcher(ctx, pth, std::vector<std::string>{"exit-code", "0"}, bpv::posix::exclude_fork_regions{registry}).wait();
+  BOOST_TEST_MESSAGE("fork of " << (size >> 20) << "MiB: "
+                     << without.snapshot()[bpv::posix::launch_phase::fork].mean() << "ns, excluded: "
+                     << with.snapshot()[bpv::posix::launch_phase::fork].mean() << "ns");
+  BOOST_CHECK_EQUAL(with.snapshot().failures, 0u);
+  registry.remove(mem);
+  ::munmap(mem, size);
+}
+
+BOOST_AUTO_TEST_CASE(shm_channel_echo)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  // a small ring, so both sides need to wait for each other.
+  bpv::posix::shm_channel ch{ctx, 4096u};
+  BOOST_CHECK_EQUAL(ch.capacity(), 4096u);
+
+  bpv::process proc(ctx, pth, {"shm-echo"}, bpv::posix::bind_shm_channel(3, ch));
+
+  std::string in(100000u, ' ');
+  for (std::size_t i = 0u; i < in.size(); i++)
+    in[i] = static_cast<char>('a' + (i * 7) % 26);
+
+  std::string out(in.size(), '\0');
+  asio::async_write(ch, asio::buffer(in),
+                    [&](bpv::error_code ec, std::size_t n)
+                    {
+                      BOOST_CHECK(!ec);
+                      BOOST_CHECK_EQUAL(n, in.size());
+                      ch.shutdown_write();
+                    });
+  asio::async_read(ch, asio::buffer(out),
+                   [&](bpv::error_code ec, std::size_t n)
+                   {
+                     BOOST_CHECK(!ec);
+                     BOOST_CHECK_EQUAL(n, in.size());
+                   });
+  ctx.run();
+  BOOST_CHECK(in == out);
+
+  // the subprocess closes the channel after it got the eof.
+  char c;
+  bpv::error_code ec;
+  BOOST_CHECK_EQUAL(ch.read_some(asio::buffer(&c, 1u), ec), 0u);
+  BOOST_CHECK_EQUAL(ec, asio::error::eof);
+
+  proc.wait();
+  BOOST_CHECK_MESSAGE(proc.exit_code() == 0, proc.exit_code());
+  ch.close();
+  BOOST_CHECK(!ch.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(child_monitor)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  bpv::child_monitor mon{ctx, std::chrono::milliseconds(20)};
+
+  bpv::process spin(ctx, pth, {"spin", "300"});
+  bpv::process idle(ctx, pth, {"sleep", "300"});
+  mon.add(spin);
+  mon.add(idle);
+  mon.add(spin.id());
+  BOOST_CHECK_EQUAL(mon.size(), 2u);
+
+  std::size_t samples = 0u, above_rss = 0u;
+  std::vector<bpv::pid_type> busy;
+  mon.on_sample([&](const bpv::process_sample & s)
+                {
+                  samples++;
+                  BOOST_CHECK(s.pid == spin.id() || s.pid == idle.id());
+                  BOOST_CHECK_GT(s.resident_memory, 0u);
+                  BOOST_CHECK_GE(s.cpu_usage, 0.);
+                });
+  mon.on_resident_memory_above(1u, [&](const bpv::process_sample &) {above_rss++;});
+  mon.on_cpu_usage_above(0.5, [&](const bpv::process_sample & s) {busy.push_back(s.pid);});
+  mon.start();
+
+  int done = 0;
+  auto on_exit = [&](bpv::error_code ec, int code)
+                 {
+                   BOOST_CHECK_MESSAGE(!ec, ec.message());
+                   BOOST_CHECK_EQUAL(code, 0);
+                   if (++done == 2)
+                     mon.stop();
+                 };
+  spin.async_wait(on_exit);
+  idle.async_wait(on_exit);
+  ctx.run();
+
+  BOOST_CHECK_GT(samples, 2u);
+  // edge triggered, so once per process
+  BOOST_CHECK_EQUAL(above_rss, 2u);
+  BOOST_CHECK(!busy.empty());
+  BOOST_CHECK(std::find(busy.begin(), busy.end(), idle.id()) == busy.end());
+
+  // reaped processes get removed on the next sample.
+  mon.sample();
+  BOOST_CHECK_EQUAL(mon.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(process_event_monitor)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  bpv::process_event_monitor mon{ctx, std::chrono::milliseconds(20)};
+  std::vector<bpv::process_event> events;
+  mon.on_event([&](const bpv::process_event & ev)
+               {
+                 if (ev.parent == bpv::current_pid())
+                   events.push_back(ev);
+               });
+  mon.start();
+  BOOST_TEST_MESSAGE("process_event_monitor polling: " << mon.is_polling());
+  BOOST_CHECK(mon.running());
+  BOOST_CHECK(mon.contains(bpv::current_pid()));
+  BOOST_CHECK_EQUAL(mon.parent_pid(bpv::current_pid()), ::getppid());
+
+  auto run_until = [&](std::function<bool()> pred)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!pred() && std::chrono::steady_clock::now() < deadline)
+    {
+      ctx.restart();
+      ctx.run_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+  };
+
+  bpv::process proc(ctx, pth, {"sleep", "200"});
+  const auto pid = proc.id();
+  BOOST_REQUIRE(run_until([&]{return mon.contains(pid);}));
+  BOOST_CHECK_EQUAL(mon.parent_pid(pid), bpv::current_pid());
+  const auto children = mon.child_pids(bpv::current_pid());
+  BOOST_CHECK(std::find(children.begin(), children.end(), pid) != children.end());
+
+  BOOST_CHECK_EQUAL(proc.wait(), 0);
+  BOOST_CHECK(run_until([&]{return !mon.contains(pid);}));
+  const auto after = mon.child_pids(bpv::current_pid());
+  BOOST_CHECK(std::find(after.begin(), after.end(), pid) == after.end());
+
+  auto find = [&](bpv::process_event::kind_t kind)
+  {
+    return std::find_if(events.begin(), events.end(),
+                        [&](const bpv::process_event & ev) {return ev.kind == kind && ev.pid == pid;});
+  };
+  BOOST_CHECK(find(bpv::process_event::fork) != events.end());
+  auto ex = find(bpv::process_event::exit);
+  BOOST_REQUIRE(ex != events.end());
+  if (!mon.is_polling())
+    BOOST_CHECK_EQUAL(ex->exit_status, 0);
+
+  mon.stop();
+  BOOST_CHECK(!mon.running());
+}
+
+#if defined(BOOST_PROCESS_V2_PIDFD_OPEN)
+BOOST_AUTO_TEST_CASE(compact_process_reaper)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  BOOST_CHECK_LE(sizeof(bpv::compact_process), 16u);
+
+  asio::io_context ctx;
+  bpv::process_reaper reaper{ctx};
+
+  std::vector<bpv::compact_process> children;
+  for (auto i = 0; i < 32; i++)
+    children.emplace_back(bpv::process(ctx, pth, {"exit-code", std::to_string(i)}));
+  children.emplace_back(bpv::process(ctx, pth, {"sleep", "10000"}));
+
+  std::vector<int> codes(children.size(), -1);
+  bool killed = false;
+  for (std::size_t i = 0u; i < children.size(); i++)
+    reaper.async_wait(children[i],
+                      [&, i](bpv::error_code ec, int code)
+                      {
+                        BOOST_CHECK_MESSAGE(!ec, ec.message());
+                        codes[i] = code;
+                        if (i == 31u)
+                          children.back().terminate(ec);
+                        killed = killed || (i == children.size() - 1u);
+                      });
+  // the sleeping one at least, the others might have exited already.
+  BOOST_CHECK_GE(reaper.size(), 1u);
+  ctx.run();
+
+  BOOST_CHECK(killed);
+  BOOST_CHECK_EQUAL(reaper.size(), 0u);
+  for (auto i = 0; i < 32; i++)
+  {
+    BOOST_CHECK_EQUAL(codes[i], i);
+    BOOST_CHECK(!children[i].running());
+  }
+
+  bpv::compact_process late{bpv::process(ctx, pth, {"sleep", "10000"})};
+  bpv::error_code ec;
+  reaper.async_wait(late, [&](bpv::error_code ec_, int) {ec = ec_;});
+  reaper.cancel();
+  ctx.restart();
+  ctx.run();
+  BOOST_CHECK_EQUAL(ec, asio::error::operation_aborted);
+  late.terminate();
+
+  bpv::process_reaper moved{std::move(reaper)};
+  BOOST_CHECK_EQUAL(reaper.size(), 0u);
+  BOOST_CHECK_EQUAL(moved.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(process_watcher)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  bpv::process_watcher watcher{ctx};
+
+  bpv::process exiting(ctx, pth, {"exit-code", "42"});
+  bpv::process sleeping(ctx, pth, {"sleep", "10000"});
+
+  int exit_code = -2, killed_code = -2;
+  bpv::error_code ec;
+  watcher.async_wait(exiting.id(),
+                     [&](bpv::error_code ec_, int code)
+                     {
+                       BOOST_CHECK_MESSAGE(!ec_, ec_.message());
+                       exit_code = code;
+                       watcher.send_signal(sleeping.id(), SIGKILL);
+                     });
+  watcher.async_wait(sleeping.id(),
+                     [&](bpv::error_code ec_, int code)
+                     {
+                       BOOST_CHECK_MESSAGE(!ec_, ec_.message());
+                       killed_code = code;
+                     });
+  BOOST_CHECK_EQUAL(watcher.size(), 2u);
+  ctx.run();
+
+  BOOST_CHECK_EQUAL(exit_code, 42);
+  BOOST_CHECK_EQUAL(killed_code, SIGKILL);
+  // dropped once the exit got delivered.
+  BOOST_CHECK(!watcher.watching(exiting.id()));
+  BOOST_CHECK_EQUAL(watcher.size(), 0u);
+
+  // not reaped by the watcher, so an exited child can be watched again & completes right away.
+  exit_code = -2;
+  watcher.async_wait(exiting.id(), [&](bpv::error_code ec_, int code) {ec = ec_; exit_code = code;});
+  ctx.restart();
+  ctx.run();
+  BOOST_CHECK(!ec);
+  BOOST_CHECK_EQUAL(exit_code, 42);
+  BOOST_CHECK_EQUAL(watcher.size(), 0u);
+
+  BOOST_CHECK_EQUAL(exiting.wait(), 42);
+  sleeping.wait();
+
+  // an exit noticed while nobody waited for it stays until a wait delivers it.
+  bpv::process unwaited(ctx, pth, {"exit-code", "7"});
+  bpv::process slow(ctx, pth, {"sleep", "100"});
+  watcher.watch(unwaited.id());
+  watcher.async_wait(slow.id(), [&](bpv::error_code ec_, int) {ec = ec_;});
+  ctx.restart();
+  ctx.run();
+  BOOST_CHECK(!ec);
+  BOOST_CHECK(watcher.exited(unwaited.id()));
+  BOOST_CHECK(watcher.watching(unwaited.id()));
+  watcher.async_wait(unwaited.id(), [&](bpv::error_code ec_, int code) {ec = ec_; exit_code = code;});
+  ctx.restart();
+  ctx.run();
+  BOOST_CHECK(!ec);
+  BOOST_CHECK_EQUAL(exit_code, 7);
+  BOOST_CHECK(!watcher.watching(unwaited.id()));
+  BOOST_CHECK_EQUAL(unwaited.wait(), 7);
+  slow.wait();
+
+  watcher.send_signal(sleeping.id(), SIGKILL, ec);
+  BOOST_CHECK_EQUAL(ec, asio::error::bad_descriptor);
+
+  // the pid of the reaped child is free
+  watcher.watch(exiting.id(), ec);
+  BOOST_CHECK_EQUAL(ec, bpv::error_code(ESRCH, bpv::system_category()));
+  BOOST_CHECK(!watcher.watching(exiting.id()));
+
+  bpv::process late(ctx, pth, {"sleep", "10000"});
+  watcher.async_wait(late.id(), [&](bpv::error_code ec_, int) {ec = ec_;});
+  watcher.unwatch(late.id());
+  ctx.restart();
+  ctx.run();
+  BOOST_CHECK_EQUAL(ec, asio::error::operation_aborted);
+
+  watcher.async_wait(late.id(), [&](bpv::error_code ec_, int) {ec = ec_;});
+  watcher.cancel();
+  ctx.restart();
+  ctx.run();
+  BOOST_CHECK_EQUAL(ec, asio::error::operation_aborted);
+  BOOST_CHECK(watcher.watching(late.id()));
+  late.terminate();
+}
+#endif
+
+#endif
+
 BOOST_AUTO_TEST_CASE(stdio_creates_complementary_pipes)
 {
   using boost::unit_test::framework::master_test_suite;
@@ -567,6 +1636,32 @@ BOOST_AUTO_TEST_CASE(environment)
   BOOST_CHECK_EQUAL(read_env("PATH", bpv::process_environment(bpv::environment::current())), ::getenv("PATH"));
 }
 
+BOOST_AUTO_TEST_CASE(environment_overlay)
+{
+  bpv::environment::overlay ov{{"FOOBAR", "FOO-BAR"}};
+  ov.set("XYZ", "ZYX");
+  ov.unset("XYZ");
+  BOOST_CHECK_EQUAL(ov.size(), 2u);
+
+  // the overlay is reused, so the untouched variables must survive multiple launches.
+  BOOST_CHECK_EQUAL("FOO-BAR", read_env("FOOBAR", ov));
+  BOOST_CHECK_EQUAL(read_env("PATH", ov), ::getenv("PATH"));
+
+  ov.set("FOOBAR", "BAR-FOO");
+  BOOST_CHECK_EQUAL("BAR-FOO", read_env("FOOBAR", ov));
+
+  std::string path = ::getenv("PATH");
+  path += static_cast<char>(bpv::environment::delimiter);
+  path += "/bar/foo";
+  ov.set("PATH", path);
+  BOOST_CHECK_EQUAL(path, read_env("PATH", ov));
+
+  ov.reset("PATH");
+  BOOST_CHECK_EQUAL(read_env("PATH", ov), ::getenv("PATH"));
+  ov.clear();
+  BOOST_CHECK(ov.empty());
+}
+
 BOOST_AUTO_TEST_CASE(exit_code_as_error)
 {
   using boost::unit_test::framework::master_test_suite;
@@ -648,6 +1743,151 @@ BOOST_AUTO_TEST_CASE(bind_launcher)
   BOOST_CHECK_MESSAGE(proc.exit_code() == 0, proc.exit_code() << " from " << proc.native_exit_code());
 }
 
+BOOST_AUTO_TEST_CASE(launch_scheduler_limit)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  bpv::launch_scheduler sched{ctx, 2u};
+
+  int done = 0;
+  std::size_t max_running = 0u;
+  for (int i = 0; i < 6; i++)
+    sched.async_execute(i % 2, 0, pth, {"sleep", "50"},
+                        [&](bpv::error_code ec, int code)
+                        {
+                          BOOST_CHECK_MESSAGE(!ec, ec.message());
+                          BOOST_CHECK_EQUAL(code, 0);
+                          max_running = (std::max)(max_running, sched.running());
+                          done++;
+                        });
+  BOOST_CHECK_EQUAL(sched.queued(), 4u);
+  BOOST_CHECK_EQUAL(sched.running(), 2u);
+
+  ctx.run();
+  BOOST_CHECK_EQUAL(done, 6);
+  BOOST_CHECK_LE(max_running, 2u);
+  BOOST_CHECK_EQUAL(sched.running(), 0u);
+  BOOST_CHECK_EQUAL(sched.queued(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(launch_scheduler_order)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  bpv::launch_scheduler sched{ctx, 1u};
+
+  std::vector<std::size_t> order;
+  auto launch = [&](std::size_t tenant, int priority)
+  {
+    sched.async_launch(
+        tenant, priority, pth, {"sleep", "10"},
+        [&, tenant](bpv::error_code ec, bpv::process proc, bpv::launch_scheduler::slot sl)
+        {
+          BOOST_CHECK_MESSAGE(!ec, ec.message());
+          BOOST_CHECK(sl);
+          order.push_back(tenant);
+          // the slot gets released once the process exited
+          auto p = std::make_shared<bpv::process>(std::move(proc));
+          auto s = std::make_shared<bpv::launch_scheduler::slot>(std::move(sl));
+          p->async_wait([p, s](bpv::error_code, int) {s->release();});
+        });
+  };
+
+  launch(9, 0);
+  launch(1, 0);
+  launch(1, 0);
+  launch(1, 0);
+  launch(2, 0);
+  launch(3, 5);
+  ctx.run();
+
+  // priority first, then tenant 1 & 2 take turns, despite tenant 1 having queued more.
+  const std::vector<std::size_t> expected = {9, 3, 1, 2, 1, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(launch_scheduler_cancel)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  bpv::launch_scheduler sched{ctx, 1u};
+
+  bpv::error_code first, second;
+  sched.async_execute(0, 0, pth, {"sleep", "50"}, [&](bpv::error_code ec, int) {first = ec;});
+  sched.async_execute(0, 0, pth, {"sleep", "50"}, [&](bpv::error_code ec, int) {second = ec;});
+  BOOST_CHECK_EQUAL(sched.queued(), 1u);
+  sched.cancel();
+  BOOST_CHECK_EQUAL(sched.queued(), 0u);
+  ctx.run();
+
+  BOOST_CHECK_MESSAGE(!first, first.message());
+  BOOST_CHECK_EQUAL(second, asio::error::operation_aborted);
+  BOOST_CHECK_EQUAL(sched.running(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(wait_any_all)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  std::vector<bpv::process> procs;
+  procs.emplace_back(ctx, pth, std::vector<std::string>{"sleep", "500"});
+  procs.emplace_back(ctx, pth, std::vector<std::string>{"sleep", "500"});
+  procs.emplace_back(ctx, pth, std::vector<std::string>{"exit-code", "42"});
+  procs.emplace_back(ctx, pth, std::vector<std::string>{"sleep", "500"});
+
+  auto res = bpv::wait_any(procs);
+  BOOST_CHECK_EQUAL(res.index, 2u);
+  BOOST_CHECK_EQUAL(res.exit_code, 42);
+  // already exited, so it's reported again right away.
+  res = bpv::wait_any(procs);
+  BOOST_CHECK_EQUAL(res.index, 2u);
+
+  bpv::wait_all(procs);
+  for (auto & p : procs)
+    BOOST_CHECK(!p.running());
+  BOOST_CHECK_EQUAL(procs[0].exit_code(), 0);
+
+  std::vector<bpv::process> none;
+  bpv::error_code ec;
+  bpv::wait_any(none, ec);
+  BOOST_CHECK(ec);
+}
+
+#if !defined(BOOST_PROCESS_V2_WINDOWS)
+BOOST_AUTO_TEST_CASE(async_wait_any)
+{
+  using boost::unit_test::framework::master_test_suite;
+  const auto pth =  master_test_suite().argv[1];
+
+  asio::io_context ctx;
+  std::vector<bpv::process> procs;
+  for (auto i = 0; i < 16; i++)
+    procs.emplace_back(ctx, pth, std::vector<std::string>{"sleep", i == 11 ? "50" : "500"});
+
+  bool done = false;
+  bpv::async_wait_any(procs,
+                      [&](bpv::error_code ec, std::size_t index, int exit_code)
+                      {
+                        BOOST_CHECK_MESSAGE(!ec, ec.message());
+                        BOOST_CHECK_EQUAL(index, 11u);
+                        BOOST_CHECK_EQUAL(exit_code, 0);
+                        BOOST_CHECK(!procs[index].running());
+                        done = true;
+                      });
+  ctx.run();
+  BOOST_CHECK(done);
+  bpv::wait_all(procs);
+}
+#endif
+
 BOOST_AUTO_TEST_CASE(async_interrupt)
 {
     if (!can_interrupt)
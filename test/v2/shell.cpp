@@ -15,6 +15,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <cstdlib>
+#include <string>
+
 #if defined(BOOST_PROCESS_V2_WINDOWS)
     #define STR(Value) L##Value
     #define STR_VIEW(Value) boost::process::v2::wcstring_ref(STR(Value))
@@ -53,4 +56,75 @@ BOOST_AUTO_TEST_CASE(test_shell_parser)
 
     proc.wait();
     BOOST_CHECK_EQUAL(proc.exit_code(), 0);
-}
\ No newline at end of file
+}
+#if defined(BOOST_PROCESS_V2_POSIX)
+
+BOOST_AUTO_TEST_CASE(test_shell_quoting)
+{
+    using boost::process::v2::shell;
+    namespace bpv = boost::process::v2;
+
+    auto sh = shell(R"(  a\ b 'c "d' "e \"f\" \$g 'h'" i''j "" \
+k$HOME~ )");
+    BOOST_REQUIRE_EQUAL(sh.argc(), 6);
+    BOOST_CHECK(sh.argv()[0] == STR_VIEW("a b"));
+    BOOST_CHECK(sh.argv()[1] == STR_VIEW("c \"d"));
+    BOOST_CHECK(sh.argv()[2] == STR_VIEW("e \"f\" $g 'h'"));
+    BOOST_CHECK(sh.argv()[3] == STR_VIEW("ij"));
+    BOOST_CHECK(sh.argv()[4] == STR_VIEW(""));
+    BOOST_CHECK(sh.argv()[5] == STR_VIEW("k$HOME~"));
+    BOOST_CHECK(sh.argv()[6] == nullptr);
+
+    BOOST_CHECK(shell("").empty());
+    BOOST_CHECK(shell(" \t ").empty());
+    // no globbing
+    BOOST_CHECK(shell("*").argv()[0] == STR_VIEW("*"));
+
+    BOOST_CHECK_THROW(shell("foo 'bar"), bpv::system_error);
+    BOOST_CHECK_THROW(shell("foo bar\\"), bpv::system_error);
+    BOOST_CHECK_THROW(shell("foo | bar"), bpv::system_error);
+    BOOST_CHECK_THROW(shell("foo; bar"), bpv::system_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_shell_expand)
+{
+    using boost::process::v2::shell;
+    using boost::process::v2::shell_expand;
+    namespace bpv = boost::process::v2;
+
+    // restores HOME at the end, even if a check throws.
+    struct home_guard
+    {
+        const bool was_set = ::getenv("HOME") != nullptr;
+        const std::string value = was_set ? ::getenv("HOME") : "";
+
+        ~home_guard()
+        {
+            if (was_set)
+                ::setenv("HOME", value.c_str(), 1);
+            else
+                ::unsetenv("HOME");
+        }
+    } home;
+
+    ::setenv("BOOST_PROCESS_SHELL_TEST", "foo bar", 1);
+    ::setenv("HOME", "/home/test", 1);
+    ::unsetenv("BOOST_PROCESS_SHELL_UNSET");
+
+    auto sh = shell("x$BOOST_PROCESS_SHELL_TEST \"${BOOST_PROCESS_SHELL_TEST}y\" '$HOME' ~/z a$BOOST_PROCESS_SHELL_UNSET $1", shell_expand);
+    BOOST_REQUIRE_EQUAL(sh.argc(), 6);
+    BOOST_CHECK(sh.argv()[0] == STR_VIEW("xfoo bar"));
+    BOOST_CHECK(sh.argv()[1] == STR_VIEW("foo bary"));
+    BOOST_CHECK(sh.argv()[2] == STR_VIEW("$HOME"));
+    BOOST_CHECK(sh.argv()[3] == STR_VIEW("/home/test/z"));
+    BOOST_CHECK(sh.argv()[4] == STR_VIEW("a"));
+    BOOST_CHECK(sh.argv()[5] == STR_VIEW("$1"));
+
+    BOOST_CHECK(shell("~no-such-user-for-sure", shell_expand).argv()[0] == STR_VIEW("~no-such-user-for-sure"));
+
+    BOOST_CHECK_THROW(shell("echo $(id)", shell_expand), bpv::system_error);
+    BOOST_CHECK_THROW(shell("echo `id`", shell_expand), bpv::system_error);
+    BOOST_CHECK_THROW(shell("echo ${HOME", shell_expand), bpv::system_error);
+}
+
+#endif
@@ -1,3 +1,5 @@
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <thread>
@@ -12,18 +14,36 @@ extern char **environ;
 #include <unistd.h>
 #endif
 
+#if defined(BOOST_PROCESS_V2_POSIX)
+#include <boost/process/v2/posix/launch_record.hpp>
+#endif
+
+#if defined(__linux__)
+#include <boost/process/v2/posix/shm_channel_client.hpp>
+#endif
+
 
 int main(int argc, char * argv[])
 {
     std::string mode = argv[1];
     if (mode == "exit-code")
         return std::stoi(argv[2]);
+    else if (mode == "abort")
+        std::abort();
     else if (mode == "sleep")
     {
         const auto delay = std::chrono::milliseconds(std::stoi(argv[2]));
         std::this_thread::sleep_for(delay);
         return 0;
     }
+    else if (mode == "spin")
+    {
+        const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::stoi(argv[2]));
+        volatile unsigned long counter = 0u;
+        while (std::chrono::steady_clock::now() < end)
+            counter = counter + 1u;
+        return 0;
+    }
     else if (mode == "print-args")
         for (auto i = 0; i < argc; i++)
         {
@@ -34,6 +54,16 @@ int main(int argc, char * argv[])
         }
     else if (mode == "echo")
         std::cout << std::cin.rdbuf();
+    else if (mode == "echo-both")
+    {
+        // copies stdin to stdout & stderr in turns, blocking on whichever pipe is full.
+        char buf[4096];
+        while (std::cin.read(buf, sizeof(buf)) || std::cin.gcount() > 0)
+        {
+            std::cout.write(buf, std::cin.gcount()).flush();
+            std::cerr.write(buf, std::cin.gcount()).flush();
+        }
+    }
     else if (mode == "print-cwd")
     {
 #if defined(BOOST_PROCESS_V2_WINDOWS)
@@ -135,6 +165,23 @@ int main(int argc, char * argv[])
       tim_p = nullptr;
       return ec ? EXIT_SUCCESS : 33;
     }
+#if defined(__linux__)
+    else if (mode == "shm-echo")
+    {
+      boost::process::v2::posix::shm_channel_client cl{3};
+      char buf[1000];
+      boost::system::error_code ec;
+      while (auto n = cl.read_some(buf, sizeof(buf), ec))
+        cl.write(buf, n);
+      return ec == boost::asio::error::eof ? EXIT_SUCCESS : 35;
+    }
+#endif
+#if defined(BOOST_PROCESS_V2_POSIX)
+    else if (mode == "replay-stub")
+      return boost::process::v2::posix::replay_stub_main(argc - 1, argv + 1);
+#endif
+    else if (mode[0] == '@')
+        std::cout << std::ifstream(mode.substr(1)).rdbuf();
     else
         return 34;
 
@@ -13,6 +13,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+
 BOOST_AUTO_TEST_CASE(test_codecvt)
 {
     struct end_t
@@ -37,4 +39,62 @@ BOOST_AUTO_TEST_CASE(test_codecvt)
     BOOST_CHECK(boost::process::v2::detail::conv_string<wchar_t>( in,    end( in  )) == win_t);
     BOOST_CHECK(boost::process::v2::detail::conv_string<char>   (win_t,  end(win_t)) ==  in  );
 
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(test_codecvt_ascii_runs)
+{
+    namespace bpd = boost::process::v2::detail;
+
+    // a single non-ascii character at every position, so each kernel tail & boundary gets hit.
+    for (std::size_t len = 0u; len < 70u; len++)
+    {
+        std::string ascii(len, 'x');
+        std::wstring wascii(len, L'x');
+        BOOST_CHECK(bpd::conv_string<wchar_t>(ascii.data(), ascii.size()) == wascii);
+        BOOST_CHECK(bpd::conv_string<char>(wascii.data(), wascii.size()) == ascii);
+
+        for (std::size_t pos = 0u; pos < len; pos++)
+        {
+            std::string in = ascii;
+            in.replace(pos, 1u, "\320\240");
+            std::wstring win = wascii;
+            win[pos] = L'\u0420';
+
+            BOOST_CHECK(bpd::conv_string<wchar_t>(in.data(), in.size()) == win);
+            BOOST_CHECK(bpd::conv_string<char>(win.data(), win.size()) == in);
+        }
+    }
+
+    std::string in;
+    for (int i = 0; i < 4096; i++)
+        in += (i % 100 == 99) ? "\342\202\254" : std::string(1, static_cast<char>('a' + i % 26));
+    const auto win = bpd::conv_string<wchar_t>(in.data(), in.size());
+    BOOST_CHECK_EQUAL(std::count(win.begin(), win.end(), L'\u20AC'), 40);
+    BOOST_CHECK(bpd::conv_string<char>(win.data(), win.size()) == in);
+
+    boost::process::v2::error_code ec;
+    BOOST_CHECK_EQUAL(bpd::size_as_wide(in.data(), in.size(), ec), win.size());
+    BOOST_CHECK_EQUAL(bpd::size_as_utf8(win.data(), win.size(), ec), in.size());
+    BOOST_CHECK(!ec);
+}
+
+BOOST_AUTO_TEST_CASE(test_codecvt_convert_some)
+{
+    namespace bpd = boost::process::v2::detail;
+    const wchar_t  * win = L"abcdefghijklmnopqrstuvwxyz-\u0420\u0418\u0411\u0410";
+
+    char buf[28];
+    const wchar_t * next = nullptr;
+    boost::process::v2::error_code ec;
+    auto n = bpd::convert_some_to_utf8(win, std::char_traits<wchar_t>::length(win), buf, sizeof(buf), next, ec);
+#if !defined(BOOST_PROCESS_V2_WINDOWS)
+    BOOST_CHECK_EQUAL(n, 27u);
+    BOOST_CHECK(next == win + 27);
+    BOOST_CHECK(std::string(buf, n) == "abcdefghijklmnopqrstuvwxyz-");
+#else
+    BOOST_CHECK_EQUAL(n, 0u);
+    BOOST_CHECK(next == win);
+#endif
+    BOOST_CHECK(ec == boost::process::v2::error_code(boost::process::v2::error::insufficient_buffer,
+                                                      boost::process::v2::error::get_utf8_category()));
+}